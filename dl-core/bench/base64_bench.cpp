@@ -0,0 +1,130 @@
+// Base64 codec benchmark
+//
+// Compares the vectorized codec against the previous implementation (scalar
+// encoder, OpenSSL BIO decoder) on signature-sized and token-sized inputs,
+// and checks that both produce the same output.
+
+#include "decentrilicense/base64.hpp"
+#include <openssl/bio.h>
+#include <openssl/evp.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using decentrilicense::Base64;
+
+namespace {
+
+// Previous CryptoUtils::base64_encode
+std::string legacy_encode(const std::vector<uint8_t>& data) {
+    static const std::string chars =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string ret;
+    int i = 0;
+    uint8_t a3[3];
+    uint8_t a4[4];
+    for (uint8_t byte : data) {
+        a3[i++] = byte;
+        if (i == 3) {
+            a4[0] = (a3[0] & 0xfc) >> 2;
+            a4[1] = ((a3[0] & 0x03) << 4) + ((a3[1] & 0xf0) >> 4);
+            a4[2] = ((a3[1] & 0x0f) << 2) + ((a3[2] & 0xc0) >> 6);
+            a4[3] = a3[2] & 0x3f;
+            for (i = 0; i < 4; i++) {
+                ret += chars[a4[i]];
+            }
+            i = 0;
+        }
+    }
+    if (i) {
+        for (int j = i; j < 3; j++) {
+            a3[j] = '\0';
+        }
+        a4[0] = (a3[0] & 0xfc) >> 2;
+        a4[1] = ((a3[0] & 0x03) << 4) + ((a3[1] & 0xf0) >> 4);
+        a4[2] = ((a3[1] & 0x0f) << 2) + ((a3[2] & 0xc0) >> 6);
+        for (int j = 0; j < i + 1; j++) {
+            ret += chars[a4[j]];
+        }
+        while (i++ < 3) {
+            ret += '=';
+        }
+    }
+    return ret;
+}
+
+// Previous CryptoUtils::base64_decode
+std::vector<uint8_t> legacy_decode(const std::string& encoded) {
+    int decode_len = static_cast<int>(encoded.size() * 3 / 4 + 1);
+    std::vector<uint8_t> buffer(decode_len);
+    BIO* bio = BIO_new_mem_buf(encoded.c_str(), static_cast<int>(encoded.size()));
+    BIO* b64 = BIO_new(BIO_f_base64());
+    bio = BIO_push(b64, bio);
+    BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);
+    int len = BIO_read(bio, buffer.data(), decode_len);
+    BIO_free_all(bio);
+    if (len < 0) {
+        return std::vector<uint8_t>();
+    }
+    buffer.resize(len);
+    return buffer;
+}
+
+template <typename Fn>
+double run(size_t iterations, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        fn();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t total_bytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (64u << 20);
+
+    std::printf("implementation: %s\n", Base64::implementation());
+    std::printf("%8s  %14s %14s  %14s %14s\n", "size", "legacy enc", "simd enc", "legacy dec", "simd dec");
+
+    std::mt19937 rng(42);
+    for (size_t size : {32, 64, 256, 1024, 4096, 65536}) {
+        std::vector<uint8_t> data(size);
+        for (auto& b : data) {
+            b = static_cast<uint8_t>(rng());
+        }
+
+        const std::string expected = legacy_encode(data);
+        if (Base64::encode(data.data(), data.size()) != expected ||
+            Base64::decode(expected) != legacy_decode(expected) ||
+            Base64::decode(expected) != data) {
+            std::fprintf(stderr, "output mismatch at size %zu\n", size);
+            return 1;
+        }
+
+        const size_t iterations = std::max<size_t>(1, total_bytes / size);
+        const double mb = static_cast<double>(iterations * size) / (1 << 20);
+
+        std::string out(Base64::encoded_length(size), '\0');
+        std::vector<uint8_t> decoded(Base64::decoded_max_length(expected.size()));
+        size_t decoded_size = 0;
+        volatile size_t sink = 0;
+
+        double t_legacy_enc = run(iterations, [&]() { sink += legacy_encode(data).size(); });
+        double t_simd_enc = run(iterations, [&]() { sink += Base64::encode(data.data(), size, &out[0]); });
+        double t_legacy_dec = run(iterations, [&]() { sink += legacy_decode(expected).size(); });
+        double t_simd_dec = run(iterations, [&]() {
+            Base64::decode(expected, decoded.data(), &decoded_size);
+            sink += decoded_size;
+        });
+
+        std::printf("%8zu  %9.1f MB/s %9.1f MB/s  %9.1f MB/s %9.1f MB/s\n", size,
+                    mb / t_legacy_enc, mb / t_simd_enc, mb / t_legacy_dec, mb / t_simd_dec);
+    }
+    return 0;
+}
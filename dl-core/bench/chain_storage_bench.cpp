@@ -0,0 +1,240 @@
+// State chain storage benchmark
+//
+// Record checksum throughput (the previous per-byte sum against CRC-32C,
+// portable and hardware) on token-sized and larger inputs, then the cost of
+// writing, appending to and reading back a chain log in a temporary
+// directory. Appends are compared with the previous appendState, which
+// reopened the log and rewrote current_state.json and chain_meta.json on
+// every call. Finally, appends per second at each durability level, from one
+// thread and from several appending to the same chain (group commit batches
+// their flushes), and the same chain split into segments: loading from the
+// latest snapshot and compacting the sealed segments.
+
+#include "state_chain_storage.h"
+#include "decentrilicense/crc32c.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace decentrilicense;
+
+namespace {
+
+// Previous chain log record checksum
+uint32_t legacy_checksum(const uint8_t* data, size_t size) {
+    uint32_t checksum = 0;
+    for (size_t i = 0; i < size; ++i) {
+        checksum += data[i];
+    }
+    return checksum;
+}
+
+// Previous StateChainStorage::appendState: reopen and append to the log, then
+// rewrite current_state.json and chain_meta.json through temporary files
+void write_file_atomically(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+}
+
+void legacy_append(const std::filesystem::path& dir, const Token& state) {
+    const std::vector<uint8_t> token_data = state.to_binary();
+    {
+        std::ofstream log(dir / "chain_log.bin", std::ios::binary | std::ios::app);
+        const uint32_t length = static_cast<uint32_t>(token_data.size());
+        const uint32_t checksum = legacy_checksum(token_data.data(), token_data.size());
+        log.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        log.write(reinterpret_cast<const char*>(token_data.data()), token_data.size());
+        log.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    }
+    write_file_atomically(dir / "current_state.json", token_data);
+
+    std::ifstream meta_in(dir / "chain_meta.json");
+    std::stringstream json;
+    json << meta_in.rdbuf();
+    const std::string meta = json.str();
+    const size_t pos = meta.find("\"total_states\":");
+    const uint64_t total = pos == std::string::npos ? 0 : std::stoull(meta.substr(pos + 15));
+    std::ostringstream oss;
+    oss << "{\"version\":1,\"total_states\":" << total + 1 << ",\"last_verification_time\":"
+        << std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count()
+        << ",\"license_id\":\"legacy\"}";
+    const std::string out = oss.str();
+    write_file_atomically(dir / "chain_meta.json", std::vector<uint8_t>(out.begin(), out.end()));
+}
+
+template <typename Fn>
+double run(size_t iterations, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        fn();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+Token make_state(uint64_t index) {
+    Token token{};
+    token.token_id = "3f2a1c9e-4b7d-4e8a-9c1f-2d3e4f5a6b7c";
+    token.alg = SigningAlgorithm::Ed25519;
+    token.license_code = "BENCH-LICENSE";
+    token.license_public_key =
+        "-----BEGIN PUBLIC KEY-----\nMCowBQYDK2VwAyEAGb9ECWmEzf6FQbrBZ9w7lshQhqowtrbLDFw4rXAxZuE=\n"
+        "-----END PUBLIC KEY-----\n";
+    token.signature = std::string(88, 'A');
+    token.state_signature = std::string(88, 'B');
+    token.state_index = index;
+    token.state_payload = "{\"n\":" + std::to_string(index) + "}";
+    return token;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t states = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    const size_t total_bytes = 256u << 20;
+
+    std::printf("crc32c implementation: %s\n", Crc32c::implementation());
+    std::printf("%8s  %14s %14s %14s\n", "size", "byte sum", "crc32c sw", "crc32c");
+
+    std::mt19937 rng(42);
+    for (size_t size : {64, 256, 512, 4096, 65536}) {
+        std::vector<uint8_t> data(size);
+        for (auto& b : data) {
+            b = static_cast<uint8_t>(rng());
+        }
+
+        const size_t iterations = std::max<size_t>(1, total_bytes / size);
+        const double mb = static_cast<double>(iterations * size) / (1 << 20);
+        volatile uint32_t sink = 0;
+
+        double t_sum = run(iterations, [&]() { sink += legacy_checksum(data.data(), size); });
+        double t_portable = run(iterations, [&]() { sink += Crc32c::extend_portable(0, data.data(), size); });
+        double t_crc = run(iterations, [&]() { sink += Crc32c::compute(data.data(), size); });
+
+        std::printf("%8zu  %9.0f MB/s %9.0f MB/s %9.0f MB/s\n", size,
+                    mb / t_sum, mb / t_portable, mb / t_crc);
+    }
+
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / ("dl_chain_storage_bench_" + std::to_string(rng()));
+    StateChainStorage storage(root.string());
+
+    std::vector<Token> chain;
+    chain.reserve(states);
+    for (size_t i = 0; i < states; ++i) {
+        chain.push_back(make_state(i));
+    }
+
+    std::printf("\n%zu states\n", states);
+    double t = run(1, [&]() { storage.saveFullChain("bench", chain); });
+    std::printf("  saveFullChain       %10.1f ms\n", t * 1e3);
+
+    const size_t appends = 1000;
+    const Token next = make_state(chain.size());
+    const fs::path legacy_dir = root / "legacy";
+    fs::create_directories(legacy_dir);
+    {
+        std::ofstream meta(legacy_dir / "chain_meta.json");
+        meta << "{\"version\":1,\"total_states\":0,\"last_verification_time\":0,\"license_id\":\"legacy\"}";
+    }
+    t = run(appends, [&]() { legacy_append(legacy_dir, next); });
+    std::printf("  previous append     %10.1f us (%.0f appends/s)\n", t * 1e6 / appends, appends / t);
+    t = run(appends, [&]() { storage.appendState("bench", next); });
+    std::printf("  appendState         %10.1f us (%.0f appends/s)\n", t * 1e6 / appends, appends / t);
+
+    size_t loaded = 0;
+    t = run(1, [&]() { loaded = storage.loadChain("bench").size(); });
+    std::printf("  loadChain           %10.1f ms (%zu states)\n", t * 1e3, loaded);
+
+    const size_t lookups = 1000;
+    t = run(lookups, [&]() { (void)storage.loadState("bench", rng() % states); });
+    std::printf("  loadState           %10.1f us\n", t * 1e6 / lookups);
+
+    std::unique_ptr<ChainLogReader> reader = storage.openChainReader("bench");
+    size_t bytes = 0;
+    t = run(1, [&]() {
+        for (const ChainStateView& state : *reader) {
+            bytes += state.data.size();
+        }
+    });
+    std::printf("  verify all records  %10.1f ms (%.0f MB/s)\n", t * 1e3,
+                static_cast<double>(bytes) / (1 << 20) / t);
+    reader.reset();
+
+    struct Level {
+        const char* name;
+        ChainDurability level;
+    };
+    const Level levels[] = {
+        {"none", ChainDurability::None},
+        {"os buffered", ChainDurability::OsBuffered},
+        {"sync each record", ChainDurability::SyncEachRecord},
+        {"group commit", ChainDurability::GroupCommit},
+    };
+    const size_t durable_appends = 2000;
+    std::printf("\n%-18s %14s %14s\n", "durability", "1 thread", "8 threads");
+    for (const Level& level : levels) {
+        DurabilityOptions options;
+        options.level = level.level;
+        storage.setDurability(options);
+        std::printf("%-18s", level.name);
+        for (size_t threads : {1, 8}) {
+            const std::string license_id = std::string("durability_") + std::to_string(threads) +
+                                           "_" + std::to_string(static_cast<int>(level.level));
+            storage.saveFullChain(license_id, {make_state(0)});
+            t = run(1, [&]() {
+                std::vector<std::thread> workers;
+                for (size_t i = 0; i < threads; ++i) {
+                    workers.emplace_back([&]() {
+                        for (size_t n = 0; n < durable_appends / threads; ++n) {
+                            storage.appendState(license_id, next);
+                        }
+                    });
+                }
+                for (std::thread& worker : workers) {
+                    worker.join();
+                }
+            });
+            std::printf(" %9.0f /s   ", durable_appends / t);
+        }
+        std::printf("\n");
+    }
+
+    const uint64_t segment_size = 1 << 20;
+    storage.setDurability(DurabilityOptions{});
+    storage.setMaxSegmentSize(segment_size);
+    storage.saveFullChain("segmented", {chain.front()});
+    t = run(1, [&]() {
+        for (size_t i = 1; i < states; ++i) {
+            storage.appendState("segmented", chain[i]);
+        }
+    });
+    std::printf("\n%zu states in %llu KiB segments\n", states, static_cast<unsigned long long>(segment_size >> 10));
+    std::printf("  appendState         %10.1f us (%zu segments sealed)\n", t * 1e6 / (states - 1),
+                storage.listSegments("segmented").size());
+    size_t from_snapshot = 0;
+    t = run(1, [&]() { from_snapshot = storage.loadChain("segmented").size(); });
+    std::printf("  loadChain           %10.1f ms (%zu states from the latest snapshot)\n", t * 1e3, from_snapshot);
+    size_t compacted = 0;
+    t = run(1, [&]() { compacted = storage.compactChain("segmented"); });
+    std::printf("  compactChain        %10.1f ms (%zu segments removed)\n", t * 1e3, compacted);
+
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    return loaded == states + appends ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+// OpenSSL library context benchmark
+//
+// Runs signature verification on 1..16 threads with the process-wide default
+// context, one private context shared by all threads, and a private context
+// per thread (the DL_CRYPTO_CONTEXT_* modes of the C API).
+
+#include "decentrilicense/crypto_utils.hpp"
+#include "crypto_context.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace decentrilicense;
+
+namespace {
+
+enum class Mode { Default, Shared, PerThread };
+
+const char* mode_name(Mode mode) {
+    switch (mode) {
+        case Mode::Default: return "default";
+        case Mode::Shared: return "shared";
+        case Mode::PerThread: return "per-thread";
+    }
+    return "";
+}
+
+struct Fixture {
+    const char* name;
+    std::string public_key;
+    std::string data;
+    std::string signature;
+    bool (*verify)(const std::string&, const std::string&, const std::string&);
+};
+
+// Verifications per second over all threads
+double run(const Fixture& fixture, Mode mode, int threads, int iterations) {
+    std::shared_ptr<CryptoContext> shared;
+    if (mode == Mode::Shared) {
+        shared = CryptoContext::shared();
+    }
+
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> workers;
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            std::unique_ptr<CryptoContext> own;
+            if (mode == Mode::PerThread) {
+                own = std::make_unique<CryptoContext>();
+            }
+            ScopedCryptoContext scope(own ? own.get() : shared.get());
+            for (int i = 0; i < iterations; ++i) {
+                if (!fixture.verify(fixture.data, fixture.signature, fixture.public_key)) {
+                    failed = true;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (failed) {
+        std::fprintf(stderr, "%s verification failed in %s mode\n", fixture.name, mode_name(mode));
+        std::exit(1);
+    }
+    return threads * iterations / seconds;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const std::string data(256, 'x');
+
+    std::vector<Fixture> fixtures;
+#if DECENTRILICENSE_WITH_RSA
+    {
+        auto keys = CryptoUtils::generate_rsa_keypair();
+        fixtures.push_back({"RSA-2048", keys.public_key_pem, data,
+                            CryptoUtils::sign_data(data, keys.private_key_pem),
+                            [](const std::string& d, const std::string& s, const std::string& k) {
+                                return CryptoUtils::verify_signature(d, s, k);
+                            }});
+    }
+#endif
+    {
+        auto keys = CryptoUtils::generate_ed25519_keypair();
+        fixtures.push_back({"Ed25519", keys.public_key_pem, data,
+                            CryptoUtils::sign_ed25519_data(data, keys.private_key_pem),
+                            [](const std::string& d, const std::string& s, const std::string& k) {
+                                return CryptoUtils::verify_ed25519_signature(d, s, k);
+                            }});
+    }
+
+    const Mode modes[] = {Mode::Default, Mode::Shared, Mode::PerThread};
+    for (const auto& fixture : fixtures) {
+        std::printf("%s verifications/s\n", fixture.name);
+        std::printf("%8s  %12s %12s %12s\n", "threads", "default", "shared", "per-thread");
+        for (int threads : {1, 2, 4, 8, 16}) {
+            std::printf("%8d ", threads);
+            for (Mode mode : modes) {
+                std::printf(" %12.0f", run(fixture, mode, threads, iterations));
+            }
+            std::printf("\n");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Multi-buffer SHA-256 benchmark
+//
+// Hashes batches of chain-entry-sized messages with Hasher (one call per
+// message) and with each Sha256Multi kernel the CPU supports, and checks that
+// all of them produce the same digests.
+
+#include "decentrilicense/sha256_multi.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using decentrilicense::Hasher;
+using decentrilicense::Sha256Multi;
+
+namespace {
+
+template <typename Fn>
+double run(size_t iterations, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        fn();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t total_bytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (64u << 20);
+    const size_t batch = 256;
+
+    const std::pair<Sha256Multi::Kernel, const char*> kernels[] = {
+        {Sha256Multi::Kernel::Scalar, "scalar"},
+        {Sha256Multi::Kernel::ShaNi, "sha-ni"},
+        {Sha256Multi::Kernel::Avx2, "avx2"},
+        {Sha256Multi::Kernel::Avx512, "avx512"},
+    };
+
+    std::printf("implementation: %s, %zu messages per batch\n", Sha256Multi::implementation(), batch);
+    std::printf("%8s  %14s", "size", "hasher");
+    for (const auto& kernel : kernels) {
+        std::printf(" %14s", kernel.second);
+    }
+    std::printf("\n");
+
+    std::mt19937 rng(42);
+    for (size_t size : {64, 256, 600, 1024, 4096}) {
+        // Vary lengths a little, as serialized tokens do
+        std::vector<std::string> messages(batch);
+        for (auto& message : messages) {
+            message.resize(size - size / 8 + rng() % (size / 4 + 1));
+            for (auto& c : message) {
+                c = static_cast<char>(rng());
+            }
+        }
+        std::vector<std::string_view> views(messages.begin(), messages.end());
+        size_t batch_bytes = 0;
+        for (const auto& message : messages) {
+            batch_bytes += message.size();
+        }
+
+        std::vector<Sha256Multi::Digest> expected(batch);
+        for (size_t i = 0; i < batch; ++i) {
+            expected[i] = Hasher::digest(Hasher::Algorithm::SHA256, messages[i]);
+        }
+
+        const size_t iterations = std::max<size_t>(1, total_bytes / batch_bytes);
+        const double mb = static_cast<double>(iterations * batch_bytes) / (1 << 20);
+        std::vector<Sha256Multi::Digest> digests(batch);
+        volatile uint8_t sink = 0;
+
+        double t_hasher = run(iterations, [&]() {
+            for (size_t i = 0; i < batch; ++i) {
+                digests[i] = Hasher::digest(Hasher::Algorithm::SHA256, messages[i]);
+            }
+            sink += digests[0][0];
+        });
+        std::printf("%8zu  %9.1f MB/s", size, mb / t_hasher);
+
+        for (const auto& kernel : kernels) {
+            if (!Sha256Multi::supported(kernel.first)) {
+                std::printf(" %14s", "-");
+                continue;
+            }
+            Sha256Multi::digest(views.data(), batch, digests.data(), kernel.first);
+            if (digests != expected) {
+                std::fprintf(stderr, "\ndigest mismatch: %s at size %zu\n", kernel.second, size);
+                return 1;
+            }
+            double t = run(iterations, [&]() {
+                Sha256Multi::digest(views.data(), batch, digests.data(), kernel.first);
+                sink += digests[0][0];
+            });
+            std::printf(" %9.1f MB/s", mb / t);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
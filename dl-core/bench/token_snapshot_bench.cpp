@@ -0,0 +1,170 @@
+// Current-token read contention benchmark
+//
+// 1..64 reader threads query the current token while one writer keeps
+// replacing it with set_token / invalidate_token. Compares TokenManager
+// (lock-free snapshots) with the previous scheme, a mutex guarding a
+// std::optional<Token> that every reader copies. Then times the
+// single-thread cost of is_licensed() against the other status queries.
+
+#include "decentrilicense/token_manager.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace decentrilicense;
+
+namespace {
+
+// The pre-snapshot TokenManager read path
+class LockedToken {
+public:
+    void set(const Token& token) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        token_ = token;
+    }
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        token_.reset();
+    }
+    std::optional<Token> get() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return token_;
+    }
+    TokenStatus status() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!token_.has_value()) {
+            return TokenStatus::NONE;
+        }
+        return token_->is_expired() ? TokenStatus::EXPIRED : TokenStatus::ACTIVE;
+    }
+
+private:
+    std::optional<Token> token_;
+    mutable std::mutex mutex_;
+};
+
+struct Result {
+    double reads_per_second;
+    double writes_per_second;
+};
+
+// Readers alternate between a status query and a token read, as a license
+// check does
+template <typename Read, typename Write>
+Result run(int readers, int milliseconds, Read read, Write write) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> reads{0};
+    uint64_t writes = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < readers; ++t) {
+        threads.emplace_back([&]() {
+            uint64_t local = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                read();
+                ++local;
+            }
+            reads.fetch_add(local);
+        });
+    }
+    std::thread writer([&]() {
+        while (!stop.load(std::memory_order_relaxed)) {
+            write();
+            ++writes;
+        }
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    writer.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return {reads / seconds, writes / seconds};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int milliseconds = argc > 1 ? std::atoi(argv[1]) : 500;
+
+    auto keys = CryptoUtils::generate_ed25519_keypair();
+    TokenManager manager;
+    const Token token = manager.generate_token("device-1", "LICENSE-1", 24, keys.private_key_pem,
+                                               SigningAlgorithm::Ed25519);
+    if (!manager.set_token(token, keys.public_key_pem)) {
+        std::fprintf(stderr, "set_token failed\n");
+        return 1;
+    }
+
+    LockedToken locked;
+    locked.set(token);
+
+    std::printf("reads/s over all reader threads; one writer replacing the token\n");
+    std::printf("%8s  %14s %14s  %14s %14s\n", "readers", "mutex+copy", "writes/s", "snapshot", "writes/s");
+    for (int readers : {1, 2, 4, 8, 16, 32, 64}) {
+        bool flip = false;
+        const Result before = run(
+            readers, milliseconds,
+            [&]() {
+                if (locked.status() == TokenStatus::ACTIVE) {
+                    volatile size_t n = locked.get()->token_id.size();
+                    (void)n;
+                }
+            },
+            [&]() {
+                if ((flip = !flip)) {
+                    locked.set(token);
+                } else {
+                    locked.reset();
+                }
+            });
+
+        const Result after = run(
+            readers, milliseconds,
+            [&]() {
+                if (manager.get_status() == TokenStatus::ACTIVE) {
+                    if (auto snapshot = manager.get_current_token_snapshot()) {
+                        volatile size_t n = snapshot->token_id.size();
+                        (void)n;
+                    }
+                }
+            },
+            [&]() {
+                if ((flip = !flip)) {
+                    manager.set_token(token, keys.public_key_pem);
+                } else {
+                    manager.invalidate_token();
+                }
+            });
+
+        std::printf("%8d  %14.0f %14.0f  %14.0f %14.0f\n", readers, before.reads_per_second,
+                    before.writes_per_second, after.reads_per_second, after.writes_per_second);
+    }
+
+    // Single-thread latency of the hot-path checks
+    manager.set_token(token, keys.public_key_pem);
+    const int calls = 20000000;
+    const auto time_call = [&](const char* name, auto check) {
+        size_t licensed = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; ++i) {
+            licensed += check();
+        }
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-22s %6.2f ns/call (%zu)\n", name, ns / calls, licensed);
+    };
+    std::printf("\n");
+    time_call("is_licensed", [&]() { return manager.is_licensed(); });
+    time_call("get_status", [&]() { return manager.get_status() == TokenStatus::ACTIVE; });
+    time_call("get_current_token", [&]() { return manager.get_current_token().has_value(); });
+    return 0;
+}
@@ -0,0 +1,150 @@
+#ifndef CHAIN_LOG_READER_H
+#define CHAIN_LOG_READER_H
+
+#include "decentrilicense/token_manager.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace decentrilicense {
+
+// Snapshot record a log segment after the first starts with
+struct ChainSnapshot {
+    uint64_t segment = 0;                   // Number of the segment it starts
+    uint8_t previous_sha256[32] = {};       // Digest of the whole previous segment file
+};
+
+// One stored state, pointing into the memory-mapped log
+struct ChainStateView {
+    uint64_t state_index;
+    uint64_t timestamp;             // Unix seconds the state was appended, 0 if unknown
+    std::string_view data;          // Serialized token (binary v2 or legacy JSON)
+
+    /**
+     * Decode the token, see Token::decode
+     */
+    bool decode(Token* token) const { return Token::decode(data, token); }
+};
+
+/**
+ * ChainLogReader - Random access to a stored state chain
+ *
+ * Maps chain_log.bin read-only and locates records through the sidecar
+ * index chain_log.idx (state_index -> offset, length, timestamp), so looking
+ * up one state costs the same in a chain of ten states or of a million and
+ * nothing is deserialized unless asked for. Views point into the mapping
+ * and stay valid for the reader's lifetime.
+ *
+ * A missing, damaged or outdated index is rebuilt (or extended) from the
+ * log when the reader is opened and written back if the directory is
+ * writable. States indexed this way have timestamp 0 when no earlier
+ * timestamp is known.
+ *
+ * The chain is read as of open(); appends made afterwards are not seen.
+ * Each record's checksum (CRC-32C, or the byte sum of legacy records) is
+ * verified when it is accessed. The reader never modifies the log; see
+ * has_torn_tail() for what StateChainStorage repairs.
+ */
+class ChainLogReader {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = ChainStateView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const ChainStateView*;
+        using reference = const ChainStateView&;
+
+        reference operator*() const { return view_; }
+        pointer operator->() const { return &view_; }
+        Iterator& operator++() { advance(position_ + 1); return *this; }
+        bool operator==(const Iterator& other) const { return position_ == other.position_; }
+        bool operator!=(const Iterator& other) const { return position_ != other.position_; }
+
+    private:
+        friend class ChainLogReader;
+        Iterator(const ChainLogReader* reader, size_t position);
+        void advance(size_t position);
+
+        const ChainLogReader* reader_;
+        size_t position_;
+        ChainStateView view_{};
+    };
+
+    /**
+     * Open a chain log and its index
+     * @param log_path Path of chain_log.bin
+     * @param index_path Path of chain_log.idx
+     * @return Reader, or nullptr if the log cannot be opened
+     */
+    static std::unique_ptr<ChainLogReader> open(const std::string& log_path, const std::string& index_path);
+
+    ~ChainLogReader();
+
+    // Non-copyable
+    ChainLogReader(const ChainLogReader&) = delete;
+    ChainLogReader& operator=(const ChainLogReader&) = delete;
+
+    /**
+     * Number of indexed states
+     */
+    size_t size() const;
+
+    /**
+     * Length of the log prefix covered by intact indexed records
+     */
+    uint64_t intact_size() const;
+
+    /**
+     * Whether the log ends in the remains of an interrupted append (a record
+     * cut short, a failing last record or unwritten space) after
+     * intact_size(). Truncating the log to intact_size() then loses nothing
+     * that could be read. False if there is no such tail, or if readable
+     * records follow the damage.
+     */
+    bool has_torn_tail() const;
+
+    /**
+     * Snapshot the log starts with, if it is a segment after the first
+     * Its state is the first one read, at position 0.
+     */
+    std::optional<ChainSnapshot> snapshot() const;
+
+    /**
+     * State by Token::state_index, O(1) for a well-formed chain
+     * @return View, or nullopt if absent or its record is damaged
+     */
+    std::optional<ChainStateView> state(uint64_t state_index) const;
+
+    /**
+     * State by position in the log, O(1)
+     */
+    std::optional<ChainStateView> at(size_t position) const;
+
+    /**
+     * Latest state appended at or before a time, by binary search
+     * @param unix_seconds Time
+     * @return View, or nullopt if every state is newer or the record is damaged
+     */
+    std::optional<ChainStateView> state_at_time(uint64_t unix_seconds) const;
+
+    /**
+     * Lazy iteration in log order; stops before the first damaged record
+     */
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, size()); }
+
+private:
+    struct Impl;
+    explicit ChainLogReader(std::unique_ptr<Impl> impl);
+
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace decentrilicense
+
+#endif // CHAIN_LOG_READER_H
@@ -0,0 +1,88 @@
+#ifndef DECENTRILICENSE_BASE64_HPP
+#define DECENTRILICENSE_BASE64_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace decentrilicense {
+
+/**
+ * Base64 - Vectorized base64 / base64url codec
+ *
+ * The implementation is picked once at startup: AVX2, SSE4.1 or a portable
+ * scalar loop. All paths produce identical output.
+ *
+ * Standard alphabet output is padded with '='. URL alphabet output is
+ * unpadded. The URL decoder accepts padded and unpadded input and both
+ * alphabets, like the original base64url_decode did.
+ *
+ * Decoding is strict: characters outside the alphabet, misplaced padding or
+ * a truncated final group make the whole input invalid. Trailing whitespace
+ * is ignored.
+ *
+ * All functions are thread-safe
+ */
+class Base64 {
+public:
+    enum class Alphabet {
+        Standard,   // A-Z a-z 0-9 + /, padded
+        Url         // A-Z a-z 0-9 - _, unpadded
+    };
+
+    /**
+     * Exact encoded length
+     * @param size Input size in bytes
+     * @param alphabet Output alphabet
+     */
+    static size_t encoded_length(size_t size, Alphabet alphabet = Alphabet::Standard);
+
+    /**
+     * Upper bound of the decoded length, suitable for sizing decode buffers
+     * @param size Encoded size in characters
+     */
+    static size_t decoded_max_length(size_t size);
+
+    /**
+     * Encode into a caller-provided buffer
+     * @param data Input bytes
+     * @param size Input size
+     * @param out Output buffer, at least encoded_length(size, alphabet) bytes
+     * @param alphabet Output alphabet
+     * @return Number of characters written
+     */
+    static size_t encode(const uint8_t* data, size_t size, char* out,
+                         Alphabet alphabet = Alphabet::Standard);
+
+    /**
+     * Decode into a caller-provided buffer
+     * @param in Encoded input
+     * @param out Output buffer, at least decoded_max_length(in.size()) bytes
+     * @param out_size Number of bytes written on success
+     * @param alphabet Input alphabet
+     * @return false if the input is not valid base64
+     */
+    static bool decode(std::string_view in, uint8_t* out, size_t* out_size,
+                       Alphabet alphabet = Alphabet::Standard);
+
+    static std::string encode(const uint8_t* data, size_t size,
+                              Alphabet alphabet = Alphabet::Standard);
+
+    /**
+     * Decode to a new vector
+     * @return Decoded bytes, empty if the input is invalid
+     */
+    static std::vector<uint8_t> decode(std::string_view in,
+                                       Alphabet alphabet = Alphabet::Standard);
+
+    /**
+     * Name of the selected implementation ("avx2", "sse4.1" or "scalar")
+     */
+    static const char* implementation();
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_BASE64_HPP
@@ -0,0 +1,52 @@
+#ifndef DECENTRILICENSE_CRC32C_HPP
+#define DECENTRILICENSE_CRC32C_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace decentrilicense {
+
+/**
+ * Crc32c - CRC-32C (Castagnoli) checksum
+ *
+ * The implementation is picked once at startup: the SSE4.2 crc32
+ * instruction, the ARMv8 CRC32 extension or a portable slicing-by-8 table.
+ * All paths produce identical results (crc32c("123456789") == 0xE3069283).
+ *
+ * All functions are thread-safe
+ */
+class Crc32c {
+public:
+    /**
+     * Checksum of a buffer
+     * @param data Input bytes
+     * @param size Input size
+     */
+    static uint32_t compute(const void* data, size_t size) { return extend(0, data, size); }
+
+    static uint32_t compute(std::string_view data) { return extend(0, data.data(), data.size()); }
+
+    /**
+     * Continue a checksum: extend(compute(a), b) == compute(a + b)
+     * @param crc Checksum of the preceding bytes, 0 for none
+     * @param data Input bytes
+     * @param size Input size
+     */
+    static uint32_t extend(uint32_t crc, const void* data, size_t size);
+
+    /**
+     * extend() using the portable table implementation, whatever the CPU
+     * supports. For tests and benchmarks.
+     */
+    static uint32_t extend_portable(uint32_t crc, const void* data, size_t size);
+
+    /**
+     * Name of the implementation in use: "sse4.2", "armv8" or "portable"
+     */
+    static const char* implementation();
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_CRC32C_HPP
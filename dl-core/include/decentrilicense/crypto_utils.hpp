@@ -5,12 +5,117 @@
 #include <vector>
 #include <memory>
 #include <array>
+#include <optional>
+#include <string_view>
+#include <cstdint>
 #include <openssl/rsa.h>
 #include <openssl/pem.h>
 #include <openssl/evp.h>
+#include "key_cache.hpp"
 
 namespace decentrilicense {
 
+// Algorithms compiled into this build, set by the DECENTRILICENSE_ENABLE_RSA
+// and DECENTRILICENSE_ENABLE_SM2 CMake options. Ed25519 is always available.
+#ifndef DECENTRILICENSE_WITH_RSA
+#define DECENTRILICENSE_WITH_RSA 1
+#endif
+#ifndef DECENTRILICENSE_WITH_SM2
+#define DECENTRILICENSE_WITH_SM2 1
+#endif
+
+// Algorithm enumeration for signing
+enum class SigningAlgorithm {
+    RSA,
+    Ed25519,
+    SM2
+};
+
+/**
+ * Check whether an algorithm is compiled into this build
+ * Disabled algorithms are still parsed and named, so tokens using them
+ * round-trip, but signing fails and verification returns false.
+ */
+constexpr bool signing_algorithm_enabled(SigningAlgorithm algorithm) {
+    switch (algorithm) {
+        case SigningAlgorithm::RSA:
+            return DECENTRILICENSE_WITH_RSA != 0;
+        case SigningAlgorithm::Ed25519:
+            return true;
+        case SigningAlgorithm::SM2:
+            return DECENTRILICENSE_WITH_SM2 != 0;
+    }
+    return false;
+}
+
+/**
+ * Parse an algorithm identifier as used in token JSON ("RSA", "Ed25519", "SM2")
+ * @param name Algorithm identifier
+ * @return Algorithm, or std::nullopt if the identifier is unknown
+ */
+std::optional<SigningAlgorithm> parse_signing_algorithm(std::string_view name);
+
+/**
+ * Identifier of an algorithm as used in token JSON
+ * @param algorithm Signing algorithm
+ * @return "RSA", "Ed25519" or "SM2"
+ */
+const char* signing_algorithm_name(SigningAlgorithm algorithm);
+
+/**
+ * RawSignature - Signature bytes in a fixed-capacity inline buffer
+ *
+ * Large enough for RSA keys up to 8192 bits; Ed25519 and SM2 signatures use
+ * a small prefix. Lets sign/verify run without heap allocations and without
+ * going through base64, which is only needed at the JSON boundary.
+ */
+class RawSignature {
+public:
+    static constexpr size_t kMaxSize = 1024;
+
+    RawSignature() = default;
+
+    const uint8_t* data() const { return bytes_.data(); }
+    uint8_t* data() { return bytes_.data(); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /**
+     * Set the number of valid bytes
+     * @throws std::length_error if size exceeds kMaxSize
+     */
+    void resize(size_t size);
+
+    /**
+     * Encode for a token field
+     * @return Base64-encoded signature
+     */
+    std::string to_base64() const;
+
+    /**
+     * Decode a token field
+     * @param encoded Base64-encoded signature
+     * @param out Receives the signature bytes
+     * @return false if the input is not valid base64 or too long
+     */
+    static bool from_base64(std::string_view encoded, RawSignature* out);
+
+private:
+    std::array<uint8_t, kMaxSize> bytes_;
+    size_t size_ = 0;
+};
+
+// One signature check for CryptoUtils::verify_batch
+struct SignatureCheck {
+    std::string_view data;              // Signed data
+    std::string_view signature;         // Base64-encoded signature
+    std::string_view public_key_pem;    // Public key in PEM format
+    SigningAlgorithm algorithm;
+};
+
+// Per-item verification results, bit i is set if item i verified
+using VerificationBitmap = std::vector<bool>;
+
 /**
  * CryptoUtils - Cryptographic utilities using OpenSSL
  * 
@@ -21,6 +126,13 @@ namespace decentrilicense {
  * - SHA-256/SM3 hashing
  * - Secure random number generation
  * 
+ * PEM-based sign/verify functions resolve keys through KeyCache::instance(),
+ * so each distinct key is parsed once. The KeyHandle overloads skip the
+ * cache lookup entirely for callers that hold on to a parsed key.
+ * sign() and verify() work on raw signature bytes; the per-algorithm sign and
+ * verify functions are base64 wrappers around them for token fields. Both
+ * dispatch once to the Signer/Verifier specializations in signer.hpp.
+ *
  * All functions are thread-safe
  */
 class CryptoUtils {
@@ -35,6 +147,7 @@ public:
      * Generate RSA key pair
      * @param key_size Key size in bits (2048 or 4096 recommended)
      * @return KeyPair structure containing PEM-encoded keys
+     * @throws std::runtime_error on failure or if RSA is disabled in this build
      */
     static KeyPair generate_rsa_keypair(int key_size = 2048);
     
@@ -47,6 +160,7 @@ public:
     /**
      * Generate SM2 key pair
      * @return KeyPair structure containing PEM-encoded keys
+     * @throws std::runtime_error on failure or if SM2 is disabled in this build
      */
     static KeyPair generate_sm2_keypair();
     
@@ -57,6 +171,7 @@ public:
      * @return Base64-encoded signature
      */
     static std::string sign_data(const std::string& data, const std::string& private_key_pem);
+    static std::string sign_data(const std::string& data, const KeyHandle& private_key);
     
     /**
      * Verify RSA signature
@@ -68,6 +183,9 @@ public:
     static bool verify_signature(const std::string& data, 
                                const std::string& signature,
                                const std::string& public_key_pem);
+    static bool verify_signature(const std::string& data,
+                               const std::string& signature,
+                               const KeyHandle& public_key);
     
     /**
      * Sign data using Ed25519 private key
@@ -76,6 +194,7 @@ public:
      * @return Base64-encoded signature
      */
     static std::string sign_ed25519_data(const std::string& data, const std::string& private_key_pem);
+    static std::string sign_ed25519_data(const std::string& data, const KeyHandle& private_key);
     
     /**
      * Verify Ed25519 signature
@@ -87,6 +206,9 @@ public:
     static bool verify_ed25519_signature(const std::string& data, 
                                        const std::string& signature,
                                        const std::string& public_key_pem);
+    static bool verify_ed25519_signature(const std::string& data,
+                                       const std::string& signature,
+                                       const KeyHandle& public_key);
 
     /**
      * Sign data using SM2 private key with SM3 hash
@@ -95,6 +217,7 @@ public:
      * @return Base64-encoded signature
      */
     static std::string sign_sm2_data(const std::string& data, const std::string& private_key_pem);
+    static std::string sign_sm2_data(const std::string& data, const KeyHandle& private_key);
     
     /**
      * Verify SM2 signature
@@ -106,6 +229,52 @@ public:
     static bool verify_sm2_signature(const std::string& data, 
                                    const std::string& signature,
                                    const std::string& public_key_pem);
+    static bool verify_sm2_signature(const std::string& data,
+                                   const std::string& signature,
+                                   const KeyHandle& public_key);
+
+    /**
+     * Sign raw bytes
+     * RSA signs with SHA-256, SM2 with SM3, Ed25519 signs the message directly.
+     * @param algorithm Signing algorithm
+     * @param private_key Parsed private key (see KeyCache for PEM, DER and raw loading)
+     * @param data Data to sign
+     * @param size Size of data in bytes
+     * @return Raw signature bytes
+     * @throws std::runtime_error on failure, if the key does not match the
+     *         algorithm or if the algorithm is disabled in this build
+     */
+    static RawSignature sign(SigningAlgorithm algorithm, const KeyHandle& private_key,
+                             const uint8_t* data, size_t size);
+    static RawSignature sign(SigningAlgorithm algorithm, const KeyHandle& private_key,
+                             std::string_view data);
+
+    /**
+     * Verify a raw signature
+     * @param algorithm Signing algorithm
+     * @param public_key Parsed public key
+     * @param data Signed data
+     * @param size Size of data in bytes
+     * @param signature Raw signature bytes
+     * @param signature_size Size of the signature in bytes
+     * @return true if signature is valid; false if the algorithm is disabled
+     */
+    static bool verify(SigningAlgorithm algorithm, const KeyHandle& public_key,
+                       const uint8_t* data, size_t size,
+                       const uint8_t* signature, size_t signature_size);
+    static bool verify(SigningAlgorithm algorithm, const KeyHandle& public_key,
+                       std::string_view data, const RawSignature& signature);
+
+    /**
+     * Verify many signatures at once
+     * Items are grouped by key so each distinct key is resolved once and its
+     * initialized digest context is reused, then spread over WorkerPool::shared().
+     * @param items Signature checks to perform
+     * @param count Number of items
+     * @return Bitmap with one bit per item
+     */
+    static VerificationBitmap verify_batch(const SignatureCheck* items, size_t count);
+    static VerificationBitmap verify_batch(const std::vector<SignatureCheck>& items);
 
     /**
      * Encrypt data using AES-256-GCM
@@ -167,7 +336,7 @@ public:
     /**
      * Base64 decode
      * @param data Base64-encoded string
-     * @return Decoded data
+     * @return Decoded data, empty if the input is not valid base64
      */
     static std::vector<uint8_t> base64_decode(const std::string& data);
     static std::string base64url_encode(const std::vector<uint8_t>& data);
@@ -93,6 +93,12 @@ public:
      */
     ConnectionMode get_connection_mode() const { return current_mode_; }
 
+    /**
+     * Check for a verified, unexpired token
+     * Lock-free and allocation-free, see TokenManager::is_licensed
+     */
+    bool is_licensed() const noexcept { return token_manager_->is_licensed(); }
+
     /**
      * Check if token conflicts with other devices
      * @param token_id The token ID to check
@@ -184,7 +190,7 @@ private:
     std::mutex license_mutex_;
 
     std::atomic<bool> running_{false};
-    std::thread periodic_thread_;
+    TimerScheduler::TimerId discovery_timer_ = 0;   // Periodic discovery broadcast
     std::thread degradation_thread_;
 };
 
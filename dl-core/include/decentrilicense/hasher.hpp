@@ -0,0 +1,87 @@
+#ifndef DECENTRILICENSE_HASHER_HPP
+#define DECENTRILICENSE_HASHER_HPP
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <initializer_list>
+#include <cstdint>
+#include <cstddef>
+#include <openssl/evp.h>
+
+namespace decentrilicense {
+
+/**
+ * Hasher - Incremental SHA-256 / SM3 hashing
+ *
+ * Data can be fed in any number of fragments; the digest is the same as
+ * hashing the concatenation. finalize() returns a fixed-size digest and
+ * leaves the hasher ready for the next message, so one Hasher can be reused
+ * without further allocation.
+ *
+ * A Hasher must not be shared between threads; the static helpers use a
+ * per-thread instance and are thread-safe.
+ */
+class Hasher {
+public:
+    enum class Algorithm {
+        SHA256,
+        SM3
+    };
+
+    static constexpr size_t kDigestSize = 32;   // Both SHA-256 and SM3
+    using Digest = std::array<uint8_t, kDigestSize>;
+
+    explicit Hasher(Algorithm algorithm = Algorithm::SHA256);
+    ~Hasher();
+
+    // Movable, non-copyable
+    Hasher(Hasher&& other) noexcept;
+    Hasher& operator=(Hasher&& other) noexcept;
+    Hasher(const Hasher&) = delete;
+    Hasher& operator=(const Hasher&) = delete;
+
+    Algorithm algorithm() const { return algorithm_; }
+
+    /**
+     * Feed data into the hash
+     */
+    Hasher& update(const void* data, size_t size);
+    Hasher& update(std::string_view data) { return update(data.data(), data.size()); }
+
+    /**
+     * Finish the hash and start a new one
+     * @return Digest of everything fed since the last finalize()/reset()
+     */
+    Digest finalize();
+
+    /**
+     * Discard buffered input and start a new hash
+     */
+    void reset();
+
+    /**
+     * One-shot digest of a single buffer or of scattered fragments
+     */
+    static Digest digest(Algorithm algorithm, std::string_view data);
+    static Digest digest(Algorithm algorithm, std::initializer_list<std::string_view> fragments);
+
+    /**
+     * Lowercase hex encoding
+     * @param data Input bytes
+     * @param size Input size
+     * @param out Output buffer of at least 2 * size characters
+     */
+    static void to_hex(const uint8_t* data, size_t size, char* out);
+    static std::string to_hex(const Digest& digest);
+
+private:
+    static Hasher& thread_local_instance(Algorithm algorithm);
+
+    EVP_MD_CTX* ctx_;
+    Algorithm algorithm_;
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_HASHER_HPP
@@ -0,0 +1,175 @@
+#ifndef DECENTRILICENSE_KEY_CACHE_HPP
+#define DECENTRILICENSE_KEY_CACHE_HPP
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include <openssl/evp.h>
+
+namespace decentrilicense {
+
+/**
+ * KeyHandle - Shared handle to a parsed, ready-to-use key
+ *
+ * Copies are cheap (reference counted). The underlying EVP_PKEY stays alive
+ * as long as any handle refers to it, even after it has been evicted from
+ * the cache. EVP_PKEY objects may be used concurrently for sign/verify as
+ * long as every operation uses its own EVP_MD_CTX.
+ */
+class KeyHandle {
+public:
+    KeyHandle() = default;
+
+    /**
+     * Wrap a parsed key
+     * @param pkey Key to wrap, ownership is transferred to the handle
+     */
+    explicit KeyHandle(EVP_PKEY* pkey);
+
+    EVP_PKEY* get() const { return pkey_.get(); }
+
+    /**
+     * Get the key type (EVP_PKEY_RSA, EVP_PKEY_ED25519, EVP_PKEY_SM2, ...)
+     * @return Key type, or EVP_PKEY_NONE for an empty handle
+     */
+    int type() const;
+
+    explicit operator bool() const { return static_cast<bool>(pkey_); }
+
+private:
+    std::shared_ptr<EVP_PKEY> pkey_;
+};
+
+// Encodings accepted by KeyCache
+enum class KeyFormat : uint8_t {
+    PEM = 0,            // PEM text (SubjectPublicKeyInfo / PKCS#8 or traditional)
+    DER = 1,            // DER encoding of the same structures
+    RawEd25519 = 2      // 32-byte Ed25519 public key or private seed
+};
+
+/**
+ * KeyCache - Bounded LRU cache of parsed keys
+ *
+ * Entries are keyed by the SHA-256 digest of the encoded key, so the same key
+ * is parsed once no matter how many Token copies carry it. Parsing happens
+ * outside the cache lock; lookups and insertions are serialized by a single
+ * mutex and are O(1).
+ *
+ * All functions are thread-safe
+ */
+class KeyCache {
+public:
+    static constexpr size_t kDefaultCapacity = 256;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t size = 0;
+        size_t capacity = 0;
+    };
+
+    explicit KeyCache(size_t capacity = kDefaultCapacity);
+
+    // Non-copyable
+    KeyCache(const KeyCache&) = delete;
+    KeyCache& operator=(const KeyCache&) = delete;
+
+    /**
+     * Process-wide cache used by the PEM-based CryptoUtils functions
+     */
+    static KeyCache& instance();
+
+    /**
+     * Get a parsed public key, parsing and caching it on first use
+     * @param public_key_pem Public key in PEM format
+     * @return Key handle, empty if the PEM cannot be parsed
+     */
+    KeyHandle get_public_key(const std::string& public_key_pem);
+
+    /**
+     * Get a parsed private key, parsing and caching it on first use
+     * @param private_key_pem Private key in PEM format
+     * @return Key handle, empty if the PEM cannot be parsed
+     */
+    KeyHandle get_private_key(const std::string& private_key_pem);
+
+    /**
+     * Get a parsed public key from any supported encoding
+     * @param data Encoded key
+     * @param size Size of the encoded key in bytes
+     * @param format Encoding of data
+     * @return Key handle, empty if the key cannot be parsed
+     */
+    KeyHandle get_public_key(const uint8_t* data, size_t size, KeyFormat format);
+
+    /**
+     * Get a parsed private key from any supported encoding
+     * @param data Encoded key
+     * @param size Size of the encoded key in bytes
+     * @param format Encoding of data
+     * @return Key handle, empty if the key cannot be parsed
+     */
+    KeyHandle get_private_key(const uint8_t* data, size_t size, KeyFormat format);
+
+    /**
+     * Remove a key from the cache (both public and private entries)
+     * @param pem Key in PEM format
+     * @return true if an entry was removed
+     */
+    bool evict(const std::string& pem);
+
+    /**
+     * Remove the entries parsed in one OpenSSL library context
+     * @param context_id Id of the context (see CryptoContext), 0 for the default
+     * @return Number of entries removed
+     */
+    size_t erase_context(uint64_t context_id);
+
+    /**
+     * Remove all entries
+     */
+    void clear();
+
+    /**
+     * Change the maximum number of entries, evicting the least recently
+     * used entries if the cache is over the new limit
+     * @param capacity Maximum number of entries (0 disables caching)
+     */
+    void set_capacity(size_t capacity);
+
+    Stats stats() const;
+
+private:
+    enum class KeyKind : uint8_t {
+        Public = 0,
+        Private = 1
+    };
+
+    struct Entry {
+        std::string cache_key;
+        KeyHandle handle;
+    };
+
+    KeyHandle lookup_or_parse(std::string_view encoded, KeyKind kind, KeyFormat format);
+    static std::string make_cache_key(std::string_view encoded, KeyKind kind, KeyFormat format);
+    static KeyHandle parse(std::string_view encoded, KeyKind kind, KeyFormat format);
+    void trim_locked();
+
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;  // Most recently used at the front
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t capacity_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_KEY_CACHE_HPP
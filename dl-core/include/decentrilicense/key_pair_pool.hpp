@@ -0,0 +1,116 @@
+#ifndef DECENTRILICENSE_KEY_PAIR_POOL_HPP
+#define DECENTRILICENSE_KEY_PAIR_POOL_HPP
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "crypto_utils.hpp"
+#include "mpmc_queue.hpp"
+
+namespace decentrilicense {
+
+/**
+ * KeyPairPool - Pre-generated key pairs, refilled in the background
+ *
+ * Key generation (RSA in particular) is far too slow for a user-visible
+ * activation path. The pool keeps up to a target number of PEM key pairs per
+ * algorithm and a background thread tops them up. acquire() takes a ready pair
+ * from a lock-free queue and only generates inline when the pool has run dry.
+ *
+ * Pairs are generated in the default OpenSSL context. They are plain PEM, so
+ * they can be used with any CryptoContext.
+ *
+ * Thread-safe operations
+ */
+class KeyPairPool {
+public:
+    static constexpr size_t kMaxPooled = 64;
+
+    struct Config {
+        size_t ed25519 = 2;     // Target number of pooled pairs per algorithm
+        size_t rsa = 0;
+        size_t sm2 = 0;
+        int rsa_key_size = 2048;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;        // Served from the pool
+        uint64_t misses = 0;      // Generated inline because the pool was empty
+        uint64_t generated = 0;   // Generated by the refill thread
+    };
+
+    explicit KeyPairPool(const Config& config);
+    KeyPairPool() : KeyPairPool(Config()) {}
+    ~KeyPairPool();
+
+    // Non-copyable
+    KeyPairPool(const KeyPairPool&) = delete;
+    KeyPairPool& operator=(const KeyPairPool&) = delete;
+
+    /**
+     * Process-wide pool, created (and started) on first use
+     */
+    static KeyPairPool& shared();
+
+    /**
+     * Get a key pair, from the pool if one is ready
+     * @param algorithm Key algorithm
+     * @return Key pair in PEM format
+     * @throws std::runtime_error if inline generation fails
+     */
+    CryptoUtils::KeyPair acquire(SigningAlgorithm algorithm);
+
+    /**
+     * Change how many pairs are kept ready for an algorithm
+     * @param algorithm Key algorithm
+     * @param count Target number of pairs (clamped to kMaxPooled, 0 disables)
+     */
+    void set_target(SigningAlgorithm algorithm, size_t count);
+
+    /**
+     * Change the RSA key size; pooled RSA pairs of the old size are dropped
+     */
+    void set_rsa_key_size(int key_size);
+
+    /**
+     * Number of pairs ready for an algorithm
+     */
+    size_t available(SigningAlgorithm algorithm) const;
+
+    Stats stats() const;
+
+private:
+    static constexpr size_t kAlgorithmCount = 3;
+
+    struct Slot {
+        Slot() : queue(kMaxPooled) {}
+        MpmcQueue<CryptoUtils::KeyPair> queue;
+        std::atomic<size_t> target{0};
+    };
+
+    static size_t index_of(SigningAlgorithm algorithm);
+    CryptoUtils::KeyPair generate(SigningAlgorithm algorithm) const;
+    bool needs_refill() const;
+    void request_refill();
+    void refill_loop();
+
+    std::array<Slot, kAlgorithmCount> slots_;
+    std::atomic<int> rsa_key_size_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> generated_{0};
+
+    std::thread refill_thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool refill_requested_ = false;
+    bool stopping_ = false;
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_KEY_PAIR_POOL_HPP
@@ -0,0 +1,72 @@
+#ifndef DECENTRILICENSE_LICENSE_STATE_HPP
+#define DECENTRILICENSE_LICENSE_STATE_HPP
+
+#include <atomic>
+#include <cstdint>
+
+namespace decentrilicense {
+
+/**
+ * LicenseState - Licensing state packed into one atomic word
+ *
+ * Layout, high to low bit:
+ * | 63     | 62..40              | 39..0                       |
+ * | active | generation (23 bit) | expire time, Unix seconds   |
+ *
+ * The owner publishes a new word whenever the token or activation changes;
+ * every publish bumps the generation, so callers that cache derived data
+ * can tell that something changed. is_licensed() is one atomic load and a
+ * coarse clock read (vDSO or shared page, no syscall): no locks, no
+ * allocations. The word sits alone on its cache line so that hot readers
+ * are not disturbed by writes to neighbouring data.
+ *
+ * All functions are thread-safe
+ */
+class alignas(64) LicenseState {
+public:
+    struct View {
+        bool active;
+        uint32_t generation;
+        uint64_t expire_time;       // Unix seconds
+    };
+
+    static constexpr uint64_t kExpireMask = (uint64_t{1} << 40) - 1;
+    static constexpr int kGenerationShift = 40;
+    static constexpr uint64_t kGenerationMask = (uint64_t{1} << 23) - 1;
+    static constexpr uint64_t kActiveBit = uint64_t{1} << 63;
+
+    /**
+     * Check for an active, unexpired license
+     * Same expiry rule as Token::is_expired, at clock tick resolution
+     */
+    bool is_licensed() const noexcept {
+        const uint64_t word = word_.load(std::memory_order_acquire);
+        return (word & kActiveBit) != 0 && coarse_unix_seconds() <= (word & kExpireMask);
+    }
+
+    View load() const noexcept {
+        const uint64_t word = word_.load(std::memory_order_acquire);
+        return {(word & kActiveBit) != 0,
+                static_cast<uint32_t>((word >> kGenerationShift) & kGenerationMask),
+                word & kExpireMask};
+    }
+
+    /**
+     * Publish a new state and bump the generation
+     * @param active Whether a verified, activated token is held
+     * @param expire_time Token expiry in Unix seconds; saturates at 2^40 - 1
+     */
+    void publish(bool active, uint64_t expire_time) noexcept;
+
+    /**
+     * Current time in Unix seconds from the cheapest clock available
+     */
+    static uint64_t coarse_unix_seconds() noexcept;
+
+private:
+    std::atomic<uint64_t> word_{0};
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_LICENSE_STATE_HPP
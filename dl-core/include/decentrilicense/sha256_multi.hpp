@@ -0,0 +1,65 @@
+#ifndef DECENTRILICENSE_SHA256_MULTI_HPP
+#define DECENTRILICENSE_SHA256_MULTI_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include "hasher.hpp"
+
+namespace decentrilicense {
+
+/**
+ * Sha256Multi - Multi-buffer SHA-256 for many independent messages
+ *
+ * The SIMD kernels run one message per vector lane (8 with AVX2, 16 with
+ * AVX-512), so a batch of short messages such as serialized chain entries
+ * is hashed in parallel instead of one after the other. A lane that
+ * finishes its message is refilled with the next one. The last few
+ * messages, when too few are left to fill the lanes, go through the
+ * single-buffer kernel: SHA-NI where available, scalar code otherwise.
+ *
+ * The kernels are picked once at startup. AVX2 is only used when the CPU has
+ * no SHA-NI, since 8 lanes do not beat the SHA extensions. All kernels
+ * produce the same digests as Hasher.
+ *
+ * All functions are thread-safe
+ */
+class Sha256Multi {
+public:
+    using Digest = Hasher::Digest;
+
+    enum class Kernel {
+        Auto,       // Best available
+        Scalar,     // Portable, one message at a time
+        ShaNi,      // SHA extensions, one message at a time
+        Avx2,       // 8 lanes
+        Avx512      // 16 lanes
+    };
+
+    /**
+     * Hash a batch of messages
+     * @param messages Messages to hash
+     * @param count Number of messages
+     * @param out Receives one digest per message, in order
+     * @param kernel Kernel to use; falls back to Auto if it is not supported
+     */
+    static void digest(const std::string_view* messages, size_t count, Digest* out,
+                       Kernel kernel = Kernel::Auto);
+
+    static std::vector<Digest> digest(const std::vector<std::string>& messages);
+
+    /**
+     * Check whether a kernel can run on this CPU
+     */
+    static bool supported(Kernel kernel);
+
+    /**
+     * Name of the selected implementation, e.g. "avx512+sha-ni" or "scalar"
+     */
+    static const char* implementation();
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_SHA256_MULTI_HPP
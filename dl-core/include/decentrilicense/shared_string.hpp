@@ -0,0 +1,82 @@
+#ifndef DECENTRILICENSE_SHARED_STRING_HPP
+#define DECENTRILICENSE_SHARED_STRING_HPP
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace decentrilicense {
+
+/**
+ * SharedString - Immutable, reference-counted, interned string
+ *
+ * Meant for large values that many tokens carry unchanged, such as license
+ * public keys and root signatures. Equal contents share one buffer across
+ * the whole process, so copying a SharedString only bumps a reference count
+ * and a loaded state chain holds each PEM once. A buffer is dropped from the
+ * intern table when its last SharedString goes away.
+ *
+ * Converts implicitly from and to strings, so it drops in for a
+ * std::string field. Each conversion from a string interns it: one hash and
+ * a short lock.
+ *
+ * Thread-safe like std::shared_ptr<const std::string>
+ */
+class SharedString {
+public:
+    SharedString() = default;
+    SharedString(std::string_view value);
+    SharedString(const std::string& value) : SharedString(std::string_view(value)) {}
+    SharedString(std::string&& value);
+    SharedString(const char* value) : SharedString(std::string_view(value)) {}
+
+    const std::string& str() const { return value_ ? *value_ : empty_string(); }
+    operator const std::string&() const { return str(); }
+    operator std::string_view() const { return str(); }
+
+    bool empty() const { return !value_; }
+    size_t size() const { return str().size(); }
+    size_t length() const { return str().size(); }
+    const char* data() const { return str().data(); }
+    const char* c_str() const { return str().c_str(); }
+    void clear() { value_.reset(); }
+
+    /**
+     * Number of distinct buffers currently interned
+     */
+    static size_t interned_count();
+
+    // Interned buffers are unique per content, so equal pointers settle
+    // most comparisons without touching the bytes
+    friend bool operator==(const SharedString& a, const SharedString& b) {
+        return a.value_ == b.value_ || a.str() == b.str();
+    }
+    friend bool operator==(const SharedString& a, std::string_view b) { return a.str() == b; }
+    friend bool operator==(const SharedString& a, const std::string& b) { return a.str() == b; }
+    friend bool operator==(const SharedString& a, const char* b) { return a.str() == b; }
+    friend bool operator==(std::string_view a, const SharedString& b) { return b == a; }
+    friend bool operator==(const std::string& a, const SharedString& b) { return b == a; }
+    friend bool operator==(const char* a, const SharedString& b) { return b == a; }
+    template <typename T>
+    friend bool operator!=(const SharedString& a, const T& b) { return !(a == b); }
+    template <typename T>
+    friend bool operator!=(const T& a, const SharedString& b) { return !(b == a); }
+    friend bool operator!=(const SharedString& a, const SharedString& b) { return !(a == b); }
+
+    friend std::ostream& operator<<(std::ostream& os, const SharedString& s) { return os << s.str(); }
+
+private:
+    static const std::string& empty_string() {
+        static const std::string empty;
+        return empty;
+    }
+
+    // Null for the empty string, which is never interned
+    std::shared_ptr<const std::string> value_;
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_SHARED_STRING_HPP
@@ -0,0 +1,118 @@
+#ifndef DECENTRILICENSE_SIGNER_HPP
+#define DECENTRILICENSE_SIGNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <openssl/evp.h>
+#include "crypto_utils.hpp"
+#include "key_cache.hpp"
+
+namespace decentrilicense {
+
+template <SigningAlgorithm Algorithm>
+using AlgorithmTag = std::integral_constant<SigningAlgorithm, Algorithm>;
+
+/**
+ * Signer - Signing specialized for one algorithm
+ *
+ * The digest (SHA-256 for RSA, SM3 for SM2, none for Ed25519) and the
+ * one-shot versus streaming code path are chosen at compile time. Only the
+ * algorithms enabled in the build are instantiated; naming a disabled one
+ * does not compile.
+ */
+template <SigningAlgorithm Algorithm>
+class Signer {
+    static_assert(signing_algorithm_enabled(Algorithm),
+                  "signing algorithm is disabled in this build");
+
+public:
+    /**
+     * Sign raw bytes
+     * @param private_key Parsed private key
+     * @param data Data to sign
+     * @param size Size of data in bytes
+     * @return Raw signature bytes
+     * @throws std::runtime_error on failure or if the key does not match the algorithm
+     */
+    static RawSignature sign(const KeyHandle& private_key, const uint8_t* data, size_t size);
+
+    static RawSignature sign(const KeyHandle& private_key, std::string_view data) {
+        return sign(private_key, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+    }
+};
+
+/**
+ * Verifier - Signature verification specialized for one algorithm
+ *
+ * init() and finish() split verify() in two so CryptoUtils::verify_batch can
+ * initialize a context once per key and copy it for each signature.
+ */
+template <SigningAlgorithm Algorithm>
+class Verifier {
+    static_assert(signing_algorithm_enabled(Algorithm),
+                  "signing algorithm is disabled in this build");
+
+public:
+    /**
+     * Verify a raw signature
+     * @param public_key Parsed public key
+     * @param data Signed data
+     * @param size Size of data in bytes
+     * @param signature Raw signature bytes
+     * @param signature_size Size of the signature in bytes
+     * @return true if signature is valid
+     */
+    static bool verify(const KeyHandle& public_key, const uint8_t* data, size_t size,
+                       const uint8_t* signature, size_t signature_size);
+
+    static bool verify(const KeyHandle& public_key, std::string_view data,
+                       const RawSignature& signature) {
+        return verify(public_key, reinterpret_cast<const uint8_t*>(data.data()), data.size(),
+                      signature.data(), signature.size());
+    }
+
+    /**
+     * Set up a digest context for verification with public_key
+     * @return false if the key does not match the algorithm or setup fails
+     */
+    static bool init(EVP_MD_CTX* ctx, EVP_PKEY* public_key);
+
+    /**
+     * Verify one signature with a context prepared by init()
+     * The context is consumed and must be re-initialized or re-copied.
+     */
+    static bool finish(EVP_MD_CTX* ctx, const uint8_t* data, size_t size,
+                       const uint8_t* signature, size_t signature_size);
+};
+
+/**
+ * Map a runtime algorithm to its compile-time tag
+ * @param algorithm Signing algorithm
+ * @param fn Called with AlgorithmTag<A>() for an enabled algorithm
+ * @param disabled Called without arguments if the algorithm is compiled out
+ * @return Whatever fn or disabled returns
+ */
+template <typename Fn, typename Disabled>
+auto with_signing_algorithm(SigningAlgorithm algorithm, Fn&& fn, Disabled&& disabled) {
+    switch (algorithm) {
+        case SigningAlgorithm::Ed25519:
+            return fn(AlgorithmTag<SigningAlgorithm::Ed25519>());
+        case SigningAlgorithm::RSA:
+            if constexpr (signing_algorithm_enabled(SigningAlgorithm::RSA)) {
+                return fn(AlgorithmTag<SigningAlgorithm::RSA>());
+            }
+            break;
+        case SigningAlgorithm::SM2:
+            if constexpr (signing_algorithm_enabled(SigningAlgorithm::SM2)) {
+                return fn(AlgorithmTag<SigningAlgorithm::SM2>());
+            }
+            break;
+    }
+    return disabled();
+}
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_SIGNER_HPP
@@ -0,0 +1,125 @@
+#ifndef DECENTRILICENSE_SNAPSHOT_CELL_HPP
+#define DECENTRILICENSE_SNAPSHOT_CELL_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace decentrilicense {
+
+/**
+ * SnapshotCell - Holds an immutable value that many threads read and few
+ * threads replace
+ *
+ * The value lives in one of a few slots. Readers announce themselves on the
+ * slot they are about to read with a single atomic increment, so they never
+ * lock and never wait for a writer. A writer fills any idle slot that no
+ * reader is on and flips the current index; it only has to wait if readers
+ * were preempted inside every idle slot at once.
+ *
+ * Published values are never modified. A snapshot returned by load() stays
+ * valid for as long as the caller holds it, whatever writers do meanwhile.
+ *
+ * All functions are thread-safe; load() and read() never block
+ */
+template <typename T>
+class SnapshotCell {
+public:
+    SnapshotCell() = default;
+    SnapshotCell(const SnapshotCell&) = delete;
+    SnapshotCell& operator=(const SnapshotCell&) = delete;
+
+    /**
+     * Current value
+     * @return Shared snapshot, or nullptr if no value is set
+     */
+    std::shared_ptr<const T> load() const {
+        return read([](const std::shared_ptr<const T>& value) { return value; });
+    }
+
+    /**
+     * Run f on the current value without copying the shared pointer
+     * f must be short and must not call store() on the same cell.
+     * @param f Called with const std::shared_ptr<const T>&, which may be null
+     * @return Whatever f returns
+     */
+    template <typename F>
+    auto read(F&& f) const {
+        const Slot& slot = enter();
+        struct Leave {
+            const Slot& slot;
+            ~Leave() { slot.readers.fetch_sub(1, std::memory_order_release); }
+        } leave{slot};
+        return f(slot.value);
+    }
+
+    /**
+     * Publish a new value (nullptr clears the cell)
+     * Writers are serialized against each other; readers are never blocked.
+     */
+    void store(std::shared_ptr<const T> value) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        const uint32_t current = current_.load(std::memory_order_relaxed);
+        uint32_t next = current;
+        while (next == current) {
+            for (uint32_t i = 1; i < kSlots; ++i) {
+                const uint32_t candidate = (current + i) % kSlots;
+                if (idle(slots_[candidate])) {
+                    next = candidate;
+                    break;
+                }
+            }
+            if (next == current) {
+                std::this_thread::yield();
+            }
+        }
+        slots_[next].value = std::move(value);
+        current_.store(next, std::memory_order_seq_cst);
+
+        // Drop replaced values now rather than when their slot is reused;
+        // slots with a reader still on them are left for the next store
+        for (uint32_t i = 0; i < kSlots; ++i) {
+            if (i != next && slots_[i].value && idle(slots_[i])) {
+                slots_[i].value.reset();
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t kSlots = 4;
+
+    // Slots on separate cache lines so readers of one do not slow the others
+    struct alignas(64) Slot {
+        std::shared_ptr<const T> value;
+        mutable std::atomic<uint32_t> readers{0};
+    };
+
+    const Slot& enter() const {
+        for (;;) {
+            const uint32_t index = current_.load(std::memory_order_seq_cst);
+            const Slot& slot = slots_[index];
+            slot.readers.fetch_add(1, std::memory_order_seq_cst);
+            // Pairs with idle(): a writer only touches a slot that is not
+            // current and has no readers, so either the writer sees this
+            // reader or this reader sees the index move on and retries
+            if (current_.load(std::memory_order_seq_cst) == index) {
+                return slot;
+            }
+            slot.readers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    static bool idle(const Slot& slot) {
+        return slot.readers.load(std::memory_order_seq_cst) == 0;
+    }
+
+    Slot slots_[kSlots];
+    alignas(64) std::atomic<uint32_t> current_{0};
+    std::mutex write_mutex_;
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_SNAPSHOT_CELL_HPP
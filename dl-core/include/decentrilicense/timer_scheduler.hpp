@@ -0,0 +1,121 @@
+#ifndef DECENTRILICENSE_TIMER_SCHEDULER_HPP
+#define DECENTRILICENSE_TIMER_SCHEDULER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace decentrilicense {
+
+/**
+ * TimerScheduler - Runs callbacks when they are due on one worker thread
+ *
+ * Timers sit in a min-heap keyed by due time; the worker sleeps on a single
+ * condition variable until the earliest one is due, so an idle process
+ * never wakes up and a timer fires on time however many are pending.
+ * Scheduling, rescheduling and cancelling are O(log n); cancelled entries
+ * are dropped from the heap lazily.
+ *
+ * Callbacks run one at a time on the worker and must be short; they may
+ * schedule, reschedule or cancel timers, including their own.
+ *
+ * All functions are thread-safe
+ */
+class TimerScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = uint64_t;                   // 0 is never a valid id
+
+    TimerScheduler() = default;
+    ~TimerScheduler();
+
+    // Non-copyable
+    TimerScheduler(const TimerScheduler&) = delete;
+    TimerScheduler& operator=(const TimerScheduler&) = delete;
+
+    /**
+     * Process-wide scheduler shared by all clients and token managers
+     * Never destroyed, so timers may be cancelled from static destructors
+     */
+    static TimerScheduler& instance();
+
+    /**
+     * Schedule a callback
+     * @param due When to run it
+     * @param callback Callback
+     * @param period If non-zero, run again every period after due until
+     *        cancelled; a run that falls behind is skipped, not queued
+     * @return Timer id
+     */
+    TimerId schedule_at(Clock::time_point due, std::function<void()> callback,
+                        Clock::duration period = Clock::duration::zero());
+
+    TimerId schedule_after(Clock::duration delay, std::function<void()> callback,
+                           Clock::duration period = Clock::duration::zero());
+
+    /**
+     * Move a timer to a new due time
+     * Also re-arms a one-shot timer whose callback is running right now.
+     * @return false if the timer has fired (and finished) or was cancelled
+     */
+    bool reschedule(TimerId id, Clock::time_point due);
+
+    /**
+     * Cancel a timer
+     * Does not wait: the callback may be running while this returns.
+     * @return true if the timer was pending or running
+     */
+    bool cancel(TimerId id);
+
+    /**
+     * Cancel a timer and wait until its callback is no longer running
+     * Use before destroying what the callback refers to. Must not be called
+     * while holding a lock the callback takes; from inside the callback
+     * itself it does not wait.
+     */
+    void cancel_and_wait(TimerId id);
+
+    /**
+     * Number of pending timers
+     */
+    size_t pending() const;
+
+private:
+    struct Timer {
+        std::function<void()> callback;
+        Clock::duration period;
+        Clock::time_point due;
+        uint64_t version;                       // Bumped on every (re)arm
+        bool armed;                             // False while running a one-shot
+    };
+
+    struct HeapEntry {
+        Clock::time_point due;
+        TimerId id;
+        uint64_t version;                       // Stale if != Timer::version
+
+        bool operator>(const HeapEntry& other) const { return due > other.due; }
+    };
+
+    void arm(TimerId id, Timer& timer, Clock::time_point due);
+    void run();
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;              // Worker: earlier timer or stop
+    std::condition_variable idle_;              // cancel_and_wait: callback done
+    std::unordered_map<TimerId, Timer> timers_;
+    std::vector<HeapEntry> heap_;               // Min-heap on due
+    TimerId next_id_ = 1;
+    TimerId running_ = 0;                       // Id whose callback is running
+    bool stopping_ = false;
+    std::thread worker_;                        // Started by the first timer
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_TIMER_SCHEDULER_HPP
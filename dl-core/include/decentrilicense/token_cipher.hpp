@@ -0,0 +1,92 @@
+#ifndef DECENTRILICENSE_TOKEN_CIPHER_HPP
+#define DECENTRILICENSE_TOKEN_CIPHER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <openssl/evp.h>
+
+namespace decentrilicense {
+
+/**
+ * TokenCipher - AES-256-GCM session for encrypted token strings
+ *
+ * Token strings have the form base64url(ciphertext || tag) "|" base64url(nonce).
+ * The session keeps one encryption and one decryption context with the key
+ * schedule already set up, so each token only costs a nonce reset and the
+ * AES-GCM pass itself. decrypt() can write into a caller buffer: the
+ * ciphertext is base64-decoded straight into it and decrypted in place.
+ *
+ * A session is not thread-safe; use one per thread.
+ */
+class TokenCipher {
+public:
+    static constexpr size_t kKeySize = 32;
+    static constexpr size_t kNonceSize = 12;
+    static constexpr size_t kTagSize = 16;
+
+    using Key = std::array<uint8_t, kKeySize>;
+
+    /**
+     * Create a session
+     * @param key AES-256 key
+     * @throws std::runtime_error if the cipher contexts cannot be set up
+     */
+    explicit TokenCipher(const Key& key);
+    ~TokenCipher();
+
+    // Non-copyable
+    TokenCipher(const TokenCipher&) = delete;
+    TokenCipher& operator=(const TokenCipher&) = delete;
+
+    /**
+     * Key used for tokens issued by dl-issuer (derived from ROOT_PUBLIC_KEY),
+     * computed once per process
+     */
+    static const Key& token_key();
+
+    /**
+     * Encrypt a token
+     * @param plaintext Token JSON
+     * @return Encrypted token string
+     * @throws std::runtime_error on failure
+     */
+    std::string encrypt(std::string_view plaintext);
+
+    /**
+     * Upper bound for the buffer passed to decrypt(), including scratch
+     * space for the tag
+     * @param encrypted Encrypted token string
+     * @return Required buffer size in bytes
+     */
+    static size_t decrypt_buffer_size(std::string_view encrypted);
+
+    /**
+     * Decrypt a token into a caller buffer
+     * @param encrypted Encrypted token string
+     * @param out Output buffer, at least decrypt_buffer_size(encrypted) bytes
+     * @param out_capacity Size of out in bytes
+     * @return Number of plaintext bytes written to out
+     * @throws std::runtime_error if the token is malformed, the buffer is too
+     *         small or authentication fails
+     */
+    size_t decrypt(std::string_view encrypted, uint8_t* out, size_t out_capacity);
+
+    /**
+     * Decrypt a token
+     * @param encrypted Encrypted token string
+     * @return Token JSON
+     * @throws std::runtime_error on failure
+     */
+    std::string decrypt(std::string_view encrypted);
+
+private:
+    EVP_CIPHER_CTX* encrypt_ctx_;
+    EVP_CIPHER_CTX* decrypt_ctx_;
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_TOKEN_CIPHER_HPP
@@ -0,0 +1,113 @@
+#ifndef DECENTRILICENSE_TOKEN_JSON_HPP
+#define DECENTRILICENSE_TOKEN_JSON_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace decentrilicense {
+
+/**
+ * JsonString - A JSON string value as it appears in the document
+ *
+ * raw points into the parsed document, so it is only valid while the
+ * document is. Values without escapes (the common case: ids, hashes,
+ * base64) are copied straight out of the document; only escaped values are
+ * decoded.
+ */
+struct JsonString {
+    std::string_view raw;       // Between the quotes, escapes not decoded
+    bool escaped = false;       // raw contains at least one backslash
+
+    bool empty() const { return raw.empty(); }
+
+    /**
+     * Decoded value
+     * Handles \" \\ \/ \b \f \n \r \t and \uXXXX (including surrogate
+     * pairs, emitted as UTF-8). Any other escaped character is kept as is.
+     */
+    std::string str() const;
+};
+
+/**
+ * TokenJsonView - Token fields as slices of a JSON document
+ *
+ * Filled by parse_token_json. Missing fields stay empty or 0, as do fields
+ * of the wrong JSON type (e.g. "device_info": null).
+ */
+struct TokenJsonView {
+    JsonString token_id;
+    JsonString holder_device_id;
+    JsonString license_code;
+    uint64_t issue_time = 0;
+    uint64_t expire_time = 0;
+    JsonString signature;
+    JsonString alg;
+    JsonString app_id;
+    JsonString environment_hash;
+    JsonString license_public_key;
+    JsonString root_signature;
+    JsonString encrypted_license_private_key;
+
+    uint64_t state_index = 0;
+    JsonString prev_state_hash;
+    JsonString state_payload;
+    JsonString state_signature;
+
+    struct DeviceInfo {
+        JsonString fingerprint;
+        JsonString public_key;
+        JsonString signature;
+    } device_info;
+
+    struct UsageRecord {
+        uint64_t seq = 0;
+        JsonString time;
+        JsonString action;
+        JsonString params;
+        JsonString hash_prev;
+        JsonString signature;
+    };
+    std::vector<UsageRecord> usage_chain;
+    JsonString current_signature;
+};
+
+/**
+ * Parse a token JSON document in a single pass
+ *
+ * The document is walked once, front to back. Nested device_info and
+ * usage_chain values are parsed in place; unknown members are skipped
+ * whatever their type. A known member appearing twice is rejected, so two
+ * parsers can never disagree on which copy counts.
+ *
+ * @param json Token JSON object; must outlive view
+ * @param view Receives slices of json
+ * @return false if json is not a well-formed JSON object
+ */
+bool parse_token_json(std::string_view json, TokenJsonView& view);
+
+/**
+ * Size of s after JSON string escaping as done by Token::to_json
+ * Only \\ \" \n \r \t are escaped; every other byte is copied unchanged,
+ * which existing state chains depend on.
+ */
+size_t json_escaped_size(std::string_view s);
+
+/**
+ * Escape s into out
+ * @param s Input
+ * @param out Buffer of at least json_escaped_size(s) bytes
+ * @return One past the last byte written
+ */
+char* json_escape_to(std::string_view s, char* out);
+
+/**
+ * Name of the escape scanner picked at startup ("avx2", "sse2" or "scalar")
+ */
+const char* json_escape_implementation();
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_TOKEN_JSON_HPP
@@ -2,23 +2,25 @@
 #define DECENTRILICENSE_TOKEN_MANAGER_HPP
 
 #include <string>
+#include <string_view>
 #include <optional>
 #include <functional>
 #include <chrono>
 #include <mutex>
 #include <unordered_map>
 #include <memory>
+#include <vector>
 #include "network_manager.hpp"
+#include "crypto_utils.hpp"
+#include "hasher.hpp"
+#include "license_state.hpp"
+#include "shared_string.hpp"
+#include "snapshot_cell.hpp"
+#include "timer_scheduler.hpp"
+#include "verification_cache.hpp"
 
 namespace decentrilicense {
 
-// Algorithm enumeration for signing
-enum class SigningAlgorithm {
-    RSA,
-    Ed25519,
-    SM2
-};
-
 // Enhanced Token structure with algorithm support and device identity
 struct Token {
     std::string token_id;                   // UUID
@@ -27,12 +29,12 @@ struct Token {
     uint64_t issue_time;                    // Unix timestamp
     uint64_t expire_time;                   // Unix timestamp
     std::string signature;                  // Cryptographic signature
-    std::string alg;                        // Algorithm identifier ("RSA", "Ed25519", "SM2")
+    std::optional<SigningAlgorithm> alg;    // Signing algorithm, serialized as "RSA", "Ed25519" or "SM2"
     std::string app_id;                     // Application identifier for business isolation
     std::string environment_hash;           // Optional environment hash for anti-copy protection
-    std::string license_public_key;         // License public key (PEM string)
-    std::string root_signature;             // Root signature of license public key
-    std::string encrypted_license_private_key; // Encrypted license private key (optional)
+    SharedString license_public_key;        // License public key (PEM string)
+    SharedString root_signature;            // Root signature of license public key
+    SharedString encrypted_license_private_key; // Encrypted license private key (optional)
     
     // State chain fields for offline state recording
     uint64_t state_index;                   // State index, starting from 0
@@ -43,7 +45,7 @@ struct Token {
     // Device identity fields for enhanced verification and traceability
     struct DeviceInfo {
         std::string fingerprint;            // Hardware fingerprint
-        std::string public_key;             // Device public key in PEM format
+        SharedString public_key;            // Device public key in PEM format
         std::string signature;              // Signature of device info using device private key
     } device_info;
     
@@ -62,7 +64,73 @@ struct Token {
     bool is_valid() const;
     bool is_expired() const;
     std::string to_json() const;
+
+    /**
+     * Exact size of to_json() in bytes
+     */
+    size_t json_size() const;
+
+    /**
+     * Write to_json() into a caller buffer
+     * @param out Buffer of at least json_size() bytes
+     * @return Number of bytes written
+     */
+    size_t write_json(char* out) const;
+
+    /**
+     * Feed to_json() into hasher without building the string
+     */
+    void write_json(Hasher& hasher) const;
+
+    /**
+     * Lowercase hex SHA-256 of to_json(), as stored in prev_state_hash
+     */
+    std::string json_sha256() const;
+
+    /**
+     * Parse a token, see parse_token_json
+     * @return Parsed token, or an empty (invalid) token if json is malformed
+     */
     static Token from_json(const std::string& json);
+
+    /**
+     * Parse a token, see parse_token_json
+     * @param json Token JSON
+     * @param token Receives the token
+     * @return false if json is malformed
+     */
+    static bool from_json(std::string_view json, Token* token);
+
+    /**
+     * Compact binary encoding (version 2, see token_binary.cpp)
+     * Keys are stored as DER or raw bytes, signatures and hashes as raw
+     * bytes and integers as fixed 8-byte fields. The encoding is canonical
+     * and converts back to exactly the same token, so to_json() of the
+     * decoded token is byte-identical to the original's.
+     */
+    std::vector<uint8_t> to_binary() const;
+
+    /**
+     * Check for the binary encoding header
+     */
+    static bool is_binary(const uint8_t* data, size_t size);
+
+    /**
+     * Decode the binary encoding
+     * @param data Encoded token
+     * @param size Size of data in bytes
+     * @param token Receives the token
+     * @return false if data is malformed or not canonical
+     */
+    static bool from_binary(const uint8_t* data, size_t size, Token* token);
+
+    /**
+     * Decode either encoding, telling them apart by the binary header
+     * @param data Binary or JSON token
+     * @param token Receives the token
+     * @return false if data is malformed
+     */
+    static bool decode(std::string_view data, Token* token);
 };
 
 // Token status
@@ -76,31 +144,6 @@ enum class TokenStatus {
 // Token change callback
 using TokenChangeCallback = std::function<void(TokenStatus status, const std::optional<Token>& token)>;
 
-// Signature verifier interface
-class SignatureVerifier {
-public:
-    virtual ~SignatureVerifier() = default;
-    virtual bool verify(const Token& token, const std::string& public_key) const = 0;
-};
-
-// RSA verifier implementation
-class RsaVerifier : public SignatureVerifier {
-public:
-    bool verify(const Token& token, const std::string& public_key) const override;
-};
-
-// Ed25519 verifier implementation
-class Ed25519Verifier : public SignatureVerifier {
-public:
-    bool verify(const Token& token, const std::string& public_key) const override;
-};
-
-// SM2 verifier implementation
-class Sm2Verifier : public SignatureVerifier {
-public:
-    bool verify(const Token& token, const std::string& public_key) const override;
-};
-
 /**
  * TokenManager - Manages software license tokens with multi-algorithm support
  * 
@@ -108,7 +151,7 @@ public:
  * - Token generation (coordinator only)
  * - Token validation with multiple algorithms (RSA, Ed25519, SM2)
  * - Token transfer between devices
- * - Signature verification with factory pattern
+ * - Signature verification specialized per algorithm (see signer.hpp)
  * - Smart caching of verification results
  * 
  * Thread-safe operations
@@ -122,8 +165,8 @@ public:
  */
 class TokenManager {
 public:
-    TokenManager();
-    ~TokenManager() = default;
+    TokenManager() = default;
+    ~TokenManager();
     
     // Non-copyable
     TokenManager(const TokenManager&) = delete;
@@ -154,14 +197,37 @@ public:
     
     /**
      * Get current token
+     * Never blocks; copies the token (large fields are shared, see
+     * SharedString).
      * @return Current token if exists
      */
     std::optional<Token> get_current_token() const;
+
+    /**
+     * Get current token without copying it
+     * Never blocks. The snapshot is immutable and stays valid after the
+     * token is replaced or invalidated.
+     * @return Current token, or nullptr if none
+     */
+    std::shared_ptr<const Token> get_current_token_snapshot() const;
     
     /**
      * Get token status
+     * Never blocks and never copies the token
      */
     TokenStatus get_status() const;
+
+    /**
+     * Check for a verified, unexpired current token
+     * Reads one atomic word: no locks, copies or allocations. Meant for
+     * per-request license checks.
+     */
+    bool is_licensed() const noexcept { return license_state_.is_licensed(); }
+
+    /**
+     * Licensing state word, republished on every token change
+     */
+    const LicenseState& license_state() const { return license_state_; }
     
     /**
      * Verify token signature with smart caching
@@ -170,16 +236,30 @@ public:
      * @return true if signature is valid
      */
     bool verify_token(const Token& token, const std::string& public_key) const;
+
+    /**
+     * Verify many token signatures at once on the shared worker pool
+     * @param tokens Tokens to verify
+     * @param public_key Public key for verification
+     * @return Bitmap with one bit per token, set if its signature is valid
+     */
+    VerificationBitmap verify_tokens(const std::vector<Token>& tokens, const std::string& public_key) const;
+
+    /**
+     * Get verification cache counters
+     */
+    VerificationCache::Stats verification_cache_stats() const;
     
     /**
      * Verify token using trust chain model
-     * First verifies the root signature of the license public key,
-     * then verifies the token signature using the verified license public key
+     * Uses the root anchors of TrustAnchorStore::instance(), which are parsed
+     * once per process. The root signature over the license public key is
+     * checked by the SDK during activation, not here.
+     * Static, so callers do not need a TokenManager instance.
      * @param token Token to verify
-     * @param root_public_key Root public key for verifying license public key signature
-     * @return true if both signatures are valid
+     * @return true if the token is anchored in a trusted root key
      */
-    bool verify_token_trust_chain(const Token& token) const;
+    static bool verify_token_trust_chain(const Token& token);
     
     /**
      * Request token transfer to another device
@@ -211,6 +291,8 @@ public:
     
     /**
      * Check and update token expiration status
+     * Not needed for expiry notifications: set_token arms a timer on
+     * TimerScheduler::instance() that fires when the token expires.
      */
     void check_expiration();
     
@@ -221,13 +303,6 @@ public:
      */
     void set_public_key(SigningAlgorithm algorithm, const std::string& public_key);
     
-    /**
-     * Get verifier for a specific algorithm
-     * @param algorithm The signing algorithm
-     * @return Pointer to the verifier
-     */
-    std::shared_ptr<SignatureVerifier> get_verifier(SigningAlgorithm algorithm) const;
-    
     /**
      * Generate a unique token ID
      * @return Token ID string
@@ -239,14 +314,14 @@ public:
      * @param token The token to create signature data for
      * @return Signature data string
      */
-    std::string create_signature_data(const Token& token) const;
+    static std::string create_signature_data(const Token& token);
 
     /**
      * Create signature data for state chain
      * @param token The token to create state signature data for
      * @return State signature data string
      */
-    std::string create_state_signature_data(const Token& token) const;
+    static std::string create_state_signature_data(const Token& token);
 
     /**
      * Migrate token state
@@ -282,25 +357,26 @@ private:
      * @param status New token status
      */
     void notify_token_change(TokenStatus status);
+
+    // Arm expiry_timer_ for a token expiring at expire_time (Unix seconds)
+    void schedule_expiry_check(uint64_t expire_time);
+    void handle_expiry_timer();
     
-    std::optional<Token> current_token_;
+    // Read lock-free; token_mutex_ serializes changes and their notifications
+    SnapshotCell<Token> current_token_;
     mutable std::mutex token_mutex_;
+    LicenseState license_state_;            // Mirrors current_token_
+    TimerScheduler::TimerId expiry_timer_ = 0;  // Guarded by token_mutex_
     
     TokenChangeCallback token_callback_;
     mutable std::mutex callback_mutex_;
     
-    // Verifiers for different algorithms
-    std::shared_ptr<SignatureVerifier> rsa_verifier_;
-    std::shared_ptr<SignatureVerifier> ed25519_verifier_;
-    std::shared_ptr<SignatureVerifier> sm2_verifier_;
-    
     // Public keys for different algorithms
     std::unordered_map<SigningAlgorithm, std::string> public_keys_;
     mutable std::mutex keys_mutex_;
     
-    // Verification cache: token_id -> (verification_result, expiration_time)
-    mutable std::unordered_map<std::string, std::pair<bool, std::chrono::steady_clock::time_point>> verification_cache_;
-    mutable std::mutex cache_mutex_;
+    // Verification results keyed by (algorithm, key, signed data, signature)
+    mutable VerificationCache verification_cache_;
 };
 
 } // namespace decentrilicense
@@ -0,0 +1,122 @@
+#ifndef DECENTRILICENSE_TRUST_ANCHOR_STORE_HPP
+#define DECENTRILICENSE_TRUST_ANCHOR_STORE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "crypto_utils.hpp"
+#include "key_cache.hpp"
+
+namespace decentrilicense {
+
+// A public key trusted to sign tokens or other keys
+struct TrustAnchor {
+    enum class Kind : uint8_t {
+        Root,       // Signs product keys (ROOT_PUBLIC_KEY and its successors)
+        Product     // Product public key registered by a client
+    };
+
+    Kind kind;
+    std::string public_key_pem;                 // As registered
+    KeyHandle key;                              // Parsed once, default library context
+    std::optional<SigningAlgorithm> algorithm;  // Derived from the key type
+};
+
+/**
+ * TrustAnchorStore - Process-wide set of trusted root and product keys
+ *
+ * The built-in ROOT_PUBLIC_KEY is parsed once, when the store is first used.
+ * More anchors can be added, e.g. the next root key during a key rotation.
+ * Every change publishes a new immutable Snapshot with a single atomic
+ * store, so readers never lock and never see a half-updated set. Published
+ * snapshots are kept until the process exits, so a reference returned by
+ * snapshot() never dangles.
+ *
+ * All functions are thread-safe; reads are lock-free
+ */
+class TrustAnchorStore {
+public:
+    class Snapshot {
+    public:
+        const std::vector<TrustAnchor>& anchors() const { return anchors_; }
+
+        /**
+         * Check whether any anchor of a kind is present
+         */
+        bool has(TrustAnchor::Kind kind) const;
+
+        /**
+         * Find an anchor by its PEM
+         * @return Anchor, or nullptr if the key is not trusted
+         */
+        const TrustAnchor* find(TrustAnchor::Kind kind, std::string_view public_key_pem) const;
+
+        /**
+         * Verify a signature against every anchor of a kind, so signatures
+         * from both the old and the new key are accepted during a rotation
+         * @param kind Anchor kind
+         * @param data Signed data
+         * @param size Size of data in bytes
+         * @param signature Raw signature bytes
+         * @param signature_size Size of the signature in bytes
+         * @return true if any anchor of the kind verifies the signature
+         */
+        bool verify(TrustAnchor::Kind kind, const uint8_t* data, size_t size,
+                    const uint8_t* signature, size_t signature_size) const;
+
+    private:
+        friend class TrustAnchorStore;
+        std::vector<TrustAnchor> anchors_;
+    };
+
+    /**
+     * Process-wide store, holding ROOT_PUBLIC_KEY as its first root anchor
+     */
+    static TrustAnchorStore& instance();
+
+    // Non-copyable
+    TrustAnchorStore(const TrustAnchorStore&) = delete;
+    TrustAnchorStore& operator=(const TrustAnchorStore&) = delete;
+
+    /**
+     * Current set of anchors
+     * @return Snapshot, valid for the lifetime of the process
+     */
+    const Snapshot& snapshot() const {
+        return *current_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Add an anchor
+     * @param kind Anchor kind
+     * @param public_key_pem Public key in PEM format
+     * @return true if the key is now trusted (added or already present),
+     *         false if it cannot be parsed
+     */
+    bool add(TrustAnchor::Kind kind, const std::string& public_key_pem);
+
+    /**
+     * Remove an anchor, e.g. a retired root key at the end of a rotation
+     * @return true if an anchor was removed
+     */
+    bool remove(TrustAnchor::Kind kind, const std::string& public_key_pem);
+
+private:
+    TrustAnchorStore();
+
+    void publish_locked(std::unique_ptr<Snapshot> next);
+
+    std::atomic<const Snapshot*> current_;
+    std::mutex write_mutex_;
+    std::vector<std::unique_ptr<const Snapshot>> published_;   // Guarded by write_mutex_
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_TRUST_ANCHOR_STORE_HPP
@@ -0,0 +1,114 @@
+#ifndef DECENTRILICENSE_VERIFICATION_CACHE_HPP
+#define DECENTRILICENSE_VERIFICATION_CACHE_HPP
+
+#include <string>
+#include <optional>
+#include <mutex>
+#include <list>
+#include <array>
+#include <chrono>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "crypto_utils.hpp"
+
+namespace decentrilicense {
+
+/**
+ * VerificationCache - Sharded, bounded LRU cache of signature check results
+ *
+ * Entries are content addressed: the key covers the algorithm, a fingerprint
+ * of the public key, the digest of the signed bytes and the signature
+ * itself. Two tokens only share an entry if verifying them is the same
+ * operation. Failed verifications are cached as well.
+ *
+ * Each shard has its own lock and LRU list. Expired entries are dropped
+ * when they are looked up or when they reach the tail of their shard.
+ *
+ * All functions are thread-safe
+ */
+class VerificationCache {
+public:
+    static constexpr size_t kDefaultCapacity = 4096;
+    static constexpr size_t kShardCount = 16;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;     // Entries dropped for capacity or expiry
+        size_t size = 0;
+        size_t capacity = 0;
+    };
+
+    /**
+     * Create a cache
+     * @param capacity Maximum number of entries over all shards (0 disables caching)
+     */
+    explicit VerificationCache(size_t capacity = kDefaultCapacity);
+
+    // Non-copyable
+    VerificationCache(const VerificationCache&) = delete;
+    VerificationCache& operator=(const VerificationCache&) = delete;
+
+    /**
+     * Build the cache key for a verification
+     * @param algorithm Signing algorithm
+     * @param public_key_pem Public key in PEM format
+     * @param signed_data Data covered by the signature
+     * @param signature Signature as carried by the token
+     * @return Cache key
+     */
+    static std::string make_key(SigningAlgorithm algorithm,
+                                const std::string& public_key_pem,
+                                const std::string& signed_data,
+                                const std::string& signature);
+
+    /**
+     * Look up a cached result
+     * @param key Key from make_key()
+     * @return Cached result, or nullopt on a miss or expired entry
+     */
+    std::optional<bool> lookup(const std::string& key);
+
+    /**
+     * Store a verification result
+     * @param key Key from make_key()
+     * @param result Verification result (negative results are cached too)
+     * @param ttl Time the entry stays valid
+     */
+    void store(const std::string& key, bool result, std::chrono::seconds ttl);
+
+    /**
+     * Remove all entries
+     */
+    void clear();
+
+    Stats stats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        bool result;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> lru;  // Most recently used at the front
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    Shard& shard_for(const std::string& key);
+    void trim_locked(Shard& shard, std::chrono::steady_clock::time_point now);
+
+    std::array<Shard, kShardCount> shards_;
+    size_t capacity_;
+    size_t shard_capacity_;
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_VERIFICATION_CACHE_HPP
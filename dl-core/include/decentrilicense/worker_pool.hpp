@@ -0,0 +1,68 @@
+#ifndef DECENTRILICENSE_WORKER_POOL_HPP
+#define DECENTRILICENSE_WORKER_POOL_HPP
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
+
+namespace decentrilicense {
+
+/**
+ * WorkerPool - Fixed-size pool of threads for CPU-bound batch work
+ *
+ * Used by the batch verification paths to spread signature checks over all
+ * cores. The calling thread always takes part in parallel_for(), so a pool
+ * with zero workers degrades to a plain loop on the caller.
+ *
+ * Thread-safe operations
+ */
+class WorkerPool {
+public:
+    /**
+     * Create a pool
+     * @param num_threads Number of worker threads, 0 = hardware concurrency - 1
+     */
+    explicit WorkerPool(size_t num_threads = 0);
+    ~WorkerPool();
+
+    // Non-copyable
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * Process-wide pool, created on first use
+     */
+    static WorkerPool& shared();
+
+    /**
+     * Run fn over [0, count) split into chunks, blocking until all chunks
+     * have completed. Chunks are contiguous ranges [begin, end).
+     * @param count Number of items
+     * @param min_chunk Smallest range handed to a single invocation
+     * @param fn Function called as fn(begin, end)
+     */
+    void parallel_for(size_t count, size_t min_chunk,
+                      const std::function<void(size_t begin, size_t end)>& fn);
+
+    /**
+     * Number of worker threads (not counting the caller)
+     */
+    size_t size() const { return workers_.size(); }
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_WORKER_POOL_HPP
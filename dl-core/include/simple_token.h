@@ -3,10 +3,16 @@
 
 #include <string>
 #include <cstdint>
+#include <chrono>
 #include <sstream>
+#include "decentrilicense/token_json.hpp"
 
 namespace decentrilicense {
 
+// Inline namespace keeps this Token's symbols apart from the full Token in
+// token_manager.hpp, so linking against the library cannot mix them up
+inline namespace simple {
+
 // Simplified Token structure with state chain fields
 struct Token {
     std::string token_id;                   // UUID
@@ -62,9 +68,35 @@ struct Token {
     }
     
     // 从JSON字符串创建Token对象的静态方法
-    static Token from_json(const std::string& json_str);
+    // Returns an empty (invalid) token if json_str is malformed
+    static Token from_json(const std::string& json_str) {
+        Token token{};
+        TokenJsonView view;
+        if (!parse_token_json(json_str, view)) {
+            return token;
+        }
+        token.token_id = view.token_id.str();
+        token.holder_device_id = view.holder_device_id.str();
+        token.license_code = view.license_code.str();
+        token.issue_time = view.issue_time;
+        token.expire_time = view.expire_time;
+        token.signature = view.signature.str();
+        token.alg = view.alg.str();
+        token.app_id = view.app_id.str();
+        token.environment_hash = view.environment_hash.str();
+        token.license_public_key = view.license_public_key.str();
+        token.root_signature = view.root_signature.str();
+        token.encrypted_license_private_key = view.encrypted_license_private_key.str();
+        token.state_index = view.state_index;
+        token.prev_state_hash = view.prev_state_hash.str();
+        token.state_payload = view.state_payload.str();
+        token.state_signature = view.state_signature.str();
+        return token;
+    }
 };
 
+} // namespace simple
+
 } // namespace decentrilicense
 
 #endif // SIMPLE_TOKEN_H
\ No newline at end of file
@@ -2,12 +2,19 @@
 #define STATE_CHAIN_STORAGE_H
 
 #include "decentrilicense/token_manager.hpp"
+#include "decentrilicense/timer_scheduler.hpp"
+#include "chain_log_reader.h"
 #include <string>
 #include <vector>
 #include <optional>
 #include <fstream>
 #include <filesystem>
 #include <cstring>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace decentrilicense {
 
@@ -16,31 +23,102 @@ struct ChainMetadata {
     uint64_t total_states = 0;
     uint64_t last_verification_time = 0;
     std::string license_id;
+    uint64_t log_size = 0;      // chain_log.bin字节数，写该检查点时的日志长度
 };
 
+// 活动段默认的大小上限
+constexpr uint64_t kDefaultChainSegmentSize = 64ull << 20;
+
+// 链日志的持久化级别
+enum class ChainDurability {
+    None,               // 记录缓存在进程内，检查点、读取或缓冲区满时写出；进程崩溃会丢失
+    OsBuffered,         // 每条记录写入操作系统后返回（默认）；断电可能丢失
+    SyncEachRecord,     // 每条记录fdatasync后返回
+    GroupCommit         // 等待中的追加合并为一次fdatasync，落盘后返回
+};
+
+struct DurabilityOptions {
+    ChainDurability level = ChainDurability::OsBuffered;
+    // GroupCommit：攒够这么多条未同步记录，或最早一条已等待group_commit_delay时同步
+    // 延迟为0（默认）时立即同步，只合并同步进行期间到达的追加；
+    // 延迟大于0时每次同步合并更多记录，但单独追加的线程也要等满延迟
+    size_t group_commit_records = 64;
+    std::chrono::milliseconds group_commit_delay{0};
+};
+
+// 链日志分段：chain_log.bin是活动段，超过大小上限时封存为chain_log.<段号>.bin
+// （连同索引），新段以快照记录开头。快照记录保存链头状态和上一段文件的SHA-256，
+// 因此读取和验证可以从最新快照开始，各段的摘要首尾相连。
+// 封存的段可以归档到backup目录或直接删除（压缩），不影响从快照开始的验证。
 class StateChainStorage {
 public:
     // 初始化，指定存储根目录（如 ~/.appname/chains/）
     explicit StateChainStorage(const std::string& storage_root);
+
+    // 为所有打开的链写检查点
+    ~StateChainStorage();
+
+    // Non-copyable
+    StateChainStorage(const StateChainStorage&) = delete;
+    StateChainStorage& operator=(const StateChainStorage&) = delete;
     
     // 保存完整状态链（首次或全量备份）
     bool saveFullChain(const std::string& license_id, 
                        const std::vector<Token>& chain);
     
-    // 追加一个状态到链尾（高效，仅追加日志）
+    // 追加一个状态到链尾（高效，每次只写一次链日志）
+    // 日志句柄保持打开；当前状态、元数据和索引项缓存在内存中，
+    // 每kCheckpointAppends次追加或首次未保存追加kCheckpointDelay后写检查点
+    // 活动段达到大小上限时先封存，新段以快照开头
     bool appendState(const std::string& license_id, 
                      const Token& new_state);
+
+    // 立即写检查点：current_state.json、chain_meta.json和待写的索引项
+    bool checkpoint(const std::string& license_id);
+
+    // 设置持久化级别，对之后的追加生效
+    // SyncEachRecord和GroupCommit下，其他文件也先同步再重命名，重命名后同步目录
+    void setDurability(const DurabilityOptions& options);
+    DurabilityOptions durability() const;
+
+    // 设置活动段的大小上限（字节），0表示不分段
+    void setMaxSegmentSize(uint64_t bytes);
+
+    // 立即封存活动段，以链头状态的快照开始新段
+    bool snapshotChain(const std::string& license_id);
+
+    // 已封存且仍在链目录中的段号，升序
+    std::vector<uint64_t> listSegments(const std::string& license_id);
+
+    // 把封存的段移到backup目录，返回移走的段数
+    // backup中已有同名段时不覆盖，该段留在链目录中
+    size_t archiveSegments(const std::string& license_id);
+
+    // 删除封存的段，只保留从最新快照开始的活动段，返回删除的段数
+    // 活动段不以有效快照开头时不删除任何段
+    size_t compactChain(const std::string& license_id);
     
-    // 从持久化存储加载完整状态链
+    // 从持久化存储加载状态链，从最新快照（活动段开头）开始
     std::vector<Token> loadChain(const std::string& license_id);
     
     // 获取当前最新状态（快速读取，不加载完整链）
+    // 检查点落后于日志时（如进程在写检查点前退出）以日志最后一条为准
     std::optional<Token> getCurrentState(const std::string& license_id);
+
+    // Open the chain log for random access (memory-mapped, see ChainLogReader)
+    // A torn tail left by an interrupted append is truncated first
+    // Returns nullptr if the chain has no log
+    std::unique_ptr<ChainLogReader> openChainReader(const std::string& license_id);
+
+    // Load a single state by state_index without reading the rest of the chain
+    // States before the latest snapshot are looked up in the sealed segments
+    std::optional<Token> loadState(const std::string& license_id, uint64_t state_index);
     
-    // 验证存储的链完整性（从头验证所有签名和哈希）
+    // 验证存储的链完整性（从最新快照验证所有签名和哈希，
+    // 并核对仍在链目录中的封存段与后一段快照中的摘要）
     bool verifyStoredChain(const std::string& license_id);
     
-    // 恢复损坏的链数据
+    // 恢复损坏的链数据，优先从最新快照开始的日志恢复
     bool recoverChain(const std::string& license_id);
 
     // Device key persistence methods
@@ -65,6 +143,9 @@ private:
     std::string getChainDir(const std::string& license_id) const;
     std::string getGenesisTokenPath(const std::string& license_id) const;
     std::string getChainLogPath(const std::string& license_id) const;
+    std::string getChainIndexPath(const std::string& license_id) const;
+    std::string getSegmentPath(const std::string& license_id, uint64_t segment) const;
+    std::string getSegmentIndexPath(const std::string& license_id, uint64_t segment) const;
     std::string getCurrentStatePath(const std::string& license_id) const;
     std::string getMetadataPath(const std::string& license_id) const;
     std::string getBackupPath(const std::string& license_id) const;
@@ -74,12 +155,12 @@ private:
     std::string getDevicePublicKeyPath(const std::string& license_id) const;
     std::string getDeviceIdPath(const std::string& license_id) const;
 
-    // 二进制序列化和反序列化
+    // 二进制序列化和反序列化（链日志）
     std::vector<uint8_t> serializeToken(const Token& token) const;
     Token deserializeToken(const std::vector<uint8_t>& data) const;
-    
-    // 计算校验和
-    uint32_t calculateChecksum(const std::vector<uint8_t>& data) const;
+
+    // genesis_token.json和current_state.json保持JSON，外部工具和旧版本可直接读取
+    std::vector<uint8_t> serializeTokenJson(const Token& token) const;
     
     // 原子写入文件
     bool atomicWriteFile(const std::string& filepath, const std::vector<uint8_t>& data) const;
@@ -95,8 +176,33 @@ private:
     
     // 加载元数据
     std::optional<ChainMetadata> loadMetadata(const std::string& license_id);
+
+    // 追加中的链：打开的日志句柄及尚未写回的派生数据，见state_chain_storage.cpp
+    struct OpenChain;
+
+    // 以下均需持有chains_mutex_
+    std::shared_ptr<OpenChain> openChain(const std::string& license_id);
+    bool writeCheckpoint(const std::string& license_id, OpenChain& chain);
+    bool flushLog(OpenChain& chain);
+    bool flushIndex(const std::string& license_id, OpenChain& chain);
+    void closeChain(const std::string& license_id, const OpenChain* expected = nullptr);
+    bool waitForGroupCommit(std::unique_lock<std::mutex>& lock, const std::string& license_id,
+                            const std::shared_ptr<OpenChain>& chain, uint64_t record);
+    bool sealSegment(std::unique_lock<std::mutex>& lock, const std::string& license_id, OpenChain& chain,
+                     uint64_t min_size);
+    void finishSegmentRotation(const std::string& license_id);
+
+    std::unique_ptr<ChainLogReader> openChainReaderLocked(const std::string& license_id);
     
     std::string storage_root_;
+
+    mutable std::mutex chains_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<OpenChain>> open_chains_;
+    DurabilityOptions durability_;
+    uint64_t max_segment_size_ = kDefaultChainSegmentSize;
+    // 已随链关闭但尚未触发的检查点定时器；触发时自行移除，析构时等待
+    std::vector<TimerScheduler::TimerId> detached_timers_;
+    std::atomic<bool> sync_files_{false};   // 写文件时是否同步到磁盘
 };
 
 } // namespace decentrilicense
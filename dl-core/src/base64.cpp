@@ -0,0 +1,396 @@
+#include "decentrilicense/base64.hpp"
+#include <array>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define DL_BASE64_X86 1
+#include <immintrin.h>
+#endif
+
+namespace decentrilicense {
+
+namespace {
+
+constexpr char kStandardChars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr char kUrlChars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+constexpr std::array<int8_t, 256> make_decode_table(bool url) {
+    std::array<int8_t, 256> table{};
+    for (size_t i = 0; i < table.size(); ++i) {
+        table[i] = -1;
+    }
+    for (int i = 0; i < 64; ++i) {
+        table[static_cast<unsigned char>(kStandardChars[i])] = static_cast<int8_t>(i);
+    }
+    if (url) {
+        // The URL decoder also accepts the standard alphabet
+        table[static_cast<unsigned char>('-')] = 62;
+        table[static_cast<unsigned char>('_')] = 63;
+    }
+    return table;
+}
+
+constexpr std::array<int8_t, 256> kStandardDecode = make_decode_table(false);
+constexpr std::array<int8_t, 256> kUrlDecode = make_decode_table(true);
+
+// Kernels process a prefix of whole groups and return how much input they
+// consumed (a multiple of 3 bytes for encode, 4 characters for decode). The
+// caller finishes the rest with the scalar code, which also pinpoints any
+// invalid character that made a decode kernel stop early.
+using EncodeKernel = size_t (*)(const uint8_t* in, size_t size, char* out, bool url);
+using DecodeKernel = size_t (*)(const char* in, size_t size, uint8_t* out, bool url);
+
+size_t encode_kernel_scalar(const uint8_t*, size_t, char*, bool) {
+    return 0;
+}
+
+size_t decode_kernel_scalar(const char*, size_t, uint8_t*, bool) {
+    return 0;
+}
+
+#ifdef DL_BASE64_X86
+
+// Encoding: split 12 input bytes per 128-bit lane into 16 6-bit indices,
+// then map indices to ASCII by adding a per-range offset.
+__attribute__((target("sse4.1")))
+inline __m128i enc_reshuffle_sse(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+__attribute__((target("sse4.1")))
+inline __m128i enc_translate_sse(__m128i in, bool url) {
+    const __m128i lut = url
+        ? _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 0, 0)
+        : _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    __m128i indices = _mm_subs_epu8(in, _mm_set1_epi8(51));
+    const __m128i mask = _mm_cmpgt_epi8(in, _mm_set1_epi8(25));
+    indices = _mm_sub_epi8(indices, mask);
+    return _mm_add_epi8(in, _mm_shuffle_epi8(lut, indices));
+}
+
+__attribute__((target("sse4.1")))
+size_t encode_kernel_sse41(const uint8_t* in, size_t size, char* out, bool url) {
+    size_t i = 0;
+    // Each step reads 16 bytes and consumes 12
+    while (size - i >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        v = enc_translate_sse(enc_reshuffle_sse(v), url);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+        out += 16;
+        i += 12;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+inline __m256i enc_reshuffle_avx2(__m256i in) {
+    in = _mm256_shuffle_epi8(in, _mm256_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+    const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+    const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    return _mm256_or_si256(t1, t3);
+}
+
+__attribute__((target("avx2")))
+inline __m256i enc_translate_avx2(__m256i in, bool url) {
+    const __m256i lut = url
+        ? _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 0, 0,
+                           65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 0, 0)
+        : _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+                           65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    __m256i indices = _mm256_subs_epu8(in, _mm256_set1_epi8(51));
+    const __m256i mask = _mm256_cmpgt_epi8(in, _mm256_set1_epi8(25));
+    indices = _mm256_sub_epi8(indices, mask);
+    return _mm256_add_epi8(in, _mm256_shuffle_epi8(lut, indices));
+}
+
+__attribute__((target("avx2")))
+size_t encode_kernel_avx2(const uint8_t* in, size_t size, char* out, bool url) {
+    size_t i = 0;
+    // Each step reads 28 bytes (two overlapping 16-byte loads) and consumes 24
+    while (size - i >= 28) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 12));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        v = enc_translate_avx2(enc_reshuffle_avx2(v), url);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v);
+        out += 32;
+        i += 24;
+    }
+    return encode_kernel_sse41(in + i, size - i, out, url) + i;
+}
+
+// Decoding: classify every character through two nibble lookups (any
+// invalid character sets a bit shared by its high and low nibble entries),
+// add a per-range offset to get its 6-bit value, then pack four values into
+// three bytes. The URL alphabet is first folded onto the standard one.
+__attribute__((target("sse4.1")))
+size_t decode_kernel_sse41(const char* in, size_t size, uint8_t* out, bool url) {
+    const __m128i lut_lo = _mm_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi = _mm_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_2f = _mm_set1_epi8(0x2f);
+
+    size_t i = 0;
+    // Each step stores 16 bytes of which 12 are valid, so keep enough input
+    // behind the block for the overhang to land inside the output
+    while (size - i >= 24) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        if (url) {
+            c = _mm_add_epi8(c, _mm_and_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('-')), _mm_set1_epi8('+' - '-')));
+            c = _mm_add_epi8(c, _mm_and_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('_')), _mm_set1_epi8('/' - '_')));
+        }
+
+        const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(c, 4), mask_2f);
+        const __m128i lo_nibbles = _mm_and_si128(c, mask_2f);
+        const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+        const __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+        if (!_mm_testz_si128(lo, hi)) {
+            break;
+        }
+        const __m128i eq_2f = _mm_cmpeq_epi8(c, mask_2f);
+        const __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+        const __m128i v = _mm_add_epi8(c, roll);
+
+        const __m128i ab_bc = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+        __m128i packed = _mm_madd_epi16(ab_bc, _mm_set1_epi32(0x00011000));
+        packed = _mm_shuffle_epi8(packed, _mm_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+        out += 12;
+        i += 16;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+size_t decode_kernel_avx2(const char* in, size_t size, uint8_t* out, bool url) {
+    const __m256i lut_lo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+
+    size_t i = 0;
+    // Each step stores 32 bytes of which 24 are valid
+    while (size - i >= 48) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        if (url) {
+            c = _mm256_add_epi8(c, _mm256_and_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('-')),
+                                                    _mm256_set1_epi8('+' - '-')));
+            c = _mm256_add_epi8(c, _mm256_and_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')),
+                                                    _mm256_set1_epi8('/' - '_')));
+        }
+
+        const __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(c, 4), mask_2f);
+        const __m256i lo_nibbles = _mm256_and_si256(c, mask_2f);
+        const __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        const __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+        if (!_mm256_testz_si256(lo, hi)) {
+            break;
+        }
+        const __m256i eq_2f = _mm256_cmpeq_epi8(c, mask_2f);
+        const __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+        const __m256i v = _mm256_add_epi8(c, roll);
+
+        const __m256i ab_bc = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        __m256i packed = _mm256_madd_epi16(ab_bc, _mm256_set1_epi32(0x00011000));
+        packed = _mm256_shuffle_epi8(packed, _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), packed);
+        out += 24;
+        i += 32;
+    }
+    return decode_kernel_sse41(in + i, size - i, out, url) + i;
+}
+
+#endif // DL_BASE64_X86
+
+struct Kernels {
+    EncodeKernel encode;
+    DecodeKernel decode;
+    const char* name;
+};
+
+Kernels select_kernels() {
+#ifdef DL_BASE64_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Kernels{encode_kernel_avx2, decode_kernel_avx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return Kernels{encode_kernel_sse41, decode_kernel_sse41, "sse4.1"};
+    }
+#endif
+    return Kernels{encode_kernel_scalar, decode_kernel_scalar, "scalar"};
+}
+
+const Kernels& kernels() {
+    static const Kernels selected = select_kernels();
+    return selected;
+}
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+} // namespace
+
+size_t Base64::encoded_length(size_t size, Alphabet alphabet) {
+    if (alphabet == Alphabet::Url) {
+        return size / 3 * 4 + (size % 3 == 0 ? 0 : size % 3 + 1);
+    }
+    return (size + 2) / 3 * 4;
+}
+
+size_t Base64::decoded_max_length(size_t size) {
+    return (size + 3) / 4 * 3;
+}
+
+size_t Base64::encode(const uint8_t* data, size_t size, char* out, Alphabet alphabet) {
+    const bool url = alphabet == Alphabet::Url;
+    const char* chars = url ? kUrlChars : kStandardChars;
+
+    size_t i = kernels().encode(data, size, out, url);
+    char* p = out + i / 3 * 4;
+
+    for (; size - i >= 3; i += 3) {
+        const uint32_t n = (static_cast<uint32_t>(data[i]) << 16) |
+                           (static_cast<uint32_t>(data[i + 1]) << 8) |
+                           data[i + 2];
+        *p++ = chars[(n >> 18) & 0x3f];
+        *p++ = chars[(n >> 12) & 0x3f];
+        *p++ = chars[(n >> 6) & 0x3f];
+        *p++ = chars[n & 0x3f];
+    }
+
+    const size_t rest = size - i;
+    if (rest > 0) {
+        uint32_t n = static_cast<uint32_t>(data[i]) << 16;
+        if (rest == 2) {
+            n |= static_cast<uint32_t>(data[i + 1]) << 8;
+        }
+        *p++ = chars[(n >> 18) & 0x3f];
+        *p++ = chars[(n >> 12) & 0x3f];
+        if (rest == 2) {
+            *p++ = chars[(n >> 6) & 0x3f];
+        } else if (!url) {
+            *p++ = '=';
+        }
+        if (!url) {
+            *p++ = '=';
+        }
+    }
+    return static_cast<size_t>(p - out);
+}
+
+bool Base64::decode(std::string_view in, uint8_t* out, size_t* out_size, Alphabet alphabet) {
+    const bool url = alphabet == Alphabet::Url;
+    const std::array<int8_t, 256>& table = url ? kUrlDecode : kStandardDecode;
+
+    while (!in.empty() && is_space(in.back())) {
+        in.remove_suffix(1);
+    }
+
+    size_t n = in.size();
+    size_t pad = 0;
+    if (n >= 1 && in[n - 1] == '=') {
+        pad++;
+        if (n >= 2 && in[n - 2] == '=') {
+            pad++;
+        }
+    }
+    // Standard input must be padded; URL input may or may not be
+    if ((!url || pad > 0) && n % 4 != 0) {
+        return false;
+    }
+    n -= pad;
+    if (n % 4 == 1) {
+        return false;
+    }
+
+    const size_t full = n - n % 4;
+    size_t i = kernels().decode(in.data(), full, out, url);
+    uint8_t* p = out + i / 4 * 3;
+
+    for (; i < full; i += 4) {
+        const int a = table[static_cast<unsigned char>(in[i])];
+        const int b = table[static_cast<unsigned char>(in[i + 1])];
+        const int c = table[static_cast<unsigned char>(in[i + 2])];
+        const int d = table[static_cast<unsigned char>(in[i + 3])];
+        if ((a | b | c | d) < 0) {
+            return false;
+        }
+        const uint32_t v = (static_cast<uint32_t>(a) << 18) | (static_cast<uint32_t>(b) << 12) |
+                           (static_cast<uint32_t>(c) << 6) | static_cast<uint32_t>(d);
+        *p++ = static_cast<uint8_t>(v >> 16);
+        *p++ = static_cast<uint8_t>(v >> 8);
+        *p++ = static_cast<uint8_t>(v);
+    }
+
+    const size_t rest = n - full;
+    if (rest > 0) {
+        const int a = table[static_cast<unsigned char>(in[i])];
+        const int b = table[static_cast<unsigned char>(in[i + 1])];
+        const int c = rest == 3 ? table[static_cast<unsigned char>(in[i + 2])] : 0;
+        if ((a | b | c) < 0) {
+            return false;
+        }
+        const uint32_t v = (static_cast<uint32_t>(a) << 18) | (static_cast<uint32_t>(b) << 12) |
+                           (static_cast<uint32_t>(c) << 6);
+        *p++ = static_cast<uint8_t>(v >> 16);
+        if (rest == 3) {
+            *p++ = static_cast<uint8_t>(v >> 8);
+        }
+    }
+
+    *out_size = static_cast<size_t>(p - out);
+    return true;
+}
+
+std::string Base64::encode(const uint8_t* data, size_t size, Alphabet alphabet) {
+    std::string out(encoded_length(size, alphabet), '\0');
+    out.resize(encode(data, size, &out[0], alphabet));
+    return out;
+}
+
+std::vector<uint8_t> Base64::decode(std::string_view in, Alphabet alphabet) {
+    std::vector<uint8_t> out(decoded_max_length(in.size()));
+    size_t size = 0;
+    if (!decode(in, out.data(), &size, alphabet)) {
+        return std::vector<uint8_t>();
+    }
+    out.resize(size);
+    return out;
+}
+
+const char* Base64::implementation() {
+    return kernels().name;
+}
+
+} // namespace decentrilicense
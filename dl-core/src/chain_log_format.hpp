@@ -0,0 +1,133 @@
+#ifndef DECENTRILICENSE_CHAIN_LOG_FORMAT_HPP
+#define DECENTRILICENSE_CHAIN_LOG_FORMAT_HPP
+
+// Internal header: on-disk format of chain_log.bin and of chain_log.idx, its
+// sidecar index, shared by StateChainStorage and ChainLogReader. Not
+// installed.
+//
+// chain_log.bin is a sequence of records. Records are written framed:
+//   u32 magic "DLCR" | u8 version (1) | u8 flags | u16 reserved (0)
+//   | u32 length | u32 crc32c | length bytes of serialized token
+//   | u32 commit marker "DLCM", present if flags & kChainRecordCommitted
+// The CRC-32C covers the version, flags, reserved and length fields and the
+// token bytes. Logs written before framing hold legacy records, which are
+// still read (also mixed with framed ones, when appended to):
+//   u32 length | length bytes of serialized token | u32 byte sum
+// A legacy record never starts with the framed magic, as that length would
+// exceed 1 GiB.
+//
+// A log can be split into segments (see StateChainStorage): chain_log.bin is
+// the active one, earlier ones are sealed as chain_log.<segment>.bin with
+// their index. Every segment after the first starts with a snapshot record,
+// a framed record with kChainRecordSnapshot set whose token bytes are
+// preceded by
+//   u32 snapshot version (1) | u32 reserved (0) | u64 segment number
+//   | 32 bytes SHA-256 of the previous segment file
+// The token is the state the previous segment ended with, so a segment can
+// be read and verified on its own, and the digests link the segments.
+//
+// chain_log.idx is a 16-byte header followed by one fixed-size entry per
+// record, in log order:
+//   "DLIX" | u32 version (2) | u32 entry size (32) | u32 reserved (0)
+// All integers are stored in host byte order, like the log itself; every
+// supported target is little-endian.
+
+#include "chain_log_reader.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace decentrilicense {
+
+constexpr uint32_t kChainRecordMagic = 0x52434C44;     // "DLCR"
+constexpr uint8_t kChainRecordVersion = 1;
+constexpr uint8_t kChainRecordCommitted = 0x01;         // Flag: commit marker follows the token
+constexpr uint8_t kChainRecordSnapshot = 0x02;          // Flag: snapshot header precedes the token
+constexpr uint32_t kChainCommitMarker = 0x4D434C44;     // "DLCM"
+constexpr size_t kChainRecordHeaderSize = 16;
+constexpr size_t kLegacyChainRecordOverhead = 2 * sizeof(uint32_t);
+constexpr uint32_t kChainSnapshotVersion = 1;
+constexpr size_t kChainSnapshotHeaderSize = 48;
+
+struct ChainRecord {
+    std::string_view data;      // Serialized token, inside the parsed buffer
+    uint32_t checksum = 0;      // CRC-32C, or byte sum for a legacy record
+    uint64_t size = 0;          // Whole record in the log, framing included
+    std::optional<ChainSnapshot> snapshot;  // Set for a snapshot record
+};
+
+enum class ChainRecordStatus {
+    Intact,
+    Truncated,      // Declares more bytes than are available
+    Damaged         // Complete, but fails its checks; record.size is still set
+};
+
+/**
+ * Parse the record at the start of a buffer
+ * @param p Record start
+ * @param available Bytes from p to the end of the log
+ * @param record Filled in for Intact, size also for Damaged
+ */
+ChainRecordStatus parse_chain_record(const uint8_t* p, size_t available, ChainRecord* record);
+
+/**
+ * Append a framed record, with a commit marker, to a buffer
+ * @param data Serialized token
+ * @param size Token size
+ * @param out Buffer to append to
+ * @return Checksum stored in the record
+ */
+uint32_t encode_chain_record(const uint8_t* data, size_t size, std::vector<uint8_t>* out);
+
+/**
+ * Append a framed snapshot record, with a commit marker, to a buffer
+ * @param snapshot Segment number and previous segment digest
+ * @param data Serialized head token
+ * @param size Token size
+ * @param out Buffer to append to
+ * @return Checksum stored in the record
+ */
+uint32_t encode_chain_snapshot(const ChainSnapshot& snapshot, const uint8_t* data, size_t size,
+                               std::vector<uint8_t>* out);
+
+/**
+ * Checksum of legacy records
+ */
+uint32_t legacy_chain_record_checksum(const uint8_t* data, size_t size);
+
+struct ChainIndexEntry {
+    uint64_t state_index;       // Token::state_index of the record
+    uint64_t offset;            // Start of the record in the log
+    uint32_t size;              // Whole record in the log, framing included
+    uint32_t checksum;          // Copied from the record
+    uint64_t timestamp;         // Unix seconds the state was appended, 0 if unknown
+};
+static_assert(sizeof(ChainIndexEntry) == 32, "ChainIndexEntry is an on-disk layout");
+
+constexpr char kChainIndexMagic[4] = {'D', 'L', 'I', 'X'};
+constexpr uint32_t kChainIndexVersion = 2;
+constexpr size_t kChainIndexHeaderSize = 16;
+
+/**
+ * Header followed by entries, ready to be written as chain_log.idx
+ */
+std::vector<uint8_t> encode_chain_index(const ChainIndexEntry* entries, size_t count);
+
+/**
+ * Append the entries of records appended to the log, in log order
+ * The index must end where the first record starts, or at the start of a
+ * later one if a reader already indexed some of them (those are skipped).
+ * Otherwise it is stale (e.g. an earlier append was interrupted before its
+ * entry was written) and is removed, so that the next reader rebuilds it
+ * from the log.
+ * Timestamps are raised to the previous entry's if needed, keeping them
+ * non-decreasing for time lookups.
+ * @return false if the index was removed instead
+ */
+bool append_chain_index(const std::string& index_path, const ChainIndexEntry* entries, size_t count);
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_CHAIN_LOG_FORMAT_HPP
@@ -0,0 +1,562 @@
+#include "chain_log_reader.h"
+#include "chain_log_format.hpp"
+#include "decentrilicense/crc32c.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace decentrilicense {
+
+namespace {
+
+// Read-only mapping of a whole file
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            return false;
+        }
+        size_ = static_cast<size_t>(size.QuadPart);
+        if (size_ > 0) {
+            mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping_) {
+                data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+            }
+        }
+        CloseHandle(file);
+        if (size_ > 0 && !data_) {
+            close();
+            return false;
+        }
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                ::close(fd);
+                size_ = 0;
+                return false;
+            }
+            data_ = static_cast<const uint8_t*>(data);
+        }
+        ::close(fd);
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data_) {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_) {
+            CloseHandle(mapping_);
+            mapping_ = nullptr;
+        }
+#else
+        if (data_) {
+            munmap(const_cast<uint8_t*>(data_), size_);
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE mapping_ = nullptr;
+#endif
+};
+
+uint32_t load_u32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+void store_u32(uint8_t* p, uint32_t value) {
+    std::memcpy(p, &value, sizeof(value));
+}
+
+bool write_file_atomically(const std::string& path, const std::vector<uint8_t>& data) {
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file.good()) {
+            file.close();
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+uint32_t legacy_chain_record_checksum(const uint8_t* data, size_t size) {
+    uint32_t checksum = 0;
+    for (size_t i = 0; i < size; ++i) {
+        checksum += data[i];
+    }
+    return checksum;
+}
+
+ChainRecordStatus parse_chain_record(const uint8_t* p, size_t available, ChainRecord* record) {
+    record->snapshot.reset();
+    if (available < sizeof(uint32_t)) {
+        return ChainRecordStatus::Truncated;
+    }
+
+    if (load_u32(p) != kChainRecordMagic) {
+        // Legacy record
+        if (available < kLegacyChainRecordOverhead) {
+            return ChainRecordStatus::Truncated;
+        }
+        const uint32_t length = load_u32(p);
+        if (length > available - kLegacyChainRecordOverhead) {
+            return ChainRecordStatus::Truncated;
+        }
+        record->size = kLegacyChainRecordOverhead + length;
+        const uint8_t* data = p + sizeof(uint32_t);
+        const uint32_t stored = load_u32(data + length);
+        // Tokens are never empty: a zero length is space that was never written
+        if (length == 0 || legacy_chain_record_checksum(data, length) != stored) {
+            return ChainRecordStatus::Damaged;
+        }
+        record->data = std::string_view(reinterpret_cast<const char*>(data), length);
+        record->checksum = stored;
+        return ChainRecordStatus::Intact;
+    }
+
+    if (available < kChainRecordHeaderSize) {
+        return ChainRecordStatus::Truncated;
+    }
+    const uint8_t version = p[4];
+    const uint8_t flags = p[5];
+    const bool reserved_clear = p[6] == 0 && p[7] == 0;
+    uint32_t length = load_u32(p + 8);
+    const uint32_t stored = load_u32(p + 12);
+    const bool committed = (flags & kChainRecordCommitted) != 0;
+    const uint64_t size = kChainRecordHeaderSize + static_cast<uint64_t>(length) + (committed ? sizeof(uint32_t) : 0);
+    if (size > available) {
+        return ChainRecordStatus::Truncated;
+    }
+    record->size = size;
+
+    const uint8_t* data = p + kChainRecordHeaderSize;
+    const bool snapshot = (flags & kChainRecordSnapshot) != 0;
+    if (version != kChainRecordVersion || (flags & ~(kChainRecordCommitted | kChainRecordSnapshot)) != 0 ||
+        !reserved_clear || Crc32c::extend(Crc32c::compute(p + 4, 8), data, length) != stored ||
+        (committed && load_u32(data + length) != kChainCommitMarker) ||
+        (snapshot && (length < kChainSnapshotHeaderSize || load_u32(data) != kChainSnapshotVersion ||
+                      load_u32(data + 4) != 0))) {
+        return ChainRecordStatus::Damaged;
+    }
+    if (snapshot) {
+        ChainSnapshot info;
+        std::memcpy(&info.segment, data + 8, sizeof(info.segment));
+        std::memcpy(info.previous_sha256, data + 16, sizeof(info.previous_sha256));
+        record->snapshot = info;
+        data += kChainSnapshotHeaderSize;
+        length -= static_cast<uint32_t>(kChainSnapshotHeaderSize);
+    }
+    record->data = std::string_view(reinterpret_cast<const char*>(data), length);
+    record->checksum = stored;
+    return ChainRecordStatus::Intact;
+}
+
+namespace {
+
+// Framed record whose payload is prefix followed by the token
+uint32_t encode_framed_record(uint8_t flags, const uint8_t* prefix, size_t prefix_size,
+                              const uint8_t* data, size_t size, std::vector<uint8_t>* out) {
+    const size_t length = prefix_size + size;
+    const size_t start = out->size();
+    out->resize(start + kChainRecordHeaderSize + length + sizeof(uint32_t));
+    uint8_t* p = out->data() + start;
+    store_u32(p, kChainRecordMagic);
+    p[4] = kChainRecordVersion;
+    p[5] = flags;
+    p[6] = 0;
+    p[7] = 0;
+    store_u32(p + 8, static_cast<uint32_t>(length));
+    uint8_t* payload = p + kChainRecordHeaderSize;
+    if (prefix_size > 0) {
+        std::memcpy(payload, prefix, prefix_size);
+    }
+    if (size > 0) {
+        std::memcpy(payload + prefix_size, data, size);
+    }
+    const uint32_t checksum = Crc32c::extend(Crc32c::compute(p + 4, 8), payload, length);
+    store_u32(p + 12, checksum);
+    store_u32(payload + length, kChainCommitMarker);
+    return checksum;
+}
+
+} // namespace
+
+uint32_t encode_chain_record(const uint8_t* data, size_t size, std::vector<uint8_t>* out) {
+    return encode_framed_record(kChainRecordCommitted, nullptr, 0, data, size, out);
+}
+
+uint32_t encode_chain_snapshot(const ChainSnapshot& snapshot, const uint8_t* data, size_t size,
+                               std::vector<uint8_t>* out) {
+    uint8_t header[kChainSnapshotHeaderSize] = {};
+    store_u32(header, kChainSnapshotVersion);
+    std::memcpy(header + 8, &snapshot.segment, sizeof(snapshot.segment));
+    std::memcpy(header + 16, snapshot.previous_sha256, sizeof(snapshot.previous_sha256));
+    return encode_framed_record(kChainRecordCommitted | kChainRecordSnapshot, header, sizeof(header),
+                                data, size, out);
+}
+
+std::vector<uint8_t> encode_chain_index(const ChainIndexEntry* entries, size_t count) {
+    std::vector<uint8_t> out(kChainIndexHeaderSize + count * sizeof(ChainIndexEntry));
+    const uint32_t header[4] = {0, kChainIndexVersion, static_cast<uint32_t>(sizeof(ChainIndexEntry)), 0};
+    std::memcpy(out.data(), header, sizeof(header));
+    std::memcpy(out.data(), kChainIndexMagic, sizeof(kChainIndexMagic));
+    if (count > 0) {
+        std::memcpy(out.data() + kChainIndexHeaderSize, entries, count * sizeof(ChainIndexEntry));
+    }
+    return out;
+}
+
+bool append_chain_index(const std::string& index_path, const ChainIndexEntry* entries, size_t count) {
+    if (count == 0) {
+        return true;
+    }
+
+    std::fstream file(index_path, std::ios::binary | std::ios::in | std::ios::out);
+    size_t skip = 0;
+    uint64_t last_timestamp = 0;
+    if (!file.is_open()) {
+        // First records of a new log: start a new index
+        if (entries[0].offset != 0) {
+            return false;
+        }
+        file.open(index_path, std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        const std::vector<uint8_t> header = encode_chain_index(nullptr, 0);
+        file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    } else {
+        file.seekg(0, std::ios::end);
+        const auto size = static_cast<size_t>(file.tellg());
+        const bool aligned = size >= kChainIndexHeaderSize &&
+                             (size - kChainIndexHeaderSize) % sizeof(ChainIndexEntry) == 0;
+        std::vector<uint8_t> header(kChainIndexHeaderSize);
+        if (aligned) {
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()));
+        }
+        const bool current = aligned && header == encode_chain_index(nullptr, 0);
+        uint64_t indexed_end = 0;
+        if (current && size > kChainIndexHeaderSize) {
+            ChainIndexEntry last;
+            file.seekg(static_cast<std::streamoff>(size - sizeof(last)));
+            file.read(reinterpret_cast<char*>(&last), sizeof(last));
+            indexed_end = last.offset + last.size;
+            last_timestamp = last.timestamp;
+        }
+        while (skip < count && entries[skip].offset < indexed_end) {
+            skip++;
+        }
+        if (!current || !file.good() || (skip < count && entries[skip].offset != indexed_end)) {
+            file.close();
+            std::remove(index_path.c_str());
+            return false;
+        }
+        file.seekp(0, std::ios::end);
+    }
+
+    for (size_t i = skip; i < count; ++i) {
+        ChainIndexEntry entry = entries[i];
+        entry.timestamp = std::max(entry.timestamp, last_timestamp);
+        last_timestamp = entry.timestamp;
+        file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    }
+    file.close();
+    if (file.fail()) {
+        std::remove(index_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+struct ChainLogReader::Impl {
+    MappedFile log;
+    MappedFile index;
+    const uint8_t* entries = nullptr;           // Mapped index entries, or owned_entries
+    size_t count = 0;
+    std::vector<ChainIndexEntry> owned_entries; // Set when the index was rebuilt or extended
+
+    ChainIndexEntry entry(size_t position) const {
+        ChainIndexEntry e;
+        std::memcpy(&e, entries + position * sizeof(ChainIndexEntry), sizeof(e));
+        return e;
+    }
+
+    uint64_t intact_end = 0;                    // End of the last indexed record
+    bool torn_tail = false;
+    std::optional<ChainSnapshot> snapshot;      // From the first record
+
+    ChainRecordStatus record(uint64_t offset, ChainRecord* rec) const {
+        const size_t size = log.size();
+        if (offset > size) {
+            return ChainRecordStatus::Truncated;
+        }
+        return parse_chain_record(log.data() + offset, size - offset, rec);
+    }
+
+    std::optional<ChainStateView> view(size_t position) const {
+        if (position >= count) {
+            return std::nullopt;
+        }
+        const ChainIndexEntry e = entry(position);
+        ChainRecord rec;
+        if (record(e.offset, &rec) != ChainRecordStatus::Intact || rec.size != e.size || rec.checksum != e.checksum) {
+            return std::nullopt;
+        }
+        return ChainStateView{e.state_index, e.timestamp, rec.data};
+    }
+
+    // Map the index and check that it matches the log up to its last entry
+    bool load_index(const std::string& index_path) {
+        if (!index.open(index_path) || index.size() < kChainIndexHeaderSize) {
+            return false;
+        }
+        const uint8_t* header = index.data();
+        if (std::memcmp(header, kChainIndexMagic, sizeof(kChainIndexMagic)) != 0 ||
+            load_u32(header + 4) != kChainIndexVersion || load_u32(header + 8) != sizeof(ChainIndexEntry)) {
+            return false;
+        }
+        entries = header + kChainIndexHeaderSize;
+        count = (index.size() - kChainIndexHeaderSize) / sizeof(ChainIndexEntry);
+        return count == 0 || view(count - 1).has_value();
+    }
+
+    // Index the records from offset onwards, stopping at the first damaged one
+    void scan_log(uint64_t offset, uint64_t timestamp) {
+        ChainRecord rec;
+        while (record(offset, &rec) == ChainRecordStatus::Intact) {
+            Token token{};
+            const uint64_t state_index = Token::decode(rec.data, &token) ? token.state_index : owned_entries.size();
+            owned_entries.push_back({state_index, offset, static_cast<uint32_t>(rec.size), rec.checksum, timestamp});
+            offset += rec.size;
+        }
+    }
+
+    // Whether an intact framed record starts somewhere in [from, end of log)
+    bool framed_record_after(uint64_t from) const {
+        uint8_t magic[sizeof(kChainRecordMagic)];
+        std::memcpy(magic, &kChainRecordMagic, sizeof(magic));
+        const uint8_t* end = log.data() + log.size();
+        const uint8_t* p = log.data() + std::min<uint64_t>(from, log.size());
+        ChainRecord rec;
+        while ((p = std::search(p, end, magic, magic + sizeof(magic))) != end) {
+            if (parse_chain_record(p, static_cast<size_t>(end - p), &rec) == ChainRecordStatus::Intact) {
+                return true;
+            }
+            ++p;
+        }
+        return false;
+    }
+
+    // Whether the bytes after the last intact record are what an interrupted
+    // append leaves behind: a record cut short, a complete but failing last
+    // record, or space that was allocated but never written. Damage with
+    // readable records after it is left alone.
+    bool tail_is_torn() const {
+        if (intact_end >= log.size() || framed_record_after(intact_end + 1)) {
+            return false;
+        }
+        ChainRecord rec;
+        const ChainRecordStatus status = record(intact_end, &rec);
+        if (status != ChainRecordStatus::Damaged) {
+            return status == ChainRecordStatus::Truncated;
+        }
+        // Nothing after a damaged framed record can be read; a damaged
+        // legacy record may still be followed by legacy records
+        if (load_u32(log.data() + intact_end) == kChainRecordMagic || intact_end + rec.size >= log.size()) {
+            return true;
+        }
+        const uint8_t* tail = log.data() + intact_end;
+        return std::all_of(tail, log.data() + log.size(), [](uint8_t b) { return b == 0; });
+    }
+};
+
+std::unique_ptr<ChainLogReader> ChainLogReader::open(const std::string& log_path, const std::string& index_path) {
+    auto impl = std::make_unique<Impl>();
+    if (!impl->log.open(log_path)) {
+        return nullptr;
+    }
+
+    const bool have_index = impl->load_index(index_path);
+    uint64_t indexed_end = 0;
+    uint64_t last_timestamp = 0;
+    if (have_index && impl->count > 0) {
+        const ChainIndexEntry last = impl->entry(impl->count - 1);
+        indexed_end = last.offset + last.size;
+        last_timestamp = last.timestamp;
+    }
+
+    if (!have_index || indexed_end < impl->log.size()) {
+        // Rebuild, or pick up records appended after the index was written
+        if (have_index) {
+            impl->owned_entries.resize(impl->count);
+            std::memcpy(impl->owned_entries.data(), impl->entries, impl->count * sizeof(ChainIndexEntry));
+        }
+        const size_t known = impl->owned_entries.size();
+        impl->scan_log(indexed_end, last_timestamp);
+        impl->index.close();
+        impl->entries = reinterpret_cast<const uint8_t*>(impl->owned_entries.data());
+        impl->count = impl->owned_entries.size();
+        if (!have_index || impl->count > known) {
+            // Best effort: a read-only chain directory still gets an in-memory index
+            (void)write_file_atomically(index_path, encode_chain_index(impl->owned_entries.data(), impl->count));
+        }
+    }
+
+    if (impl->count > 0) {
+        const ChainIndexEntry last = impl->entry(impl->count - 1);
+        impl->intact_end = last.offset + last.size;
+        ChainRecord first;
+        if (impl->record(impl->entry(0).offset, &first) == ChainRecordStatus::Intact) {
+            impl->snapshot = first.snapshot;
+        }
+    }
+    impl->torn_tail = impl->tail_is_torn();
+    return std::unique_ptr<ChainLogReader>(new ChainLogReader(std::move(impl)));
+}
+
+ChainLogReader::ChainLogReader(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+
+ChainLogReader::~ChainLogReader() = default;
+
+size_t ChainLogReader::size() const {
+    return impl_->count;
+}
+
+uint64_t ChainLogReader::intact_size() const {
+    return impl_->intact_end;
+}
+
+bool ChainLogReader::has_torn_tail() const {
+    return impl_->torn_tail;
+}
+
+std::optional<ChainStateView> ChainLogReader::at(size_t position) const {
+    return impl_->view(position);
+}
+
+std::optional<ChainSnapshot> ChainLogReader::snapshot() const {
+    return impl_->snapshot;
+}
+
+std::optional<ChainStateView> ChainLogReader::state(uint64_t state_index) const {
+    // In a well-formed chain state k is record k
+    if (state_index < impl_->count && impl_->entry(state_index).state_index == state_index) {
+        return impl_->view(state_index);
+    }
+    // Otherwise state indexes are still ascending: binary search
+    size_t low = 0;
+    size_t high = impl_->count;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (impl_->entry(mid).state_index < state_index) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low < impl_->count && impl_->entry(low).state_index == state_index) {
+        return impl_->view(low);
+    }
+    return std::nullopt;
+}
+
+std::optional<ChainStateView> ChainLogReader::state_at_time(uint64_t unix_seconds) const {
+    // First entry newer than unix_seconds; timestamps are non-decreasing
+    size_t low = 0;
+    size_t high = impl_->count;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (impl_->entry(mid).timestamp <= unix_seconds) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == 0) {
+        return std::nullopt;
+    }
+    return impl_->view(low - 1);
+}
+
+ChainLogReader::Iterator::Iterator(const ChainLogReader* reader, size_t position) : reader_(reader) {
+    advance(position);
+}
+
+void ChainLogReader::Iterator::advance(size_t position) {
+    const size_t end = reader_->size();
+    position_ = std::min(position, end);
+    if (position_ == end) {
+        return;
+    }
+    std::optional<ChainStateView> view = reader_->at(position_);
+    if (!view) {
+        position_ = end;
+        return;
+    }
+    view_ = *view;
+}
+
+} // namespace decentrilicense
@@ -0,0 +1,269 @@
+#include "decentrilicense/crc32c.hpp"
+#include <array>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define DL_CRC32C_X86 1
+#include <immintrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+#define DL_CRC32C_ARM 1
+#include <arm_acle.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+#endif
+
+#if defined(DL_CRC32C_ARM) || (defined(DL_CRC32C_X86) && defined(__x86_64__))
+#define DL_CRC32C_INTERLEAVE 1
+#endif
+
+namespace decentrilicense {
+
+namespace {
+
+// Reflected Castagnoli polynomial
+constexpr uint32_t kPolynomial = 0x82F63B78u;
+
+using Table = std::array<std::array<uint32_t, 256>, 8>;
+
+// Slicing-by-8: table[k][b] is the CRC of byte b followed by k zero bytes
+constexpr Table make_table() {
+    Table table{};
+    for (uint32_t b = 0; b < 256; ++b) {
+        uint32_t crc = b;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1) ? kPolynomial : 0);
+        }
+        table[0][b] = crc;
+    }
+    for (uint32_t b = 0; b < 256; ++b) {
+        for (size_t k = 1; k < table.size(); ++k) {
+            table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xff];
+        }
+    }
+    return table;
+}
+
+constexpr Table kTable = make_table();
+
+uint32_t load_le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+#ifdef DL_CRC32C_INTERLEAVE
+
+// Moving a CRC register over a run of zero bytes is linear, so it is done
+// with four byte-indexed tables. Hardware kernels use it to join the CRCs of
+// three blocks computed in parallel: crc(A B) = shift_|B|(crc(A)) ^ crc0(B),
+// where crc0 starts from a zero register. This hides the latency of the crc
+// instructions, which can issue one per cycle but take three to complete.
+class ZeroShift {
+public:
+    explicit ZeroShift(size_t zeros) {
+        uint32_t column[32];
+        for (int bit = 0; bit < 32; ++bit) {
+            uint32_t crc = 1u << bit;
+            for (size_t i = 0; i < zeros; ++i) {
+                crc = (crc >> 8) ^ kTable[0][crc & 0xff];
+            }
+            column[bit] = crc;
+        }
+        for (int k = 0; k < 4; ++k) {
+            for (uint32_t b = 0; b < 256; ++b) {
+                uint32_t value = 0;
+                for (int bit = 0; bit < 8; ++bit) {
+                    if (b & (1u << bit)) {
+                        value ^= column[8 * k + bit];
+                    }
+                }
+                table_[k][b] = value;
+            }
+        }
+    }
+
+    uint32_t operator()(uint32_t crc) const {
+        return table_[0][crc & 0xff] ^ table_[1][(crc >> 8) & 0xff] ^
+               table_[2][(crc >> 16) & 0xff] ^ table_[3][crc >> 24];
+    }
+
+private:
+    uint32_t table_[4][256];
+};
+
+// Bytes per stream in the interleaved loops: long blocks for bulk data,
+// short ones so that token-sized records benefit too
+constexpr size_t kLongBlock = 1024;
+constexpr size_t kShortBlock = 64;
+
+struct BlockShifts {
+    ZeroShift long_block{kLongBlock};
+    ZeroShift short_block{kShortBlock};
+};
+
+const BlockShifts& block_shifts() {
+    static const BlockShifts shifts;
+    return shifts;
+}
+
+uint64_t load_u64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+#endif // DL_CRC32C_INTERLEAVE
+
+// Kernels take and return the raw (non-inverted) register value
+using Kernel = uint32_t (*)(uint32_t crc, const uint8_t* p, size_t size);
+
+uint32_t kernel_portable(uint32_t crc, const uint8_t* p, size_t size) {
+    for (; size >= 8; p += 8, size -= 8) {
+        const uint32_t lo = load_le32(p) ^ crc;
+        const uint32_t hi = load_le32(p + 4);
+        crc = kTable[7][lo & 0xff] ^ kTable[6][(lo >> 8) & 0xff] ^
+              kTable[5][(lo >> 16) & 0xff] ^ kTable[4][lo >> 24] ^
+              kTable[3][hi & 0xff] ^ kTable[2][(hi >> 8) & 0xff] ^
+              kTable[1][(hi >> 16) & 0xff] ^ kTable[0][hi >> 24];
+    }
+    for (; size > 0; ++p, --size) {
+        crc = (crc >> 8) ^ kTable[0][(crc ^ *p) & 0xff];
+    }
+    return crc;
+}
+
+#ifdef DL_CRC32C_X86
+
+#ifdef __x86_64__
+
+// Three streams of block bytes each, while there are enough
+__attribute__((target("sse4.2")))
+uint32_t interleave_sse42(uint32_t crc, const uint8_t*& p, size_t& size, size_t block, const ZeroShift& shift) {
+    for (; size >= 3 * block; p += 3 * block, size -= 3 * block) {
+        uint64_t crc0 = crc;
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+        for (size_t i = 0; i < block; i += 8) {
+            crc0 = _mm_crc32_u64(crc0, load_u64(p + i));
+            crc1 = _mm_crc32_u64(crc1, load_u64(p + block + i));
+            crc2 = _mm_crc32_u64(crc2, load_u64(p + 2 * block + i));
+        }
+        crc = shift(shift(static_cast<uint32_t>(crc0)) ^ static_cast<uint32_t>(crc1)) ^ static_cast<uint32_t>(crc2);
+    }
+    return crc;
+}
+
+#endif
+
+__attribute__((target("sse4.2")))
+uint32_t kernel_sse42(uint32_t crc, const uint8_t* p, size_t size) {
+#ifdef __x86_64__
+    const BlockShifts& shifts = block_shifts();
+    crc = interleave_sse42(crc, p, size, kLongBlock, shifts.long_block);
+    crc = interleave_sse42(crc, p, size, kShortBlock, shifts.short_block);
+    uint64_t crc64 = crc;
+    for (; size >= 8; p += 8, size -= 8) {
+        crc64 = _mm_crc32_u64(crc64, load_u64(p));
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    for (; size >= 4; p += 4, size -= 4) {
+        uint32_t word;
+        std::memcpy(&word, p, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+    for (; size > 0; ++p, --size) {
+        crc = _mm_crc32_u8(crc, *p);
+    }
+    return crc;
+}
+
+#endif // DL_CRC32C_X86
+
+#ifdef DL_CRC32C_ARM
+
+#if defined(__clang__)
+#define DL_CRC32C_TARGET_ARM __attribute__((target("crc")))
+#else
+#define DL_CRC32C_TARGET_ARM __attribute__((target("+crc")))
+#endif
+
+// Three streams of block bytes each, while there are enough
+DL_CRC32C_TARGET_ARM
+uint32_t interleave_armv8(uint32_t crc, const uint8_t*& p, size_t& size, size_t block, const ZeroShift& shift) {
+    for (; size >= 3 * block; p += 3 * block, size -= 3 * block) {
+        uint32_t crc0 = crc;
+        uint32_t crc1 = 0;
+        uint32_t crc2 = 0;
+        for (size_t i = 0; i < block; i += 8) {
+            crc0 = __crc32cd(crc0, load_u64(p + i));
+            crc1 = __crc32cd(crc1, load_u64(p + block + i));
+            crc2 = __crc32cd(crc2, load_u64(p + 2 * block + i));
+        }
+        crc = shift(shift(crc0) ^ crc1) ^ crc2;
+    }
+    return crc;
+}
+
+DL_CRC32C_TARGET_ARM
+uint32_t kernel_armv8(uint32_t crc, const uint8_t* p, size_t size) {
+    const BlockShifts& shifts = block_shifts();
+    crc = interleave_armv8(crc, p, size, kLongBlock, shifts.long_block);
+    crc = interleave_armv8(crc, p, size, kShortBlock, shifts.short_block);
+    for (; size >= 8; p += 8, size -= 8) {
+        crc = __crc32cd(crc, load_u64(p));
+    }
+    for (; size > 0; ++p, --size) {
+        crc = __crc32cb(crc, *p);
+    }
+    return crc;
+}
+
+#endif // DL_CRC32C_ARM
+
+struct Implementation {
+    Kernel kernel;
+    const char* name;
+};
+
+Implementation select_implementation() {
+#if defined(DL_CRC32C_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        return Implementation{kernel_sse42, "sse4.2"};
+    }
+#elif defined(DL_CRC32C_ARM)
+#if defined(__ARM_FEATURE_CRC32) || defined(__APPLE__)
+    return Implementation{kernel_armv8, "armv8"};
+#elif defined(__linux__)
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+        return Implementation{kernel_armv8, "armv8"};
+    }
+#endif
+#endif
+    return Implementation{kernel_portable, "portable"};
+}
+
+const Implementation& selected() {
+    static const Implementation implementation = select_implementation();
+    return implementation;
+}
+
+} // namespace
+
+uint32_t Crc32c::extend(uint32_t crc, const void* data, size_t size) {
+    return ~selected().kernel(~crc, static_cast<const uint8_t*>(data), size);
+}
+
+uint32_t Crc32c::extend_portable(uint32_t crc, const void* data, size_t size) {
+    return ~kernel_portable(~crc, static_cast<const uint8_t*>(data), size);
+}
+
+const char* Crc32c::implementation() {
+    return selected().name;
+}
+
+} // namespace decentrilicense
@@ -0,0 +1,113 @@
+#include "crypto_context.hpp"
+#include "decentrilicense/key_cache.hpp"
+#include <atomic>
+#include <stdexcept>
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/provider.h>
+#endif
+
+namespace decentrilicense {
+
+namespace {
+
+thread_local const CryptoContext* tls_current_context = nullptr;
+
+std::atomic<uint64_t> next_context_id{1};
+
+} // namespace
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+
+AlgorithmSet::AlgorithmSet(OSSL_LIB_CTX* libctx)
+    : sha256_(EVP_MD_fetch(libctx, "SHA256", nullptr)),
+      sm3_(EVP_MD_fetch(libctx, "SM3", nullptr)),
+      aes_256_gcm_(EVP_CIPHER_fetch(libctx, "AES-256-GCM", nullptr)) {
+    // Fall back to the implicit-fetch objects if a provider is missing
+    if (!sha256_) {
+        sha256_ = EVP_sha256();
+    }
+    if (!sm3_) {
+        sm3_ = EVP_sm3();
+    }
+    if (!aes_256_gcm_) {
+        aes_256_gcm_ = EVP_aes_256_gcm();
+    }
+}
+
+AlgorithmSet::~AlgorithmSet() {
+    // Freeing the static implicit-fetch objects is a no-op
+    EVP_MD_free(const_cast<EVP_MD*>(sha256_));
+    EVP_MD_free(const_cast<EVP_MD*>(sm3_));
+    EVP_CIPHER_free(const_cast<EVP_CIPHER*>(aes_256_gcm_));
+}
+
+CryptoContext::CryptoContext()
+    : libctx_(OSSL_LIB_CTX_new()), provider_(nullptr), id_(next_context_id.fetch_add(1)) {
+    if (!libctx_) {
+        throw std::runtime_error("Failed to create OpenSSL library context");
+    }
+    provider_ = OSSL_PROVIDER_load(libctx_, "default");
+    if (!provider_) {
+        OSSL_LIB_CTX_free(libctx_);
+        throw std::runtime_error("Failed to load OpenSSL default provider");
+    }
+    algorithms_ = std::make_unique<AlgorithmSet>(libctx_);
+}
+
+CryptoContext::~CryptoContext() {
+    // Keys cached for this context hold references into it; other contexts' keys stay
+    KeyCache::instance().erase_context(id_);
+    algorithms_.reset();
+    OSSL_PROVIDER_unload(provider_);
+    OSSL_LIB_CTX_free(libctx_);
+}
+
+#else
+
+AlgorithmSet::AlgorithmSet(OSSL_LIB_CTX*)
+    : sha256_(EVP_sha256()),
+      sm3_(EVP_sm3()),
+      aes_256_gcm_(EVP_aes_256_gcm()) {
+}
+
+AlgorithmSet::~AlgorithmSet() = default;
+
+CryptoContext::CryptoContext()
+    : libctx_(nullptr), provider_(nullptr),
+      algorithms_(std::make_unique<AlgorithmSet>()),
+      id_(next_context_id.fetch_add(1)) {
+}
+
+CryptoContext::~CryptoContext() = default;
+
+#endif
+
+const AlgorithmSet& AlgorithmSet::global() {
+    // Intentionally leaked: contexts may still be in use during static
+    // destruction on other threads
+    static const AlgorithmSet* set = new AlgorithmSet();
+    return *set;
+}
+
+std::shared_ptr<CryptoContext> CryptoContext::shared() {
+    // Leaked for the same reason as AlgorithmSet::global()
+    static const std::shared_ptr<CryptoContext>* context =
+        new std::shared_ptr<CryptoContext>(std::make_shared<CryptoContext>());
+    return *context;
+}
+
+ScopedCryptoContext::ScopedCryptoContext(const CryptoContext* context)
+    : previous_(tls_current_context) {
+    tls_current_context = context;
+}
+
+ScopedCryptoContext::~ScopedCryptoContext() {
+    tls_current_context = previous_;
+}
+
+const CryptoContext* current_crypto_context() {
+    return tls_current_context;
+}
+
+} // namespace decentrilicense
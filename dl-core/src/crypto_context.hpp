@@ -0,0 +1,197 @@
+#ifndef DECENTRILICENSE_CRYPTO_CONTEXT_HPP
+#define DECENTRILICENSE_CRYPTO_CONTEXT_HPP
+
+// Internal header: OpenSSL library contexts, pre-fetched algorithms and
+// per-thread pools of reusable EVP contexts. Not installed.
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <openssl/evp.h>
+#include <openssl/opensslv.h>
+
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+typedef struct ossl_lib_ctx_st OSSL_LIB_CTX;
+#endif
+
+namespace decentrilicense {
+
+/**
+ * AlgorithmSet - Digest and cipher implementations fetched once
+ *
+ * On OpenSSL 3 every EVP_sha256()/EVP_sm3()/EVP_aes_256_gcm() handed to an
+ * init function is re-fetched through the provider store, which takes a
+ * global lock. Passing these pre-fetched objects skips that lookup. On
+ * OpenSSL 1.1 they are the static built-in implementations.
+ */
+class AlgorithmSet {
+public:
+    /**
+     * Fetch the algorithms
+     * @param libctx Library context to fetch from, nullptr = default context
+     */
+    explicit AlgorithmSet(OSSL_LIB_CTX* libctx = nullptr);
+    ~AlgorithmSet();
+
+    // Non-copyable
+    AlgorithmSet(const AlgorithmSet&) = delete;
+    AlgorithmSet& operator=(const AlgorithmSet&) = delete;
+
+    /**
+     * Process-wide set fetched from the default library context
+     */
+    static const AlgorithmSet& global();
+
+    const EVP_MD* sha256() const { return sha256_; }
+    const EVP_MD* sm3() const { return sm3_; }
+    const EVP_CIPHER* aes_256_gcm() const { return aes_256_gcm_; }
+
+private:
+    const EVP_MD* sha256_;
+    const EVP_MD* sm3_;
+    const EVP_CIPHER* aes_256_gcm_;
+};
+
+/**
+ * CryptoContext - Private OpenSSL library context
+ *
+ * Owns an OSSL_LIB_CTX with the default provider loaded, plus the algorithms
+ * fetched from it. Keys parsed and operations run while a context is
+ * current use its provider store instead of the process-wide one, so
+ * clients with their own context do not contend with each other or with
+ * the host application.
+ *
+ * Destroying a context clears the KeyCache, since cached keys may belong to
+ * it. On OpenSSL 1.1 a context is a no-op and everything uses the defaults.
+ */
+class CryptoContext {
+public:
+    CryptoContext();
+    ~CryptoContext();
+
+    // Non-copyable
+    CryptoContext(const CryptoContext&) = delete;
+    CryptoContext& operator=(const CryptoContext&) = delete;
+
+    /**
+     * Private context shared by every client of this library instance
+     */
+    static std::shared_ptr<CryptoContext> shared();
+
+    OSSL_LIB_CTX* libctx() const { return libctx_; }
+    const AlgorithmSet& algorithms() const { return *algorithms_; }
+
+    /**
+     * Process-unique identifier, used to keep cached keys apart
+     */
+    uint64_t id() const { return id_; }
+
+private:
+    OSSL_LIB_CTX* libctx_;
+    struct ossl_provider_st* provider_;
+    std::unique_ptr<AlgorithmSet> algorithms_;
+    uint64_t id_;
+};
+
+/**
+ * ScopedCryptoContext - Make a context current on this thread
+ *
+ * The previous context is restored when the scope ends; nullptr selects the
+ * default OpenSSL context.
+ */
+class ScopedCryptoContext {
+public:
+    explicit ScopedCryptoContext(const CryptoContext* context);
+    ~ScopedCryptoContext();
+
+    ScopedCryptoContext(const ScopedCryptoContext&) = delete;
+    ScopedCryptoContext& operator=(const ScopedCryptoContext&) = delete;
+
+private:
+    const CryptoContext* previous_;
+};
+
+/**
+ * Context current on this thread, nullptr for the default context
+ */
+const CryptoContext* current_crypto_context();
+
+/**
+ * Library context to pass to OpenSSL *_ex functions (nullptr = default)
+ */
+inline OSSL_LIB_CTX* current_libctx() {
+    const CryptoContext* context = current_crypto_context();
+    return context ? context->libctx() : nullptr;
+}
+
+/**
+ * Algorithms to use for the current operation
+ */
+inline const AlgorithmSet& current_algorithms() {
+    const CryptoContext* context = current_crypto_context();
+    return context ? context->algorithms() : AlgorithmSet::global();
+}
+
+/**
+ * ContextPool - Per-thread free list of reusable EVP contexts
+ *
+ * acquire() hands out a pooled context (or a new one); the lease resets it
+ * and puts it back when it goes out of scope. Contexts are never shared
+ * between threads while leased. At most kMaxPooled idle contexts are kept
+ * per thread.
+ */
+template <typename T, T* (*NewFn)(), int (*ResetFn)(T*), void (*FreeFn)(T*)>
+class ContextPool {
+public:
+    static constexpr size_t kMaxPooled = 8;
+
+    struct Release {
+        void operator()(T* ctx) const { local().release(ctx); }
+    };
+    using Lease = std::unique_ptr<T, Release>;
+
+    /**
+     * Get a clean context
+     * @return Leased context, null if allocation failed
+     */
+    static Lease acquire() { return Lease(local().take()); }
+
+    ~ContextPool() {
+        for (T* ctx : free_) {
+            FreeFn(ctx);
+        }
+    }
+
+private:
+    static ContextPool& local() {
+        thread_local ContextPool pool;
+        return pool;
+    }
+
+    T* take() {
+        if (!free_.empty()) {
+            T* ctx = free_.back();
+            free_.pop_back();
+            return ctx;
+        }
+        return NewFn();
+    }
+
+    void release(T* ctx) {
+        if (free_.size() < kMaxPooled && ResetFn(ctx) == 1) {
+            free_.push_back(ctx);
+        } else {
+            FreeFn(ctx);
+        }
+    }
+
+    std::vector<T*> free_;
+};
+
+using MdCtxPool = ContextPool<EVP_MD_CTX, EVP_MD_CTX_new, EVP_MD_CTX_reset, EVP_MD_CTX_free>;
+using CipherCtxPool = ContextPool<EVP_CIPHER_CTX, EVP_CIPHER_CTX_new, EVP_CIPHER_CTX_reset, EVP_CIPHER_CTX_free>;
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_CRYPTO_CONTEXT_HPP
@@ -1,10 +1,15 @@
 #include "decentrilicense/crypto_utils.hpp"
+#include "decentrilicense/signer.hpp"
 #include "decentrilicense/root_key.hpp"
+#include "decentrilicense/worker_pool.hpp"
+#include "decentrilicense/base64.hpp"
+#include "decentrilicense/hasher.hpp"
+#include "decentrilicense/token_cipher.hpp"
+#include "crypto_context.hpp"
 #include <openssl/rsa.h>
 #include <openssl/pem.h>
 #include <openssl/evp.h>
 #include <openssl/rand.h>
-#include <openssl/sha.h>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
@@ -14,6 +19,9 @@
 #include <openssl/buffer.h>
 #include <array>
 #include <stdexcept>
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -28,268 +36,95 @@
 
 namespace decentrilicense {
 
-const std::string base64_chars = 
-             "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-             "abcdefghijklmnopqrstuvwxyz"
-             "0123456789+/";
-
-inline bool is_base64(unsigned char c) {
-    return (isalnum(c) || (c == '+') || (c == '/'));
-}
-
-std::string CryptoUtils::encrypt_token_aes256_gcm(const std::string& token_json, const std::string& product_public_key_file_content) {
-    initialize_openssl();
-
-    const auto key = derive_aes256_key_from_product_public_key(product_public_key_file_content);
-    std::vector<uint8_t> nonce(12);
-    if (RAND_bytes(nonce.data(), static_cast<int>(nonce.size())) != 1) {
-        throw std::runtime_error("failed to generate nonce");
-    }
-
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) {
-        throw std::runtime_error("failed to create cipher context");
+std::optional<SigningAlgorithm> parse_signing_algorithm(std::string_view name) {
+    if (name == "RSA") {
+        return SigningAlgorithm::RSA;
     }
-
-    std::vector<uint8_t> ciphertext(token_json.size());
-    int out_len = 0;
-    int total_len = 0;
-
-    if (EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("failed to init aes-256-gcm");
+    if (name == "Ed25519") {
+        return SigningAlgorithm::Ed25519;
     }
-    if (EVP_EncryptInit_ex(ctx, nullptr, nullptr, key.data(), nonce.data()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("failed to set key/nonce");
+    if (name == "SM2") {
+        return SigningAlgorithm::SM2;
     }
-    if (EVP_EncryptUpdate(ctx, ciphertext.data(), &out_len, reinterpret_cast<const unsigned char*>(token_json.data()), static_cast<int>(token_json.size())) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("failed to encrypt");
-    }
-    total_len = out_len;
-    if (EVP_EncryptFinal_ex(ctx, ciphertext.data() + total_len, &out_len) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("failed to finalize encrypt");
-    }
-    total_len += out_len;
-    ciphertext.resize(static_cast<size_t>(total_len));
+    return std::nullopt;
+}
 
-    std::vector<uint8_t> tag(16);
-    if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, static_cast<int>(tag.size()), tag.data()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("failed to get tag");
+const char* signing_algorithm_name(SigningAlgorithm algorithm) {
+    switch (algorithm) {
+        case SigningAlgorithm::RSA:
+            return "RSA";
+        case SigningAlgorithm::Ed25519:
+            return "Ed25519";
+        case SigningAlgorithm::SM2:
+            return "SM2";
     }
-    EVP_CIPHER_CTX_free(ctx);
+    return "";
+}
 
-    std::vector<uint8_t> ciphertext_with_tag;
-    ciphertext_with_tag.reserve(ciphertext.size() + tag.size());
-    ciphertext_with_tag.insert(ciphertext_with_tag.end(), ciphertext.begin(), ciphertext.end());
-    ciphertext_with_tag.insert(ciphertext_with_tag.end(), tag.begin(), tag.end());
+// Token encryption uses a per-thread session so the key schedule and cipher
+// contexts are set up once per thread instead of once per token
+static TokenCipher& token_cipher_session() {
+    thread_local TokenCipher session(TokenCipher::token_key());
+    return session;
+}
 
-    return base64url_encode(ciphertext_with_tag) + "|" + base64url_encode(nonce);
+std::string CryptoUtils::encrypt_token_aes256_gcm(const std::string& token_json, const std::string& product_public_key_file_content) {
+    // The key does not depend on the product key (see derive_aes256_key_from_product_public_key)
+    (void)product_public_key_file_content;
+    return token_cipher_session().encrypt(token_json);
 }
 
 std::string CryptoUtils::decrypt_token_aes256_gcm(const std::string& encrypted_token, const std::string& product_public_key_file_content) {
-    initialize_openssl();
-
-    size_t sep = encrypted_token.find('|');
-    if (sep == std::string::npos) {
-        throw std::runtime_error("invalid encrypted token format");
-    }
-
-    const std::string ct_b64u = encrypted_token.substr(0, sep);
-    const std::string nonce_b64u = encrypted_token.substr(sep + 1);
-
-    std::vector<uint8_t> ciphertext_with_tag = base64url_decode(ct_b64u);
-    std::vector<uint8_t> nonce = base64url_decode(nonce_b64u);
-
-    if (nonce.size() != 12) {
-        throw std::runtime_error("invalid nonce length");
-    }
-    if (ciphertext_with_tag.size() < 16) {
-        throw std::runtime_error("invalid ciphertext length");
-    }
-
-    const auto key = derive_aes256_key_from_product_public_key(product_public_key_file_content);
-
-    std::vector<uint8_t> tag(ciphertext_with_tag.end() - 16, ciphertext_with_tag.end());
-    std::vector<uint8_t> ciphertext(ciphertext_with_tag.begin(), ciphertext_with_tag.end() - 16);
-
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) {
-        throw std::runtime_error("failed to create cipher context");
-    }
-
-    std::vector<uint8_t> plaintext(ciphertext.size());
-    int out_len = 0;
-    int total_len = 0;
-
-    if (EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("failed to init aes-256-gcm");
-    }
-    if (EVP_DecryptInit_ex(ctx, nullptr, nullptr, key.data(), nonce.data()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("failed to set key/nonce");
-    }
-    if (EVP_DecryptUpdate(ctx, plaintext.data(), &out_len, ciphertext.data(), static_cast<int>(ciphertext.size())) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("failed to decrypt");
-    }
-    total_len = out_len;
-    if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, static_cast<int>(tag.size()), tag.data()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("failed to set tag");
-    }
-    int final_ok = EVP_DecryptFinal_ex(ctx, plaintext.data() + total_len, &out_len);
-    EVP_CIPHER_CTX_free(ctx);
-    if (final_ok != 1) {
-        throw std::runtime_error("gcm tag verification failed");
-    }
-    total_len += out_len;
-    plaintext.resize(static_cast<size_t>(total_len));
-
-    return std::string(reinterpret_cast<const char*>(plaintext.data()), plaintext.size());
+    (void)product_public_key_file_content;
+    return token_cipher_session().decrypt(encrypted_token);
 }
 
 std::string CryptoUtils::base64_encode(const std::vector<uint8_t>& data) {
-    std::string ret;
-    int i = 0;
-    int j = 0;
-    uint8_t char_array_3[3];
-    uint8_t char_array_4[4];
-    int data_len = data.size();
-    
-    for (int k = 0; k < data_len; k++) {
-        char_array_3[i++] = data[k];
-        if (i == 3) {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
-
-            for(i = 0; (i <4) ; i++)
-                ret += base64_chars[char_array_4[i]];
-            i = 0;
-        }
-    }
-
-    if (i)
-    {
-        for(j = i; j < 3; j++)
-            char_array_3[j] = '\0';
-
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-        char_array_4[3] = char_array_3[2] & 0x3f;
-
-        for (j = 0; (j < i + 1); j++)
-            ret += base64_chars[char_array_4[j]];
-
-        while((i++ < 3))
-            ret += '=';
-
-    }
-
-    return ret;
+    return Base64::encode(data.data(), data.size());
 }
 
 std::string CryptoUtils::base64_encode(const std::string& data) {
-    std::vector<uint8_t> vec(data.begin(), data.end());
-    return base64_encode(vec);
+    return Base64::encode(reinterpret_cast<const uint8_t*>(data.data()), data.size());
 }
 
 std::string CryptoUtils::base64url_encode(const std::vector<uint8_t>& data) {
-    std::string s = base64_encode(data);
-    for (char& c : s) {
-        if (c == '+') c = '-';
-        else if (c == '/') c = '_';
-    }
-    while (!s.empty() && s.back() == '=') {
-        s.pop_back();
-    }
-    return s;
+    return Base64::encode(data.data(), data.size(), Base64::Alphabet::Url);
 }
 
 std::vector<uint8_t> CryptoUtils::base64url_decode(const std::string& data) {
-    std::string s = data;
-    for (char& c : s) {
-        if (c == '-') c = '+';
-        else if (c == '_') c = '/';
-    }
-    while (s.size() % 4 != 0) {
-        s.push_back('=');
-    }
-    return base64_decode(s);
+    return Base64::decode(data, Base64::Alphabet::Url);
 }
 
 std::array<uint8_t, 32> CryptoUtils::sha256_bytes(const std::string& data) {
-    std::array<uint8_t, 32> out{};
-    SHA256_CTX ctx;
-    SHA256_Init(&ctx);
-    SHA256_Update(&ctx, data.data(), data.size());
-    SHA256_Final(out.data(), &ctx);
-    return out;
+    return Hasher::digest(Hasher::Algorithm::SHA256, data);
 }
 
 std::array<uint8_t, 32> CryptoUtils::derive_aes256_key_from_product_public_key(const std::string& product_public_key_file_content) {
     // For token encryption/decryption, use the hardcoded root public key (matching dl-issuer behavior)
     // dl-issuer uses the root public key PEM content as the basis for AES key derivation
-    return sha256_bytes(decentrilicense::ROOT_PUBLIC_KEY);
+    (void)product_public_key_file_content;
+    return TokenCipher::token_key();
 }
 
 std::vector<uint8_t> CryptoUtils::base64_decode(const std::string& encoded) {
-    // Use OpenSSL's built-in base64 decoder for reliability
-    BIO *bio, *b64;
-    int decodeLen = encoded.size() * 3 / 4 + 1;
-    std::vector<uint8_t> buffer(decodeLen);
-
-    bio = BIO_new_mem_buf(encoded.c_str(), encoded.size());
-    b64 = BIO_new(BIO_f_base64());
-    bio = BIO_push(b64, bio);
-
-    // Don't use newlines to flush buffer
-    BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);
-
-    int len = BIO_read(bio, buffer.data(), decodeLen);
-    BIO_free_all(bio);
-
-    if (len < 0) {
-        return std::vector<uint8_t>(); // Return empty vector on error
-    }
-
-    buffer.resize(len);
-    return buffer;
+    return Base64::decode(encoded);
 }
 
 std::string CryptoUtils::sha256(const std::string& data) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256_CTX sha256;
-    SHA256_Init(&sha256);
-    SHA256_Update(&sha256, data.c_str(), data.size());
-    SHA256_Final(hash, &sha256);
-    
-    std::stringstream ss;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
-    }
-    
-    return ss.str();
+    return Hasher::to_hex(Hasher::digest(Hasher::Algorithm::SHA256, data));
 }
 
 std::string CryptoUtils::compute_license_key_hash(const std::string& license_public_key_pem) {
     // Extract the actual public key PEM from the file content
     // The file may contain additional data after the PEM block
-    std::string actualPublicKeyPEM = license_public_key_pem;
-    size_t rootSigPos = license_public_key_pem.find("\nROOT_SIGNATURE:");
-    if (rootSigPos != std::string::npos) {
-        actualPublicKeyPEM = license_public_key_pem.substr(0, rootSigPos);
+    std::string_view actualPublicKeyPEM = license_public_key_pem;
+    size_t rootSigPos = actualPublicKeyPEM.find("\nROOT_SIGNATURE:");
+    if (rootSigPos != std::string_view::npos) {
+        actualPublicKeyPEM = actualPublicKeyPEM.substr(0, rootSigPos);
     }
     
     // Generate SHA256 hash of the license public key
-    return sha256(actualPublicKeyPEM);
+    return Hasher::to_hex(Hasher::digest(Hasher::Algorithm::SHA256, actualPublicKeyPEM));
 }
 
 std::string CryptoUtils::generate_device_id() {
@@ -303,27 +138,25 @@ std::string CryptoUtils::aes_encrypt(const std::string& plaintext, const std::st
     initialize_openssl();
     
     // Create cipher context
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    CipherCtxPool::Lease lease = CipherCtxPool::acquire();
+    EVP_CIPHER_CTX* ctx = lease.get();
     if (!ctx) {
         throw std::runtime_error("Failed to create cipher context");
     }
     
     // Initialize encryption with AES-256-GCM
-    if (EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
+    if (EVP_EncryptInit_ex(ctx, current_algorithms().aes_256_gcm(), nullptr, nullptr, nullptr) != 1) {
         throw std::runtime_error("Failed to initialize AES-GCM encryption");
     }
     
     // Set key length to 32 bytes for AES-256
     if (EVP_CIPHER_CTX_set_key_length(ctx, 32) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
         throw std::runtime_error("Failed to set key length");
     }
     
     // Generate random IV (12 bytes for GCM)
     std::vector<uint8_t> iv(12);
     if (RAND_bytes(iv.data(), iv.size()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
         throw std::runtime_error("Failed to generate random IV");
     }
     
@@ -331,7 +164,6 @@ std::string CryptoUtils::aes_encrypt(const std::string& plaintext, const std::st
     if (EVP_EncryptInit_ex(ctx, nullptr, nullptr, 
                           reinterpret_cast<const unsigned char*>(key.data()), 
                           iv.data()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
         throw std::runtime_error("Failed to set key and IV");
     }
     
@@ -343,14 +175,12 @@ std::string CryptoUtils::aes_encrypt(const std::string& plaintext, const std::st
     if (EVP_EncryptUpdate(ctx, ciphertext.data(), &len,
                          reinterpret_cast<const unsigned char*>(plaintext.data()), 
                          plaintext.length()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
         throw std::runtime_error("Failed to encrypt data");
     }
     ciphertext_len = len;
     
     // Finalize encryption
     if (EVP_EncryptFinal_ex(ctx, ciphertext.data() + len, &len) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
         throw std::runtime_error("Failed to finalize encryption");
     }
     ciphertext_len += len;
@@ -358,12 +188,10 @@ std::string CryptoUtils::aes_encrypt(const std::string& plaintext, const std::st
     // Get the authentication tag (16 bytes)
     std::vector<uint8_t> tag(16);
     if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, 16, tag.data()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
         throw std::runtime_error("Failed to get authentication tag");
     }
     
     // Clean up
-    EVP_CIPHER_CTX_free(ctx);
     
     // Combine IV, ciphertext, and tag
     std::vector<uint8_t> result;
@@ -395,20 +223,19 @@ std::string CryptoUtils::aes_decrypt(const std::string& ciphertext, const std::s
     std::vector<uint8_t> encrypted_data(data.begin() + 12, data.end() - 16);
     
     // Create cipher context
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    CipherCtxPool::Lease lease = CipherCtxPool::acquire();
+    EVP_CIPHER_CTX* ctx = lease.get();
     if (!ctx) {
         throw std::runtime_error("Failed to create cipher context");
     }
     
     // Initialize decryption with AES-256-GCM
-    if (EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
+    if (EVP_DecryptInit_ex(ctx, current_algorithms().aes_256_gcm(), nullptr, nullptr, nullptr) != 1) {
         throw std::runtime_error("Failed to initialize AES-GCM decryption");
     }
     
     // Set key length to 32 bytes for AES-256
     if (EVP_CIPHER_CTX_set_key_length(ctx, 32) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
         throw std::runtime_error("Failed to set key length");
     }
     
@@ -416,7 +243,6 @@ std::string CryptoUtils::aes_decrypt(const std::string& ciphertext, const std::s
     if (EVP_DecryptInit_ex(ctx, nullptr, nullptr,
                           reinterpret_cast<const unsigned char*>(key.data()),
                           iv.data()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
         throw std::runtime_error("Failed to set key and IV");
     }
     
@@ -427,20 +253,17 @@ std::string CryptoUtils::aes_decrypt(const std::string& ciphertext, const std::s
     
     if (EVP_DecryptUpdate(ctx, plaintext.data(), &len,
                          encrypted_data.data(), encrypted_data.size()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
         throw std::runtime_error("Failed to decrypt data");
     }
     plaintext_len = len;
     
     // Set expected tag
     if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, 16, tag.data()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
         throw std::runtime_error("Failed to set authentication tag");
     }
     
     // Finalize decryption
     int ret = EVP_DecryptFinal_ex(ctx, plaintext.data() + len, &len);
-    EVP_CIPHER_CTX_free(ctx);
     
     if (ret != 1) {
         throw std::runtime_error("Authentication failed - invalid tag");
@@ -466,6 +289,20 @@ using EVPCipherCtxPtr = std::unique_ptr<EVP_CIPHER_CTX, OpenSSLDeleter<EVP_CIPHE
 using EVPMDCtxPtr = std::unique_ptr<EVP_MD_CTX, OpenSSLDeleter<EVP_MD_CTX, EVP_MD_CTX_free>>;
 using BIOPtr = std::unique_ptr<BIO, OpenSSLDeleter<BIO, BIO_free_all>>;
 
+// Library-context aware wrappers: with a private CryptoContext current, keys
+// and signature operations are created inside it; otherwise the default
+// context is used exactly as before
+static EVP_PKEY_CTX* new_keygen_ctx(int id, const char* name) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    if (OSSL_LIB_CTX* libctx = current_libctx()) {
+        return EVP_PKEY_CTX_new_from_name(libctx, name, nullptr);
+    }
+#else
+    (void)name;
+#endif
+    return EVP_PKEY_CTX_new_id(id, nullptr);
+}
+
 // CryptoUtils implementation
 void CryptoUtils::initialize_openssl() {
     // OpenSSL 1.1.0+ doesn't require explicit initialization
@@ -476,13 +313,17 @@ void CryptoUtils::cleanup_openssl() {
 }
 
 CryptoUtils::KeyPair CryptoUtils::generate_rsa_keypair(int key_size) {
+#if !DECENTRILICENSE_WITH_RSA
+    (void)key_size;
+    throw std::runtime_error("RSA support is not compiled in");
+#else
     initialize_openssl();
     
     KeyPair result;
     
     // Generate RSA key
     EVP_PKEY* pkey_raw = nullptr;
-    EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr);
+    EVP_PKEY_CTX* pctx = new_keygen_ctx(EVP_PKEY_RSA, "RSA");
     if (!pctx) {
         throw std::runtime_error("Failed to create EVP_PKEY_CTX");
     }
@@ -538,6 +379,7 @@ CryptoUtils::KeyPair CryptoUtils::generate_rsa_keypair(int key_size) {
     BIO_free(bio_priv);
     
     return result;
+#endif
 }
 
 CryptoUtils::KeyPair CryptoUtils::generate_ed25519_keypair() {
@@ -547,7 +389,7 @@ CryptoUtils::KeyPair CryptoUtils::generate_ed25519_keypair() {
     
     // Generate Ed25519 key
     EVP_PKEY* pkey_raw = nullptr;
-    EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, nullptr);
+    EVP_PKEY_CTX* pctx = new_keygen_ctx(EVP_PKEY_ED25519, "ED25519");
     if (!pctx) {
         throw std::runtime_error("Failed to create EVP_PKEY_CTX for Ed25519");
     }
@@ -601,13 +443,16 @@ CryptoUtils::KeyPair CryptoUtils::generate_ed25519_keypair() {
 }
 
 CryptoUtils::KeyPair CryptoUtils::generate_sm2_keypair() {
+#if !DECENTRILICENSE_WITH_SM2
+    throw std::runtime_error("SM2 support is not compiled in");
+#else
     initialize_openssl();
     
     KeyPair result;
     
     // Generate SM2 key
     EVP_PKEY* pkey_raw = nullptr;
-    EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_SM2, nullptr);
+    EVP_PKEY_CTX* pctx = new_keygen_ctx(EVP_PKEY_SM2, "SM2");
     if (!pctx) {
         throw std::runtime_error("Failed to create EVP_PKEY_CTX for SM2");
     }
@@ -658,301 +503,283 @@ CryptoUtils::KeyPair CryptoUtils::generate_sm2_keypair() {
     BIO_free(bio_priv);
     
     return result;
+#endif
 }
 
-std::string CryptoUtils::sign_data(const std::string& data, const std::string& private_key_pem) {
-    // Load private key
-    BIOPtr bio(BIO_new_mem_buf(private_key_pem.c_str(), -1));
-    if (!bio) {
-        throw std::runtime_error("Failed to create BIO for private key");
-    }
-    
-    EVP_PKEY* pkey_raw = PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr);
-    if (!pkey_raw) {
-        throw std::runtime_error("Failed to read private key");
-    }
-    EVPKeyPtr pkey(pkey_raw);
-    
-    // Create signature context
-    EVPMDCtxPtr ctx(EVP_MD_CTX_new());
-    if (!ctx) {
-        throw std::runtime_error("Failed to create EVP_MD_CTX");
-    }
-    
-    if (EVP_DigestSignInit(ctx.get(), nullptr, EVP_sha256(), nullptr, pkey.get()) != 1) {
-        throw std::runtime_error("Failed to initialize signing");
+// RawSignature implementation
+void RawSignature::resize(size_t size) {
+    if (size > kMaxSize) {
+        throw std::length_error("Signature exceeds RawSignature capacity");
     }
-    
-    if (EVP_DigestSignUpdate(ctx.get(), data.c_str(), data.length()) != 1) {
-        throw std::runtime_error("Failed to update signature");
+    size_ = size;
+}
+
+std::string RawSignature::to_base64() const {
+    return Base64::encode(bytes_.data(), size_);
+}
+
+bool RawSignature::from_base64(std::string_view encoded, RawSignature* out) {
+    // decode() may need up to two bytes of slack for padded input
+    uint8_t buffer[kMaxSize + 3];
+    if (!out || Base64::decoded_max_length(encoded.size()) > sizeof(buffer)) {
+        return false;
     }
-    
-    // Determine signature length
-    size_t sig_len = 0;
-    if (EVP_DigestSignFinal(ctx.get(), nullptr, &sig_len) != 1) {
-        throw std::runtime_error("Failed to determine signature length");
+    size_t size = 0;
+    if (!Base64::decode(encoded, buffer, &size) || size > kMaxSize) {
+        return false;
     }
-    
-    // Generate signature
-    std::vector<uint8_t> signature(sig_len);
-    if (EVP_DigestSignFinal(ctx.get(), signature.data(), &sig_len) != 1) {
-        throw std::runtime_error("Failed to generate signature");
+    std::memcpy(out->bytes_.data(), buffer, size);
+    out->size_ = size;
+    return true;
+}
+
+// Runtime algorithm dispatch onto the Signer/Verifier specializations
+static bool init_verify_ctx(EVP_MD_CTX* ctx, SigningAlgorithm algorithm, EVP_PKEY* pkey) {
+    return with_signing_algorithm(
+        algorithm,
+        [&](auto tag) { return Verifier<decltype(tag)::value>::init(ctx, pkey); },
+        []() { return false; });
+}
+
+static bool finish_verify(EVP_MD_CTX* ctx, SigningAlgorithm algorithm,
+                          const uint8_t* data, size_t size,
+                          const uint8_t* sig, size_t sig_size) {
+    return with_signing_algorithm(
+        algorithm,
+        [&](auto tag) { return Verifier<decltype(tag)::value>::finish(ctx, data, size, sig, sig_size); },
+        []() { return false; });
+}
+
+static const uint8_t* bytes_of(std::string_view data) {
+    return reinterpret_cast<const uint8_t*>(data.data());
+}
+
+RawSignature CryptoUtils::sign(SigningAlgorithm algorithm, const KeyHandle& private_key,
+                               std::string_view data) {
+    return sign(algorithm, private_key, bytes_of(data), data.size());
+}
+
+RawSignature CryptoUtils::sign(SigningAlgorithm algorithm, const KeyHandle& private_key,
+                               const uint8_t* data, size_t size) {
+    return with_signing_algorithm(
+        algorithm,
+        [&](auto tag) { return Signer<decltype(tag)::value>::sign(private_key, data, size); },
+        [&]() -> RawSignature {
+            throw std::runtime_error(std::string(signing_algorithm_name(algorithm)) +
+                                     " support is not compiled in");
+        });
+}
+
+bool CryptoUtils::verify(SigningAlgorithm algorithm, const KeyHandle& public_key,
+                         std::string_view data, const RawSignature& signature) {
+    return verify(algorithm, public_key, bytes_of(data), data.size(),
+                  signature.data(), signature.size());
+}
+
+bool CryptoUtils::verify(SigningAlgorithm algorithm, const KeyHandle& public_key,
+                         const uint8_t* data, size_t size,
+                         const uint8_t* signature, size_t signature_size) {
+    return with_signing_algorithm(
+        algorithm,
+        [&](auto tag) {
+            return Verifier<decltype(tag)::value>::verify(public_key, data, size,
+                                                          signature, signature_size);
+        },
+        []() { return false; });
+}
+
+// Base64 wrappers for token fields
+static bool verify_encoded(SigningAlgorithm algorithm, const std::string& data,
+                           const std::string& signature, const KeyHandle& public_key) {
+    RawSignature raw;
+    if (!RawSignature::from_base64(signature, &raw)) {
+        return false;
     }
-    
-    signature.resize(sig_len);
-    return base64_encode(signature);
+    return CryptoUtils::verify(algorithm, public_key, data, raw);
 }
 
-bool CryptoUtils::verify_signature(const std::string& data, 
-                                   const std::string& signature,
-                                   const std::string& public_key_pem) {
+static bool verify_encoded(SigningAlgorithm algorithm, const std::string& data,
+                           const std::string& signature, const std::string& public_key_pem) {
     try {
-        // Load public key
-        BIOPtr bio(BIO_new_mem_buf(public_key_pem.c_str(), -1));
-        if (!bio) {
-            return false;
-        }
-        
-        EVP_PKEY* pkey_raw = PEM_read_bio_PUBKEY(bio.get(), nullptr, nullptr, nullptr);
-        if (!pkey_raw) {
-            return false;
-        }
-        EVPKeyPtr pkey(pkey_raw);
-        
-        // Decode signature
-        std::vector<uint8_t> sig_bytes = base64_decode(signature);
-        
-        // Create verification context
-        EVPMDCtxPtr ctx(EVP_MD_CTX_new());
-        if (!ctx) {
+        KeyHandle pkey = KeyCache::instance().get_public_key(public_key_pem);
+        if (!pkey) {
             return false;
         }
-        
-        if (EVP_DigestVerifyInit(ctx.get(), nullptr, EVP_sha256(), nullptr, pkey.get()) != 1) {
-            return false;
-        }
-        
-        if (EVP_DigestVerifyUpdate(ctx.get(), data.c_str(), data.length()) != 1) {
-            return false;
-        }
-        
-        int result = EVP_DigestVerifyFinal(ctx.get(), sig_bytes.data(), sig_bytes.size());
-        return result == 1;
+        return verify_encoded(algorithm, data, signature, pkey);
     } catch (...) {
         return false;
     }
 }
 
-std::string CryptoUtils::sign_ed25519_data(const std::string& data, const std::string& private_key_pem) {
-    // Load private key
-    BIOPtr bio(BIO_new_mem_buf(private_key_pem.c_str(), -1));
-    if (!bio) {
-        throw std::runtime_error("Failed to create BIO for Ed25519 private key");
+std::string CryptoUtils::sign_data(const std::string& data, const std::string& private_key_pem) {
+    KeyHandle pkey = KeyCache::instance().get_private_key(private_key_pem);
+    if (!pkey) {
+        throw std::runtime_error("Failed to read private key");
     }
-    
-    EVP_PKEY* pkey_raw = PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr);
-    if (!pkey_raw) {
+    return sign_data(data, pkey);
+}
+
+std::string CryptoUtils::sign_data(const std::string& data, const KeyHandle& private_key) {
+    return sign(SigningAlgorithm::RSA, private_key, data).to_base64();
+}
+
+bool CryptoUtils::verify_signature(const std::string& data, 
+                                   const std::string& signature,
+                                   const std::string& public_key_pem) {
+    return verify_encoded(SigningAlgorithm::RSA, data, signature, public_key_pem);
+}
+
+bool CryptoUtils::verify_signature(const std::string& data,
+                                   const std::string& signature,
+                                   const KeyHandle& public_key) {
+    return verify_encoded(SigningAlgorithm::RSA, data, signature, public_key);
+}
+
+std::string CryptoUtils::sign_ed25519_data(const std::string& data, const std::string& private_key_pem) {
+    KeyHandle pkey = KeyCache::instance().get_private_key(private_key_pem);
+    if (!pkey) {
         throw std::runtime_error("Failed to read Ed25519 private key");
     }
-    EVPKeyPtr pkey(pkey_raw);
-    
-    // Check if it's an Ed25519 key
-    int key_type = EVP_PKEY_id(pkey.get());
-    if (key_type != EVP_PKEY_ED25519) {
-        throw std::runtime_error("Not an Ed25519 key");
-    }
-    
-    // For Ed25519, we don't use a digest, we sign the raw data directly
-    // Create signature context
-    EVPMDCtxPtr ctx(EVP_MD_CTX_new());
-    if (!ctx) {
-        throw std::runtime_error("Failed to create EVP_MD_CTX");
-    }
-    
-    if (EVP_DigestSignInit(ctx.get(), nullptr, nullptr, nullptr, pkey.get()) != 1) {
-        throw std::runtime_error("Failed to initialize Ed25519 signing");
-    }
-    
-    // For Ed25519, we sign the raw data directly without hashing
-    size_t sig_len = 0;
-    if (EVP_DigestSign(ctx.get(), nullptr, &sig_len, 
-                      reinterpret_cast<const unsigned char*>(data.data()), data.length()) <= 0) {
-        throw std::runtime_error("Failed to determine Ed25519 signature length");
-    }
-    
-    // Generate signature
-    std::vector<uint8_t> signature(sig_len);
-    if (EVP_DigestSign(ctx.get(), signature.data(), &sig_len, 
-                      reinterpret_cast<const unsigned char*>(data.data()), data.length()) <= 0) {
-        throw std::runtime_error("Failed to generate Ed25519 signature");
+    return sign_ed25519_data(data, pkey);
+}
+
+std::string CryptoUtils::sign_ed25519_data(const std::string& data, const KeyHandle& private_key) {
+    if (!private_key) {
+        throw std::runtime_error("Failed to read Ed25519 private key");
     }
-    
-    signature.resize(sig_len);
-    return base64_encode(signature);
+    return sign(SigningAlgorithm::Ed25519, private_key, data).to_base64();
 }
 
 bool CryptoUtils::verify_ed25519_signature(const std::string& data, 
                                           const std::string& signature,
                                           const std::string& public_key_pem) {
-    try {
-        // Load public key
-        BIOPtr bio(BIO_new_mem_buf(public_key_pem.c_str(), -1));
-        if (!bio) {
-            return false;
-        }
-        
-        EVP_PKEY* pkey_raw = PEM_read_bio_PUBKEY(bio.get(), nullptr, nullptr, nullptr);
-        if (!pkey_raw) {
-            return false;
-        }
-        EVPKeyPtr pkey(pkey_raw);
-        
-        // Check if it's an Ed25519 key
-        int key_type = EVP_PKEY_id(pkey.get());
-        if (key_type != EVP_PKEY_ED25519) {
-            return false;
-        }
-        
-        // Decode signature
-        std::vector<uint8_t> sig_bytes = base64_decode(signature);
-        
-        // For Ed25519, we verify the raw data directly without hashing
-        // Create verification context
-        EVPMDCtxPtr ctx(EVP_MD_CTX_new());
-        if (!ctx) {
-            return false;
-        }
-        
-        if (EVP_DigestVerifyInit(ctx.get(), nullptr, nullptr, nullptr, pkey.get()) != 1) {
-            return false;
-        }
-        
-        // For Ed25519, we verify the raw data directly
-        int result = EVP_DigestVerify(ctx.get(), sig_bytes.data(), sig_bytes.size(),
-                                     reinterpret_cast<const unsigned char*>(data.data()), data.length());
-        return result == 1;
-    } catch (...) {
-        return false;
-    }
+    return verify_encoded(SigningAlgorithm::Ed25519, data, signature, public_key_pem);
+}
+
+bool CryptoUtils::verify_ed25519_signature(const std::string& data,
+                                          const std::string& signature,
+                                          const KeyHandle& public_key) {
+    return verify_encoded(SigningAlgorithm::Ed25519, data, signature, public_key);
 }
 
 std::string CryptoUtils::sign_sm2_data(const std::string& data, const std::string& private_key_pem) {
-    // Load private key
-    BIOPtr bio(BIO_new_mem_buf(private_key_pem.c_str(), -1));
-    if (!bio) {
-        throw std::runtime_error("Failed to create BIO for SM2 private key");
-    }
-    
-    EVP_PKEY* pkey_raw = PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr);
-    if (!pkey_raw) {
+    KeyHandle pkey = KeyCache::instance().get_private_key(private_key_pem);
+    if (!pkey) {
         throw std::runtime_error("Failed to read SM2 private key");
     }
-    EVPKeyPtr pkey(pkey_raw);
-    
-    // Check if it's an SM2 key
-    // In OpenSSL 3.0+, key type checking may not work as expected
-    // We'll skip the strict check for now and rely on the signing/verification process
-    /*
-    int key_type = EVP_PKEY_id(pkey.get());
-    if (key_type != EVP_PKEY_SM2 && key_type != EVP_PKEY_EC) {
-        throw std::runtime_error("Not an SM2 key");
-    }
-    */
-    
-    // Create signature context
-    EVPMDCtxPtr ctx(EVP_MD_CTX_new());
-    if (!ctx) {
-        throw std::runtime_error("Failed to create EVP_MD_CTX");
-    }
-    
-    // Use SM3 digest for SM2
-    // Skip setting SM2 ID for now to avoid compatibility issues
-    /*
-    if (EVP_PKEY_CTX_set1_id(EVP_MD_CTX_pkey_ctx(ctx.get()), "1234567812345678", 16) <= 0) {
-        throw std::runtime_error("Failed to set SM2 ID");
-    }
-    */
-    
-    if (EVP_DigestSignInit(ctx.get(), nullptr, EVP_sm3(), nullptr, pkey.get()) != 1) {
-        throw std::runtime_error("Failed to initialize SM2 signing");
-    }
-    
-    if (EVP_DigestSignUpdate(ctx.get(), data.c_str(), data.length()) != 1) {
-        throw std::runtime_error("Failed to update SM2 signature");
-    }
-    
-    // Determine signature length
-    size_t sig_len = 0;
-    if (EVP_DigestSignFinal(ctx.get(), nullptr, &sig_len) != 1) {
-        throw std::runtime_error("Failed to determine SM2 signature length");
-    }
-    
-    // Generate signature
-    std::vector<uint8_t> signature(sig_len);
-    if (EVP_DigestSignFinal(ctx.get(), signature.data(), &sig_len) != 1) {
-        throw std::runtime_error("Failed to generate SM2 signature");
+    return sign_sm2_data(data, pkey);
+}
+
+std::string CryptoUtils::sign_sm2_data(const std::string& data, const KeyHandle& private_key) {
+    if (!private_key) {
+        throw std::runtime_error("Failed to read SM2 private key");
     }
-    
-    signature.resize(sig_len);
-    return base64_encode(signature);
+    return sign(SigningAlgorithm::SM2, private_key, data).to_base64();
 }
 
 bool CryptoUtils::verify_sm2_signature(const std::string& data, 
                                      const std::string& signature,
                                      const std::string& public_key_pem) {
-    try {
-        // Load public key
-        BIOPtr bio(BIO_new_mem_buf(public_key_pem.c_str(), -1));
-        if (!bio) {
-            return false;
-        }
-        
-        EVP_PKEY* pkey_raw = PEM_read_bio_PUBKEY(bio.get(), nullptr, nullptr, nullptr);
-        if (!pkey_raw) {
-            return false;
-        }
-        EVPKeyPtr pkey(pkey_raw);
-        
-        // Check if it's an SM2 key
-        // In OpenSSL 3.0+, key type checking may not work as expected
-        // We'll skip the strict check for now and rely on the signing/verification process
-        /*
-        int key_type = EVP_PKEY_id(pkey.get());
-        if (key_type != EVP_PKEY_SM2 && key_type != EVP_PKEY_EC) {
-            return false;
-        }
-        */
-        
-        // Decode signature
-        std::vector<uint8_t> sig_bytes = base64_decode(signature);
-        
-        // Create verification context
-        EVPMDCtxPtr ctx(EVP_MD_CTX_new());
-        if (!ctx) {
-            return false;
+    return verify_encoded(SigningAlgorithm::SM2, data, signature, public_key_pem);
+}
+
+bool CryptoUtils::verify_sm2_signature(const std::string& data,
+                                     const std::string& signature,
+                                     const KeyHandle& public_key) {
+    return verify_encoded(SigningAlgorithm::SM2, data, signature, public_key);
+}
+
+VerificationBitmap CryptoUtils::verify_batch(const std::vector<SignatureCheck>& items) {
+    return verify_batch(items.data(), items.size());
+}
+
+VerificationBitmap CryptoUtils::verify_batch(const SignatureCheck* items, size_t count) {
+    VerificationBitmap bitmap(count, false);
+    if (!items || count == 0) {
+        return bitmap;
+    }
+
+    // Resolve each distinct key once
+    std::unordered_map<std::string_view, size_t> key_index;
+    std::vector<KeyHandle> keys;
+    std::vector<size_t> item_key(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto it = key_index.find(items[i].public_key_pem);
+        if (it == key_index.end()) {
+            keys.push_back(KeyCache::instance().get_public_key(std::string(items[i].public_key_pem)));
+            it = key_index.emplace(items[i].public_key_pem, keys.size() - 1).first;
         }
-        
-        // Use SM3 digest for SM2
-        // Skip setting SM2 ID for now to avoid compatibility issues
-        /*
-        if (EVP_PKEY_CTX_set1_id(EVP_MD_CTX_pkey_ctx(ctx.get()), "1234567812345678", 16) <= 0) {
-            return false;
+        item_key[i] = it->second;
+    }
+
+    // Order items so that checks sharing a key and algorithm are adjacent and
+    // can reuse one initialized verification context
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (item_key[a] != item_key[b]) {
+            return item_key[a] < item_key[b];
         }
-        */
-        
-        if (EVP_DigestVerifyInit(ctx.get(), nullptr, EVP_sm3(), nullptr, pkey.get()) != 1) {
-            return false;
+        return static_cast<int>(items[a].algorithm) < static_cast<int>(items[b].algorithm);
+    });
+
+    std::vector<uint8_t> results(count, 0);
+    // The library context is per thread: pool threads must enter the caller's
+    const CryptoContext* context = current_crypto_context();
+    WorkerPool::shared().parallel_for(count, 16, [&](size_t begin, size_t end) {
+        ScopedCryptoContext crypto_scope(context);
+        MdCtxPool::Lease tmpl = MdCtxPool::acquire();
+        MdCtxPool::Lease work = MdCtxPool::acquire();
+        if (!tmpl || !work) {
+            return;
         }
-        
-        if (EVP_DigestVerifyUpdate(ctx.get(), data.c_str(), data.length()) != 1) {
-            return false;
+
+        size_t tmpl_key = keys.size();
+        SigningAlgorithm tmpl_alg = SigningAlgorithm::RSA;
+        bool tmpl_ok = false;
+
+        for (size_t pos = begin; pos < end; ++pos) {
+            const size_t idx = order[pos];
+            const SignatureCheck& item = items[idx];
+            const KeyHandle& key = keys[item_key[idx]];
+            if (!key) {
+                continue;
+            }
+
+            if (tmpl_key != item_key[idx] || tmpl_alg != item.algorithm) {
+                EVP_MD_CTX_reset(tmpl.get());
+                tmpl_ok = init_verify_ctx(tmpl.get(), item.algorithm, key.get());
+                tmpl_key = item_key[idx];
+                tmpl_alg = item.algorithm;
+            }
+            if (!tmpl_ok) {
+                continue;
+            }
+
+            RawSignature sig;
+            if (!RawSignature::from_base64(item.signature, &sig)) {
+                continue;
+            }
+            const uint8_t* data = bytes_of(item.data);
+            bool ok = false;
+            if (EVP_MD_CTX_copy_ex(work.get(), tmpl.get()) == 1) {
+                ok = finish_verify(work.get(), item.algorithm, data, item.data.size(),
+                                   sig.data(), sig.size());
+            } else {
+                // Provider cannot duplicate this context, initialize from scratch
+                EVP_MD_CTX_reset(work.get());
+                ok = init_verify_ctx(work.get(), item.algorithm, key.get()) &&
+                     finish_verify(work.get(), item.algorithm, data, item.data.size(),
+                                   sig.data(), sig.size());
+            }
+            results[idx] = ok ? 1 : 0;
         }
-        
-        int result = EVP_DigestVerifyFinal(ctx.get(), sig_bytes.data(), sig_bytes.size());
-        return result == 1;
-    } catch (...) {
-        return false;
+    });
+
+    for (size_t i = 0; i < count; ++i) {
+        bitmap[i] = results[i] != 0;
     }
+    return bitmap;
 }
 
 }  // namespace decentrilicense
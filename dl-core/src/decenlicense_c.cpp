@@ -2,8 +2,12 @@
 #include "decentrilicense/decentrilicense_client.hpp"
 #include "decentrilicense/token_manager.hpp"
 #include "decentrilicense/crypto_utils.hpp"
+#include "decentrilicense/key_pair_pool.hpp"
+#include "decentrilicense/trust_anchor_store.hpp"
 #include "decentrilicense/root_key.hpp"
 #include "state_chain_storage.h"
+#include "crypto_context.hpp"
+#include "json_writer.hpp"
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -13,6 +17,61 @@
 
 using namespace decentrilicense;
 
+// The C API's own layout (different field order, device_info from the
+// client); record_usage chains hash exactly these bytes
+template <typename Writer>
+static void write_client_token_json(
+    Writer& out,
+    const Token& t,
+    const std::string& device_fingerprint,
+    const std::string& device_public_key_pem,
+    const std::string& device_signature_b64,
+    bool include_device_info) {
+    out.literal("{\"token_id\":\"");
+    out.escaped(t.token_id);
+    out.literal("\",\"license_code\":\"");
+    out.escaped(t.license_code);
+    out.literal("\",\"holder_device_id\":\"");
+    out.escaped(t.holder_device_id);
+    out.literal("\",\"issue_time\":");
+    out.number(t.issue_time);
+    out.literal(",\"expire_time\":");
+    out.number(t.expire_time);
+    out.literal(",\"signature\":\"");
+    out.escaped(t.signature);
+    out.literal("\",\"app_id\":\"");
+    out.escaped(t.app_id);
+    out.literal("\",\"environment_hash\":\"");
+    out.escaped(t.environment_hash);
+    out.literal("\",\"license_public_key\":\"");
+    out.escaped(t.license_public_key);
+    out.literal("\",\"root_signature\":\"");
+    out.escaped(t.root_signature);
+    out.literal("\",\"state_index\":");
+    out.number(t.state_index);
+    out.literal(",\"prev_state_hash\":\"");
+    out.escaped(t.prev_state_hash);
+    out.literal("\",\"state_payload\":\"");
+    out.escaped(t.state_payload);
+    out.literal("\",\"state_signature\":\"");
+    out.escaped(t.state_signature);
+    out.literal("\",\"alg\":\"");
+    out.literal(t.alg ? signing_algorithm_name(*t.alg) : "");
+    out.literal("\"");
+
+    if (include_device_info && !device_public_key_pem.empty() && !device_signature_b64.empty()) {
+        out.literal(",\"device_info\":{\"fingerprint\":\"");
+        out.escaped(device_fingerprint);
+        out.literal("\",\"public_key\":\"");
+        out.escaped(device_public_key_pem);
+        out.literal("\",\"signature\":\"");
+        out.escaped(device_signature_b64);
+        out.literal("\"}");
+    }
+
+    out.literal("}");
+}
+
 extern "C" {
 
 static void set_err(DL_VerificationResult* result, const std::string& msg) {
@@ -32,22 +91,6 @@ static void set_ok(DL_VerificationResult* result) {
     result->error_message[0] = '\0';
 }
 
-static std::string json_escape(const std::string& s) {
-    std::string out;
-    out.reserve(s.size() + 16);
-    for (char c : s) {
-        switch (c) {
-            case '\\': out += "\\\\"; break;
-            case '"': out += "\\\""; break;
-            case '\n': out += "\\n"; break;
-            case '\r': out += "\\r"; break;
-            case '\t': out += "\\t"; break;
-            default: out.push_back(c); break;
-        }
-    }
-    return out;
-}
-
 static std::string build_state_sig_data(uint64_t state_index, const std::string& prev_state_hash, const std::string& state_payload) {
     return std::to_string(state_index) + "|" + prev_state_hash + "|" + state_payload;
 }
@@ -58,34 +101,13 @@ static std::string build_token_json(
     const std::string& device_public_key_pem,
     const std::string& device_signature_b64,
     bool include_device_info) {
-    std::string json;
-    json.reserve(2048);
-    json += "{";
-    json += "\"token_id\":\"" + json_escape(t.token_id) + "\",";
-    json += "\"license_code\":\"" + json_escape(t.license_code) + "\",";
-    json += "\"holder_device_id\":\"" + json_escape(t.holder_device_id) + "\",";
-    json += "\"issue_time\":" + std::to_string(t.issue_time) + ",";
-    json += "\"expire_time\":" + std::to_string(t.expire_time) + ",";
-    json += "\"signature\":\"" + json_escape(t.signature) + "\",";
-    json += "\"app_id\":\"" + json_escape(t.app_id) + "\",";
-    json += "\"environment_hash\":\"" + json_escape(t.environment_hash) + "\",";
-    json += "\"license_public_key\":\"" + json_escape(t.license_public_key) + "\",";
-    json += "\"root_signature\":\"" + json_escape(t.root_signature) + "\",";
-    json += "\"state_index\":" + std::to_string(t.state_index) + ",";
-    json += "\"prev_state_hash\":\"" + json_escape(t.prev_state_hash) + "\",";
-    json += "\"state_payload\":\"" + json_escape(t.state_payload) + "\",";
-    json += "\"state_signature\":\"" + json_escape(t.state_signature) + "\",";
-    json += "\"alg\":\"" + json_escape(t.alg) + "\"";
-
-    if (include_device_info && !device_public_key_pem.empty() && !device_signature_b64.empty()) {
-        json += ",\"device_info\":{";
-        json += "\"fingerprint\":\"" + json_escape(device_fingerprint) + "\",";
-        json += "\"public_key\":\"" + json_escape(device_public_key_pem) + "\",";
-        json += "\"signature\":\"" + json_escape(device_signature_b64) + "\"";
-        json += "}";
-    }
-
-    json += "}";
+    JsonSizeCounter counter;
+    write_client_token_json(counter, t, device_fingerprint, device_public_key_pem,
+                            device_signature_b64, include_device_info);
+    std::string json(counter.size(), '\0');
+    JsonBufferWriter writer(&json[0]);
+    write_client_token_json(writer, t, device_fingerprint, device_public_key_pem,
+                            device_signature_b64, include_device_info);
     return json;
 }
 
@@ -100,74 +122,6 @@ static std::string trim(std::string s) {
     return s.substr(i);
 }
 
-static std::string extract_json_string(const std::string& json, const std::string& key) {
-    const std::string pat = "\"" + key + "\"";
-    size_t p = json.find(pat);
-    if (p == std::string::npos) {
-        return "";
-    }
-    p = json.find(':', p + pat.size());
-    if (p == std::string::npos) {
-        return "";
-    }
-    p++;
-    while (p < json.size() && (json[p] == ' ' || json[p] == '\t' || json[p] == '\n' || json[p] == '\r')) {
-        p++;
-    }
-    if (p >= json.size() || json[p] != '"') {
-        return "";
-    }
-    p++;
-    std::string out;
-    for (; p < json.size(); p++) {
-        char c = json[p];
-        if (c == '\\') {
-            if (p + 1 < json.size()) {
-                char n = json[p + 1];
-                if (n == 'n') out.push_back('\n');
-                else if (n == 'r') out.push_back('\r');
-                else if (n == 't') out.push_back('\t');
-                else out.push_back(n);
-                p++;
-                continue;
-            }
-        }
-        if (c == '"') {
-            break;
-        }
-        out.push_back(c);
-    }
-    return out;
-}
-
-static uint64_t extract_json_u64(const std::string& json, const std::string& key) {
-    const std::string pat = "\"" + key + "\"";
-    size_t p = json.find(pat);
-    if (p == std::string::npos) {
-        return 0;
-    }
-    p = json.find(':', p + pat.size());
-    if (p == std::string::npos) {
-        return 0;
-    }
-    p++;
-    while (p < json.size() && (json[p] == ' ' || json[p] == '\t' || json[p] == '\n' || json[p] == '\r')) {
-        p++;
-    }
-    size_t e = p;
-    while (e < json.size() && (json[e] == '-' || (json[e] >= '0' && json[e] <= '9'))) {
-        e++;
-    }
-    if (e == p) {
-        return 0;
-    }
-    try {
-        return static_cast<uint64_t>(std::stoull(json.substr(p, e - p)));
-    } catch (...) {
-        return 0;
-    }
-}
-
 static bool is_encrypted_token_format(const std::string& input) {
     size_t sep = input.find('|');
     if (sep == std::string::npos) {
@@ -199,6 +153,9 @@ static bool split_product_public_key_file(const std::string& file_content, std::
 
 // Implementation of the opaque pointer
 struct DL_Client {
+    // Declared first so it is released after everything that may hold keys from it
+    std::shared_ptr<CryptoContext> crypto_context;
+    DL_CryptoContextMode crypto_context_mode = DL_CRYPTO_CONTEXT_DEFAULT;
     std::unique_ptr<DecentriLicenseClient> client;
     ClientConfig config;
     std::string product_public_key_file_content;
@@ -211,10 +168,19 @@ struct DL_Client {
     std::string device_id;
     std::string device_public_key_pem;
     std::string device_private_key_pem;
+    KeyHandle device_public_key;        // Parsed device_public_key_pem
+    KeyHandle device_private_key;       // Parsed device_private_key_pem
     std::string device_signature;
     std::unique_ptr<StateChainStorage> storage;
+    LicenseState license_state;         // Mirrors has_token, activated and token.expire_time
 };
 
+// Every change of activated goes through here so license_state stays in step
+static void set_activated(DL_Client* client, bool activated) {
+    client->activated = activated;
+    client->license_state.publish(activated && client->has_token, client->token.expire_time);
+}
+
 // Create a new client
 DL_Client* dl_client_create(void) {
     try {
@@ -232,6 +198,18 @@ void dl_client_destroy(DL_Client* client) {
     }
 }
 
+// Select the OpenSSL library context
+DL_ErrorCode dl_client_set_crypto_context_mode(DL_Client* client, DL_CryptoContextMode mode) {
+    if (!client || mode < DL_CRYPTO_CONTEXT_DEFAULT || mode > DL_CRYPTO_CONTEXT_PER_CLIENT) {
+        return DL_ERROR_INVALID_ARGUMENT;
+    }
+    if (client->client) {
+        return DL_ERROR_ALREADY_INITIALIZED;
+    }
+    client->crypto_context_mode = mode;
+    return DL_ERROR_SUCCESS;
+}
+
 // Initialize the client
 DL_ErrorCode dl_client_initialize(DL_Client* client, const DL_ClientConfig* config) {
     if (!client || !config) {
@@ -245,6 +223,22 @@ DL_ErrorCode dl_client_initialize(DL_Client* client, const DL_ClientConfig* conf
         client->config.tcp_port = config->tcp_port > 0 ? config->tcp_port : 23325;
         client->config.registry_server_url = config->registry_server_url ? config->registry_server_url : "";
 
+        switch (client->crypto_context_mode) {
+            case DL_CRYPTO_CONTEXT_SHARED:
+                client->crypto_context = CryptoContext::shared();
+                break;
+            case DL_CRYPTO_CONTEXT_PER_CLIENT:
+                client->crypto_context = std::make_shared<CryptoContext>();
+                break;
+            default:
+                client->crypto_context.reset();
+                break;
+        }
+        ScopedCryptoContext crypto_scope(client->crypto_context.get());
+
+        // Start pre-generating device keys so activation does not wait for keygen
+        (void)KeyPairPool::shared();
+
         client->client = std::make_unique<DecentriLicenseClient>(client->config);
         client->device_id = CryptoUtils::generate_device_id();
         client->storage = std::make_unique<StateChainStorage>(std::string(".decentrilicense_state"));
@@ -258,6 +252,7 @@ DL_ErrorCode dl_client_set_product_public_key(DL_Client* client, const char* pro
     if (!client || !product_public_key_file_content) {
         return DL_ERROR_INVALID_ARGUMENT;
     }
+    ScopedCryptoContext crypto_scope(client->crypto_context.get());
     try {
         client->product_public_key_file_content = product_public_key_file_content;
         if (!split_product_public_key_file(client->product_public_key_file_content, &client->product_public_key_pem, &client->product_root_signature)) {
@@ -269,16 +264,35 @@ DL_ErrorCode dl_client_set_product_public_key(DL_Client* client, const char* pro
             client->client->set_product_public_key(client->product_public_key_pem);
         }
 
+        // Parse it once for the whole process; offline verification only
+        // looks it up
+        (void)TrustAnchorStore::instance().add(TrustAnchor::Kind::Product, client->product_public_key_pem);
+
         return DL_ERROR_SUCCESS;
     } catch (...) {
         return DL_ERROR_UNKNOWN_ERROR;
     }
 }
 
+// Make token the client's current token and start its stored chain
+static void install_token(DL_Client* client, const Token& token, std::string token_json) {
+    client->token_json = std::move(token_json);
+    client->token = token;
+    client->has_token = true;
+    set_activated(client, false);
+
+    if (client->storage && !client->token.license_code.empty()) {
+        std::vector<Token> chain;
+        chain.push_back(client->token);
+        (void)client->storage->saveFullChain(client->token.license_code, chain);
+    }
+}
+
 DL_ErrorCode dl_client_import_token(DL_Client* client, const char* token_input) {
     if (!client || !token_input) {
         return DL_ERROR_INVALID_ARGUMENT;
     }
+    ScopedCryptoContext crypto_scope(client->crypto_context.get());
     if (client->product_public_key_pem.empty()) {
         return DL_ERROR_NOT_INITIALIZED;
     }
@@ -287,38 +301,21 @@ DL_ErrorCode dl_client_import_token(DL_Client* client, const char* token_input)
         std::string input = token_input;
         std::string json;
         if (is_encrypted_token_format(input)) {
+            // The encrypted payload is either JSON or the binary encoding
             json = CryptoUtils::decrypt_token_aes256_gcm(input, client->product_public_key_file_content);
         } else {
             json = input;
         }
 
         Token t;
-        t.token_id = extract_json_string(json, "token_id");
-        t.app_id = extract_json_string(json, "app_id");
-        t.holder_device_id = extract_json_string(json, "holder_device_id");
-        t.license_code = extract_json_string(json, "license_code");
-        t.issue_time = extract_json_u64(json, "issue_time");
-        t.expire_time = extract_json_u64(json, "expire_time");
-        t.environment_hash = extract_json_string(json, "environment_hash");
-        t.root_signature = extract_json_string(json, "root_signature");
-        t.state_index = extract_json_u64(json, "state_index");
-        t.prev_state_hash = extract_json_string(json, "prev_state_hash");
-        t.state_payload = extract_json_string(json, "state_payload");
-        t.state_signature = extract_json_string(json, "state_signature");
-        t.alg = extract_json_string(json, "alg");
-        t.signature = extract_json_string(json, "signature");
-
-        client->token_json = json;
-        client->token = t;
-        client->has_token = true;
-        client->activated = false;
-
-        if (client->storage && !client->token.license_code.empty()) {
-            std::vector<Token> chain;
-            chain.push_back(client->token);
-            (void)client->storage->saveFullChain(client->token.license_code, chain);
+        if (!Token::decode(json, &t)) {
+            return DL_ERROR_INVALID_ARGUMENT;
+        }
+        if (Token::is_binary(reinterpret_cast<const uint8_t*>(json.data()), json.size())) {
+            json = t.to_json();
         }
 
+        install_token(client, t, std::move(json));
         return DL_ERROR_SUCCESS;
     } catch (const std::exception&) {
         return DL_ERROR_CRYPTO_ERROR;
@@ -327,6 +324,27 @@ DL_ErrorCode dl_client_import_token(DL_Client* client, const char* token_input)
     }
 }
 
+DL_ErrorCode dl_client_import_token_binary(DL_Client* client, const uint8_t* data, size_t size) {
+    if (!client || !data) {
+        return DL_ERROR_INVALID_ARGUMENT;
+    }
+    ScopedCryptoContext crypto_scope(client->crypto_context.get());
+    if (client->product_public_key_pem.empty()) {
+        return DL_ERROR_NOT_INITIALIZED;
+    }
+
+    try {
+        Token t;
+        if (!Token::from_binary(data, size, &t)) {
+            return DL_ERROR_INVALID_ARGUMENT;
+        }
+        install_token(client, t, t.to_json());
+        return DL_ERROR_SUCCESS;
+    } catch (...) {
+        return DL_ERROR_UNKNOWN_ERROR;
+    }
+}
+
 DL_ErrorCode dl_client_reset(DL_Client* client) {
     if (!client) {
         return DL_ERROR_INVALID_ARGUMENT;
@@ -336,7 +354,7 @@ DL_ErrorCode dl_client_reset(DL_Client* client) {
         client->token_json.clear();
         client->token = Token();
         client->has_token = false;
-        client->activated = false;
+        set_activated(client, false);
         return DL_ERROR_SUCCESS;
     } catch (...) {
         return DL_ERROR_UNKNOWN_ERROR;
@@ -356,10 +374,39 @@ DL_ErrorCode dl_client_get_current_token_json(DL_Client* client, char* out_json,
     return DL_ERROR_SUCCESS;
 }
 
+DL_ErrorCode dl_client_get_current_token_binary(DL_Client* client, uint8_t* out, size_t* size) {
+    if (!client || !size) {
+        return DL_ERROR_INVALID_ARGUMENT;
+    }
+    if (!client->has_token) {
+        *size = 0;
+        return DL_ERROR_SUCCESS;
+    }
+
+    try {
+        // token_json carries the device_info added on activation
+        Token current;
+        if (!Token::from_json(client->token_json, &current)) {
+            return DL_ERROR_UNKNOWN_ERROR;
+        }
+        const std::vector<uint8_t> encoded = current.to_binary();
+        const size_t capacity = *size;
+        *size = encoded.size();
+        if (!out || capacity < encoded.size()) {
+            return DL_ERROR_INVALID_ARGUMENT;
+        }
+        std::memcpy(out, encoded.data(), encoded.size());
+        return DL_ERROR_SUCCESS;
+    } catch (...) {
+        return DL_ERROR_UNKNOWN_ERROR;
+    }
+}
+
 DL_ErrorCode dl_client_export_current_token_encrypted(DL_Client* client, char* out_encrypted, size_t out_encrypted_size) {
     if (!client || !out_encrypted || out_encrypted_size == 0) {
         return DL_ERROR_INVALID_ARGUMENT;
     }
+    ScopedCryptoContext crypto_scope(client->crypto_context.get());
     if (!client->has_token) {
         out_encrypted[0] = '\0';
         return DL_ERROR_SUCCESS;
@@ -384,6 +431,7 @@ DL_ErrorCode dl_client_export_activated_token_encrypted(DL_Client* client, char*
     if (!client || !out_encrypted || out_encrypted_size == 0) {
         return DL_ERROR_INVALID_ARGUMENT;
     }
+    ScopedCryptoContext crypto_scope(client->crypto_context.get());
     if (!client->activated) {
         out_encrypted[0] = '\0';
         return DL_ERROR_SUCCESS;
@@ -412,6 +460,7 @@ DL_ErrorCode dl_client_export_state_changed_token_encrypted(DL_Client* client, c
     if (!client || !out_encrypted || out_encrypted_size == 0) {
         return DL_ERROR_INVALID_ARGUMENT;
     }
+    ScopedCryptoContext crypto_scope(client->crypto_context.get());
     if (!client->has_token) {
         out_encrypted[0] = '\0';
         return DL_ERROR_SUCCESS;
@@ -436,6 +485,7 @@ DL_ErrorCode dl_client_offline_verify_current_token(DL_Client* client, DL_Verifi
     if (!client || !result) {
         return DL_ERROR_INVALID_ARGUMENT;
     }
+    ScopedCryptoContext crypto_scope(client->crypto_context.get());
     if (!client->has_token) {
         set_err(result, "no token");
         return DL_ERROR_SUCCESS;
@@ -461,8 +511,13 @@ DL_ErrorCode dl_client_offline_verify_current_token(DL_Client* client, DL_Verifi
             verify_token.root_signature = client->product_root_signature;
         }
 
-        TokenManager tm;
-        bool ok = tm.verify_token_trust_chain(verify_token);
+        if (!TrustAnchorStore::instance().snapshot().find(TrustAnchor::Kind::Product,
+                                                          client->product_public_key_pem)) {
+            set_err(result, "product public key is not a valid trust anchor");
+            return DL_ERROR_SUCCESS;
+        }
+
+        bool ok = TokenManager::verify_token_trust_chain(verify_token);
         if (!ok) {
             set_err(result, "trust chain verification failed");
             return DL_ERROR_SUCCESS;
@@ -476,7 +531,9 @@ DL_ErrorCode dl_client_offline_verify_current_token(DL_Client* client, DL_Verifi
             const std::string state_sig_data = build_state_sig_data(client->token.state_index, client->token.prev_state_hash, client->token.state_payload);
             bool state_ok = false;
             try {
-                state_ok = CryptoUtils::verify_ed25519_signature(state_sig_data, client->token.state_signature, client->device_public_key_pem);
+                RawSignature raw;
+                state_ok = RawSignature::from_base64(client->token.state_signature, &raw) &&
+                           CryptoUtils::verify(SigningAlgorithm::Ed25519, client->device_public_key, state_sig_data, raw);
             } catch (...) {
                 state_ok = false;
             }
@@ -526,6 +583,7 @@ DL_ErrorCode dl_client_activate_bind_device(DL_Client* client, DL_VerificationRe
     if (!client || !result) {
         return DL_ERROR_INVALID_ARGUMENT;
     }
+    ScopedCryptoContext crypto_scope(client->crypto_context.get());
     if (!client->has_token) {
         set_err(result, "no token");
         return DL_ERROR_SUCCESS;
@@ -554,7 +612,7 @@ DL_ErrorCode dl_client_activate_bind_device(DL_Client* client, DL_VerificationRe
 
         // If no saved keys exist, generate new ones
         if (!keys_loaded) {
-            auto kp = CryptoUtils::generate_ed25519_keypair();
+            auto kp = KeyPairPool::shared().acquire(SigningAlgorithm::Ed25519);
             client->device_private_key_pem = kp.private_key_pem;
             client->device_public_key_pem = kp.public_key_pem;
             client->device_id = CryptoUtils::generate_device_id();
@@ -570,10 +628,13 @@ DL_ErrorCode dl_client_activate_bind_device(DL_Client* client, DL_VerificationRe
             }
         }
 
+        client->device_public_key = KeyCache::instance().get_public_key(client->device_public_key_pem);
+        client->device_private_key = KeyCache::instance().get_private_key(client->device_private_key_pem);
+
         const std::string data_to_sign = client->device_id + client->device_public_key_pem;
-        client->device_signature = CryptoUtils::sign_ed25519_data(data_to_sign, client->device_private_key_pem);
+        client->device_signature = CryptoUtils::sign(SigningAlgorithm::Ed25519, client->device_private_key, data_to_sign).to_base64();
 
-        client->activated = true;
+        set_activated(client, true);
         client->token.holder_device_id = client->device_id;
         client->token.license_public_key = "";
 
@@ -597,6 +658,7 @@ DL_ErrorCode dl_client_record_usage(DL_Client* client, const char* new_state_pay
     if (!client || !new_state_payload_json || !result) {
         return DL_ERROR_INVALID_ARGUMENT;
     }
+    ScopedCryptoContext crypto_scope(client->crypto_context.get());
     if (!client->has_token) {
         set_err(result, "no token");
         return DL_ERROR_SUCCESS;
@@ -618,7 +680,7 @@ DL_ErrorCode dl_client_record_usage(DL_Client* client, const char* new_state_pay
         client->token.state_payload = new_state_payload_json;
 
         const std::string state_sig_data = build_state_sig_data(client->token.state_index, client->token.prev_state_hash, client->token.state_payload);
-        client->token.state_signature = CryptoUtils::sign_ed25519_data(state_sig_data, client->device_private_key_pem);
+        client->token.state_signature = CryptoUtils::sign(SigningAlgorithm::Ed25519, client->device_private_key, state_sig_data).to_base64();
 
         client->token_json = build_token_json(client->token, client->device_id, client->device_public_key_pem, client->device_signature, true);
 
@@ -642,6 +704,7 @@ DL_ErrorCode dl_client_activate(DL_Client* client, DL_ActivationResult* result)
     if (!client || !result) {
         return DL_ERROR_INVALID_ARGUMENT;
     }
+    ScopedCryptoContext crypto_scope(client->crypto_context.get());
 
     if (!client->client) {
         return DL_ERROR_NOT_INITIALIZED;
@@ -671,6 +734,7 @@ DL_ErrorCode dl_client_activate_with_token(DL_Client* client, const char* token_
     if (!client || !token_string || !result) {
         return DL_ERROR_INVALID_ARGUMENT;
     }
+    ScopedCryptoContext crypto_scope(client->crypto_context.get());
 
     if (!client->client) {
         return DL_ERROR_NOT_INITIALIZED;
@@ -681,7 +745,7 @@ DL_ErrorCode dl_client_activate_with_token(DL_Client* client, const char* token_
     client->token_json.clear();
     client->token = Token();
     client->has_token = false;
-    client->activated = false;
+    set_activated(client, false);
 
     try {
         std::string token_str(token_string);
@@ -719,27 +783,15 @@ DL_ErrorCode dl_client_activate_with_token(DL_Client* client, const char* token_
             json_token_str = token_str;
         }
 
-        // Parse JSON token (using same logic as dl_client_import_token)
+        // Parse JSON or binary token (same as dl_client_import_token)
         Token token;
-        token.token_id = extract_json_string(json_token_str, "token_id");
-        token.app_id = extract_json_string(json_token_str, "app_id");
-        token.holder_device_id = extract_json_string(json_token_str, "holder_device_id");
-        token.license_code = extract_json_string(json_token_str, "license_code");
-        token.issue_time = extract_json_u64(json_token_str, "issue_time");
-        token.expire_time = extract_json_u64(json_token_str, "expire_time");
-        token.environment_hash = extract_json_string(json_token_str, "environment_hash");
-        token.root_signature = extract_json_string(json_token_str, "root_signature");
-        token.state_index = extract_json_u64(json_token_str, "state_index");
-        token.prev_state_hash = extract_json_string(json_token_str, "prev_state_hash");
-        token.state_payload = extract_json_string(json_token_str, "state_payload");
-        token.state_signature = extract_json_string(json_token_str, "state_signature");
-        token.alg = extract_json_string(json_token_str, "alg");
-        token.signature = extract_json_string(json_token_str, "signature");
-
-        // Extract additional fields if present
-        token.license_public_key = extract_json_string(json_token_str, "license_public_key");
-        token.encrypted_license_private_key = extract_json_string(json_token_str, "encrypted_license_private_key");
-
+        if (!Token::decode(json_token_str, &token)) {
+            result->success = 0;
+            strncpy(result->message, "Invalid token format", sizeof(result->message) - 1);
+            result->message[sizeof(result->message) - 1] = '\0';
+            result->token = nullptr;
+            return DL_ERROR_INVALID_ARGUMENT;
+        }
 
         // Verify token trust chain
         bool trust_valid = client->client->verify_token_trust_chain(token);
@@ -804,6 +856,7 @@ int dl_client_is_activated(DL_Client* client) {
     if (!client || !client->client) {
         return 0;
     }
+    ScopedCryptoContext crypto_scope(client->crypto_context.get());
 
     // If already marked as activated in memory, return true
     if (client->activated) {
@@ -820,7 +873,7 @@ int dl_client_is_activated(DL_Client* client) {
                 // If the stored state has a holder_device_id, it means it was activated
                 if (!current_state->holder_device_id.empty()) {
                     // Restore activation state from storage
-                    client->activated = true;
+                    set_activated(client, true);
                     client->device_id = current_state->holder_device_id;
                     return 1;
                 }
@@ -833,6 +886,46 @@ int dl_client_is_activated(DL_Client* client) {
     return 0;
 }
 
+int dl_client_is_licensed(DL_Client* client) {
+    return client && client->license_state.is_licensed() ? 1 : 0;
+}
+
+// Set how state chain records reach disk
+DL_ErrorCode dl_client_set_durability(DL_Client* client, DL_Durability durability,
+                                      uint32_t group_commit_records, uint32_t group_commit_delay_ms) {
+    if (!client) {
+        return DL_ERROR_INVALID_ARGUMENT;
+    }
+
+    DurabilityOptions options;
+    switch (durability) {
+        case DL_DURABILITY_NONE:
+            options.level = ChainDurability::None;
+            break;
+        case DL_DURABILITY_OS_BUFFERED:
+            options.level = ChainDurability::OsBuffered;
+            break;
+        case DL_DURABILITY_SYNC:
+            options.level = ChainDurability::SyncEachRecord;
+            break;
+        case DL_DURABILITY_GROUP_COMMIT:
+            options.level = ChainDurability::GroupCommit;
+            break;
+        default:
+            return DL_ERROR_INVALID_ARGUMENT;
+    }
+    if (group_commit_records != 0) {
+        options.group_commit_records = group_commit_records;
+    }
+    options.group_commit_delay = std::chrono::milliseconds(group_commit_delay_ms);
+
+    if (!client->storage) {
+        return DL_ERROR_NOT_INITIALIZED;
+    }
+    client->storage->setDurability(options);
+    return DL_ERROR_SUCCESS;
+}
+
 // Get device ID
 DL_ErrorCode dl_client_get_device_id(DL_Client* client, char* device_id, size_t device_id_size) {
     if (!client || !device_id || device_id_size == 0) {
@@ -863,6 +956,7 @@ DL_ErrorCode dl_client_verify_token_trust_chain(DL_Client* client, const DL_Toke
     if (!client || !token || !result) {
         return DL_ERROR_INVALID_ARGUMENT;
     }
+    ScopedCryptoContext crypto_scope(client->crypto_context.get());
 
     if (!client->client) {
         return DL_ERROR_NOT_INITIALIZED;
@@ -881,12 +975,8 @@ DL_ErrorCode dl_client_verify_token_trust_chain(DL_Client* client, const DL_Toke
         cpp_token.app_id = std::string(token->app_id);
         cpp_token.license_code = std::string(token->license_code);
 
-        // Get the token manager from the client
-        // Note: In a real implementation, you would access the token manager through the client
-        TokenManager token_manager;
-
         // Always use the hardcoded ROOT_PUBLIC_KEY (ignore root_public_key_pem parameter)
-        bool valid = token_manager.verify_token_trust_chain(cpp_token);
+        bool valid = TokenManager::verify_token_trust_chain(cpp_token);
         
         result->valid = valid ? 1 : 0;
         if (!valid) {
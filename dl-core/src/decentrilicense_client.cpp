@@ -14,6 +14,9 @@
 
 namespace decentrilicense {
 
+// Discovery broadcast period
+static constexpr std::chrono::seconds kDiscoveryInterval(30);
+
 // HTTP response write callback for libcurl
 static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
     size_t realsize = size * nmemb;
@@ -92,24 +95,12 @@ void DecentriLicenseClient::start() {
         perform_smart_degradation();
     });
 
-    // Start periodic tasks
-    periodic_thread_ = std::thread([this]() {
-        while (running_) {
-            // Broadcast discovery message (every 30 seconds)
-            static auto last_broadcast = std::chrono::steady_clock::now();
-            auto now = std::chrono::steady_clock::now();
-            if (std::chrono::duration_cast<std::chrono::seconds>(now - last_broadcast).count() >= 30) {
-                broadcast_discovery_message();
-                last_broadcast = now;
-            }
-
-            // Check token expiration
-            token_manager_->check_expiration();
-
-            // Perform other periodic tasks
-            std::this_thread::sleep_for(std::chrono::seconds(10)); // Check every 10 seconds
-        }
-    });
+    // Periodic tasks run on the shared timer thread; token expiry is
+    // handled by the token manager's own timer
+    TimerScheduler& scheduler = TimerScheduler::instance();
+    discovery_timer_ = scheduler.schedule_after(kDiscoveryInterval, [this]() {
+        broadcast_discovery_message();
+    }, kDiscoveryInterval);
 }
 
 void DecentriLicenseClient::initialize_network_components() {
@@ -148,8 +139,8 @@ void DecentriLicenseClient::broadcast_discovery_message() {
     if (!network_manager_) return;
 
     // Get current token's ID for discovery
-    auto current_token = token_manager_->get_current_token();
-    if (!current_token.has_value()) return;
+    auto current_token = token_manager_->get_current_token_snapshot();
+    if (!current_token) return;
 
     DiscoveryMessage discovery;
     discovery.device_id = get_device_id(); // Use actual device ID
@@ -239,8 +230,8 @@ void DecentriLicenseClient::send_discovery_response(const std::string& to_addres
     response.token_id = ""; // We don't expose our token_id in response for security
 
     // Only respond if we have a token
-    auto current_token = token_manager_->get_current_token();
-    if (current_token.has_value()) {
+    auto current_token = token_manager_->get_current_token_snapshot();
+    if (current_token) {
         response.token_id = current_token->token_id;
     }
 
@@ -269,12 +260,10 @@ void DecentriLicenseClient::send_token_ack(const std::string& to_address, const
 
 void DecentriLicenseClient::handle_token_transfer(const NetworkMessage& msg, const std::string& from_address) {
     try {
-        // Parse token from message payload (assuming it's JSON serialized token)
+        // Parse token from message payload (binary v2 or JSON)
         Token transferred_token;
-        try {
-            transferred_token = Token::from_json(msg.payload);
-        } catch (const std::exception& e) {
-            std::cerr << "DecentriLicense: Failed to parse transferred token: " << e.what() << std::endl;
+        if (!Token::decode(msg.payload, &transferred_token)) {
+            std::cerr << "DecentriLicense: Failed to parse transferred token" << std::endl;
             return;
         }
 
@@ -442,9 +431,8 @@ void DecentriLicenseClient::stop() {
         degradation_thread_.join();
     }
 
-    if (periodic_thread_.joinable()) {
-        periodic_thread_.join();
-    }
+    TimerScheduler& scheduler = TimerScheduler::instance();
+    scheduler.cancel_and_wait(discovery_timer_);
 }
 
 bool DecentriLicenseClient::check_token_conflict(const std::string& token_id) {
@@ -467,8 +455,8 @@ bool DecentriLicenseClient::detect_wan_conflicts(const std::string& token_id) {
         return false;
     }
 
-    auto current_token = token_manager_->get_current_token();
-    if (!current_token.has_value()) {
+    auto current_token = token_manager_->get_current_token_snapshot();
+    if (!current_token) {
         return false;
     }
 
@@ -552,8 +540,8 @@ ActivationResult DecentriLicenseClient::activate_license(const std::string& lice
     ActivationResult result;
 
     // Get current token for conflict checking
-    auto current_token = token_manager_->get_current_token();
-    if (!current_token.has_value()) {
+    auto current_token = token_manager_->get_current_token_snapshot();
+    if (!current_token) {
         result.success = false;
         result.message = "No token available for activation";
         return result;
@@ -641,9 +629,9 @@ ActivationResult DecentriLicenseClient::activate_with_token(const Token& token)
 
     if (has_conflict) {
         // If there's a conflict, compare state chains
-        auto current_token = token_manager_->get_current_token();
+        auto current_token = token_manager_->get_current_token_snapshot();
 
-        if (current_token.has_value()) {
+        if (current_token) {
             // Compare state chains using comprehensive logic
             StateChainComparisonResult comparison = compare_state_chains(token, *current_token);
 
@@ -1,5 +1,6 @@
 #include "decentrilicense/device_key_manager.hpp"
 #include "decentrilicense/crypto_utils.hpp"
+#include "decentrilicense/key_pair_pool.hpp"
 #include <openssl/evp.h>
 #include <openssl/pem.h>
 #include <openssl/sha.h>
@@ -104,7 +105,7 @@ bool DeviceKeyManager::verify_usage_chain(const std::string& token_json) const {
 }
 
 CryptoUtils::KeyPair DeviceKeyManager::generate_device_keypair() {
-    return CryptoUtils::generate_ed25519_keypair();
+    return KeyPairPool::shared().acquire(SigningAlgorithm::Ed25519);
 }
 
 bool DeviceKeyManager::store_device_private_key_securely(const std::string& private_key_pem) {
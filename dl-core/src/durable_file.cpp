@@ -0,0 +1,144 @@
+#include "durable_file.hpp"
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace decentrilicense {
+
+#ifdef _WIN32
+
+bool DurableFile::open(const std::string& path, Mode mode, bool* created) {
+    close();
+    // GENERIC_WRITE rather than FILE_APPEND_DATA: FlushFileBuffers needs it
+    const DWORD disposition = mode == Mode::Append ? OPEN_ALWAYS : CREATE_ALWAYS;
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    if (created) {
+        *created = GetLastError() != ERROR_ALREADY_EXISTS;
+    }
+    handle_ = handle;
+    append_ = mode == Mode::Append;
+    return true;
+}
+
+bool DurableFile::write(const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        const DWORD chunk = size > 0x40000000u ? 0x40000000u : static_cast<DWORD>(size);
+        DWORD written = 0;
+        // An offset of all ones writes at the end of the file, like O_APPEND
+        OVERLAPPED at_end = {};
+        at_end.Offset = 0xFFFFFFFF;
+        at_end.OffsetHigh = 0xFFFFFFFF;
+        if (!WriteFile(static_cast<HANDLE>(handle_), p, chunk, &written, append_ ? &at_end : nullptr) ||
+            written == 0) {
+            return false;
+        }
+        p += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool DurableFile::sync() {
+    return FlushFileBuffers(static_cast<HANDLE>(handle_)) != 0;
+}
+
+void DurableFile::close() {
+    if (handle_) {
+        CloseHandle(static_cast<HANDLE>(handle_));
+        handle_ = nullptr;
+    }
+}
+
+bool DurableFile::is_open() const {
+    return handle_ != nullptr;
+}
+
+bool sync_directory(const std::string&) {
+    return true;
+}
+
+#else
+
+bool DurableFile::open(const std::string& path, Mode mode, bool* created) {
+    close();
+    int flags = O_WRONLY | O_CLOEXEC | (mode == Mode::Append ? O_APPEND : O_TRUNC);
+    int fd = ::open(path.c_str(), flags);
+    bool is_new = false;
+    if (fd < 0 && errno == ENOENT) {
+        fd = ::open(path.c_str(), flags | O_CREAT, 0644);
+        is_new = fd >= 0;
+    }
+    if (fd < 0) {
+        return false;
+    }
+    if (created) {
+        *created = is_new;
+    }
+    fd_ = fd;
+    return true;
+}
+
+bool DurableFile::write(const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t written = ::write(fd_, p, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool DurableFile::sync() {
+#if defined(__APPLE__)
+    if (fcntl(fd_, F_FULLFSYNC) == 0) {
+        return true;
+    }
+    return fsync(fd_) == 0;     // Not supported by every file system
+#elif defined(__linux__)
+    return fdatasync(fd_) == 0;
+#else
+    return fsync(fd_) == 0;
+#endif
+}
+
+void DurableFile::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool DurableFile::is_open() const {
+    return fd_ >= 0;
+}
+
+bool sync_directory(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    const bool synced = fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+#endif
+
+} // namespace decentrilicense
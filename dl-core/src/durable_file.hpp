@@ -0,0 +1,76 @@
+#ifndef DECENTRILICENSE_DURABLE_FILE_HPP
+#define DECENTRILICENSE_DURABLE_FILE_HPP
+
+// Internal header: unbuffered file output with explicit flushes to stable
+// storage, for the chain log and the files StateChainStorage writes next to
+// it. Not installed.
+
+#include <cstddef>
+#include <string>
+
+namespace decentrilicense {
+
+/**
+ * DurableFile - Write-only file handle that can be synced
+ *
+ * Writes go straight to the OS (no user-space buffer). sync() waits until
+ * the written data, and the metadata needed to read it back, reach stable
+ * storage: fdatasync on Linux, F_FULLFSYNC on macOS (plain fsync does not
+ * flush the drive cache there), fsync elsewhere, FlushFileBuffers on
+ * Windows.
+ */
+class DurableFile {
+public:
+    enum class Mode {
+        Append,     // Create if missing, write at the end
+        Truncate    // Create or empty
+    };
+
+    DurableFile() = default;
+    ~DurableFile() { close(); }
+
+    // Non-copyable
+    DurableFile(const DurableFile&) = delete;
+    DurableFile& operator=(const DurableFile&) = delete;
+
+    /**
+     * Open a file, closing any file already open
+     * @param created Set to whether the file did not exist before, if not null
+     * @return false on failure
+     */
+    bool open(const std::string& path, Mode mode, bool* created = nullptr);
+
+    /**
+     * Write all of a buffer, retrying short writes
+     */
+    bool write(const void* data, size_t size);
+
+    /**
+     * Flush written data to stable storage
+     * Safe to call from one thread while another writes.
+     */
+    bool sync();
+
+    void close();
+
+    bool is_open() const;
+
+private:
+#ifdef _WIN32
+    void* handle_ = nullptr;
+    bool append_ = false;
+#else
+    int fd_ = -1;
+#endif
+};
+
+/**
+ * Flush a directory's entries to stable storage, so that files created or
+ * renamed in it survive a power loss. Always succeeds on Windows, where
+ * NTFS journals renames.
+ */
+bool sync_directory(const std::string& path);
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_DURABLE_FILE_HPP
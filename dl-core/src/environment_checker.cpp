@@ -1,7 +1,6 @@
 #include "decentrilicense/environment_checker.hpp"
+#include "decentrilicense/hasher.hpp"
 #include <sstream>
-#include <iomanip>
-#include <openssl/sha.h>
 #include <unistd.h>
 #include <limits.h>
 
@@ -38,20 +37,7 @@ std::string EnvironmentChecker::generate_environment_hash() {
     }
     
     // Create SHA256 hash
-    std::string data = oss.str();
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256_CTX sha256;
-    SHA256_Init(&sha256);
-    SHA256_Update(&sha256, data.c_str(), data.length());
-    SHA256_Final(hash, &sha256);
-    
-    // Convert to hex string
-    std::stringstream hexStream;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        hexStream << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
-    }
-    
-    return hexStream.str();
+    return Hasher::to_hex(Hasher::digest(Hasher::Algorithm::SHA256, oss.str()));
 }
 
 bool EnvironmentChecker::verify_environment_hash(const std::string& stored_hash) {
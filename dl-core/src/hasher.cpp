@@ -0,0 +1,125 @@
+#include "decentrilicense/hasher.hpp"
+#include "crypto_context.hpp"
+#include <stdexcept>
+#include <utility>
+
+namespace decentrilicense {
+
+namespace {
+
+const EVP_MD* md_for(Hasher::Algorithm algorithm) {
+    // Always the default context: thread-local hashers outlive any private
+    // CryptoContext and must not keep its algorithms alive
+    const AlgorithmSet& algorithms = AlgorithmSet::global();
+    return algorithm == Hasher::Algorithm::SM3 ? algorithms.sm3() : algorithms.sha256();
+}
+
+// Two characters per byte value
+struct HexTable {
+    char pairs[256][2];
+
+    constexpr HexTable() : pairs() {
+        const char digits[] = "0123456789abcdef";
+        for (int i = 0; i < 256; ++i) {
+            pairs[i][0] = digits[i >> 4];
+            pairs[i][1] = digits[i & 0x0f];
+        }
+    }
+};
+
+constexpr HexTable kHexTable;
+
+} // namespace
+
+Hasher::Hasher(Algorithm algorithm)
+    : ctx_(EVP_MD_CTX_new()), algorithm_(algorithm) {
+    if (!ctx_) {
+        throw std::runtime_error("Failed to create digest context");
+    }
+    reset();
+}
+
+Hasher::~Hasher() {
+    EVP_MD_CTX_free(ctx_);
+}
+
+Hasher::Hasher(Hasher&& other) noexcept
+    : ctx_(std::exchange(other.ctx_, nullptr)), algorithm_(other.algorithm_) {
+}
+
+Hasher& Hasher::operator=(Hasher&& other) noexcept {
+    if (this != &other) {
+        EVP_MD_CTX_free(ctx_);
+        ctx_ = std::exchange(other.ctx_, nullptr);
+        algorithm_ = other.algorithm_;
+    }
+    return *this;
+}
+
+Hasher& Hasher::update(const void* data, size_t size) {
+    if (size > 0 && EVP_DigestUpdate(ctx_, data, size) != 1) {
+        throw std::runtime_error("Failed to update digest");
+    }
+    return *this;
+}
+
+Hasher::Digest Hasher::finalize() {
+    Digest out{};
+    unsigned int len = 0;
+    if (EVP_DigestFinal_ex(ctx_, out.data(), &len) != 1 || len != kDigestSize) {
+        throw std::runtime_error("Failed to finalize digest");
+    }
+    reset();
+    return out;
+}
+
+void Hasher::reset() {
+    if (EVP_DigestInit_ex(ctx_, md_for(algorithm_), nullptr) != 1) {
+        throw std::runtime_error("Failed to initialize digest");
+    }
+}
+
+Hasher& Hasher::thread_local_instance(Algorithm algorithm) {
+    thread_local Hasher sha256(Algorithm::SHA256);
+    thread_local Hasher sm3(Algorithm::SM3);
+    return algorithm == Algorithm::SM3 ? sm3 : sha256;
+}
+
+Hasher::Digest Hasher::digest(Algorithm algorithm, std::string_view data) {
+    Hasher& hasher = thread_local_instance(algorithm);
+    try {
+        hasher.update(data);
+    } catch (...) {
+        hasher.reset();
+        throw;
+    }
+    return hasher.finalize();
+}
+
+Hasher::Digest Hasher::digest(Algorithm algorithm, std::initializer_list<std::string_view> fragments) {
+    Hasher& hasher = thread_local_instance(algorithm);
+    try {
+        for (std::string_view fragment : fragments) {
+            hasher.update(fragment);
+        }
+    } catch (...) {
+        hasher.reset();
+        throw;
+    }
+    return hasher.finalize();
+}
+
+void Hasher::to_hex(const uint8_t* data, size_t size, char* out) {
+    for (size_t i = 0; i < size; ++i) {
+        out[2 * i] = kHexTable.pairs[data[i]][0];
+        out[2 * i + 1] = kHexTable.pairs[data[i]][1];
+    }
+}
+
+std::string Hasher::to_hex(const Digest& digest) {
+    std::string out(2 * kDigestSize, '\0');
+    to_hex(digest.data(), digest.size(), &out[0]);
+    return out;
+}
+
+} // namespace decentrilicense
@@ -0,0 +1,125 @@
+#ifndef DECENTRILICENSE_JSON_WRITER_HPP
+#define DECENTRILICENSE_JSON_WRITER_HPP
+
+// Internal header: output targets for the JSON serializers. A serializer is
+// written once as a template over the writer and run with JsonSizeCounter to
+// get the exact size, then with JsonBufferWriter or JsonHashWriter to
+// produce the bytes. Not installed.
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "decentrilicense/hasher.hpp"
+#include "decentrilicense/token_json.hpp"
+
+namespace decentrilicense {
+
+constexpr size_t kMaxU64Digits = 20;
+
+inline size_t decimal_digits(uint64_t value) {
+    size_t digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+/**
+ * JsonSizeCounter - Counts the bytes a serializer would write
+ */
+class JsonSizeCounter {
+public:
+    void literal(std::string_view s) { size_ += s.size(); }
+    void escaped(std::string_view s) { size_ += json_escaped_size(s); }
+    void number(uint64_t value) { size_ += decimal_digits(value); }
+
+    size_t size() const { return size_; }
+
+private:
+    size_t size_ = 0;
+};
+
+/**
+ * JsonBufferWriter - Writes into a buffer sized with JsonSizeCounter
+ */
+class JsonBufferWriter {
+public:
+    explicit JsonBufferWriter(char* out) : begin_(out), out_(out) {}
+
+    void literal(std::string_view s) {
+        std::memcpy(out_, s.data(), s.size());
+        out_ += s.size();
+    }
+    void escaped(std::string_view s) { out_ = json_escape_to(s, out_); }
+    void number(uint64_t value) { out_ = std::to_chars(out_, out_ + kMaxU64Digits, value).ptr; }
+
+    size_t size() const { return static_cast<size_t>(out_ - begin_); }
+
+private:
+    char* begin_;
+    char* out_;
+};
+
+/**
+ * JsonHashWriter - Feeds the output into a Hasher through a small stack
+ * buffer instead of building the whole document
+ *
+ * flush() must be called before finalizing the hasher.
+ */
+class JsonHashWriter {
+public:
+    explicit JsonHashWriter(Hasher& hasher) : hasher_(hasher) {}
+
+    void literal(std::string_view s) {
+        if (s.size() > kBufferSize - used_) {
+            flush();
+            if (s.size() > kBufferSize) {
+                hasher_.update(s);
+                return;
+            }
+        }
+        std::memcpy(buffer_ + used_, s.data(), s.size());
+        used_ += s.size();
+    }
+
+    void escaped(std::string_view s) {
+        // Escaping at most doubles a chunk, so each chunk fits the buffer
+        while (!s.empty()) {
+            const std::string_view chunk = s.substr(0, kBufferSize / 2);
+            if (2 * chunk.size() > kBufferSize - used_) {
+                flush();
+            }
+            used_ = static_cast<size_t>(json_escape_to(chunk, buffer_ + used_) - buffer_);
+            s.remove_prefix(chunk.size());
+        }
+    }
+
+    void number(uint64_t value) {
+        if (kMaxU64Digits > kBufferSize - used_) {
+            flush();
+        }
+        char* end = std::to_chars(buffer_ + used_, buffer_ + kBufferSize, value).ptr;
+        used_ = static_cast<size_t>(end - buffer_);
+    }
+
+    void flush() {
+        if (used_ > 0) {
+            hasher_.update(buffer_, used_);
+            used_ = 0;
+        }
+    }
+
+private:
+    static constexpr size_t kBufferSize = 4096;
+
+    Hasher& hasher_;
+    char buffer_[kBufferSize];
+    size_t used_ = 0;
+};
+
+} // namespace decentrilicense
+
+#endif // DECENTRILICENSE_JSON_WRITER_HPP
@@ -0,0 +1,262 @@
+#include "decentrilicense/key_cache.hpp"
+#include "decentrilicense/hasher.hpp"
+#include "crypto_context.hpp"
+#include <openssl/pem.h>
+#include <openssl/bio.h>
+#include <openssl/x509.h>
+#include <cstring>
+
+namespace decentrilicense {
+
+// KeyHandle implementation
+KeyHandle::KeyHandle(EVP_PKEY* pkey)
+    : pkey_(pkey, EVP_PKEY_free) {
+}
+
+int KeyHandle::type() const {
+    if (!pkey_) {
+        return EVP_PKEY_NONE;
+    }
+    return EVP_PKEY_base_id(pkey_.get());
+}
+
+// KeyCache implementation
+KeyCache::KeyCache(size_t capacity)
+    : capacity_(capacity) {
+}
+
+KeyCache& KeyCache::instance() {
+    static KeyCache cache;
+    return cache;
+}
+
+KeyHandle KeyCache::get_public_key(const std::string& public_key_pem) {
+    return lookup_or_parse(public_key_pem, KeyKind::Public, KeyFormat::PEM);
+}
+
+KeyHandle KeyCache::get_private_key(const std::string& private_key_pem) {
+    return lookup_or_parse(private_key_pem, KeyKind::Private, KeyFormat::PEM);
+}
+
+KeyHandle KeyCache::get_public_key(const uint8_t* data, size_t size, KeyFormat format) {
+    if (!data) {
+        return KeyHandle();
+    }
+    return lookup_or_parse(std::string_view(reinterpret_cast<const char*>(data), size),
+                           KeyKind::Public, format);
+}
+
+KeyHandle KeyCache::get_private_key(const uint8_t* data, size_t size, KeyFormat format) {
+    if (!data) {
+        return KeyHandle();
+    }
+    return lookup_or_parse(std::string_view(reinterpret_cast<const char*>(data), size),
+                           KeyKind::Private, format);
+}
+
+std::string KeyCache::make_cache_key(std::string_view encoded, KeyKind kind, KeyFormat format) {
+    // [1-byte kind][1-byte format][8-byte library context id][32-byte SHA-256 of the encoding]
+    // Keys parsed in different library contexts must not be mixed
+    const CryptoContext* context = current_crypto_context();
+    const uint64_t context_id = context ? context->id() : 0;
+    const Hasher::Digest digest = Hasher::digest(Hasher::Algorithm::SHA256, encoded);
+    std::string key(1, static_cast<char>(kind));
+    key.push_back(static_cast<char>(format));
+    key.append(reinterpret_cast<const char*>(&context_id), sizeof(context_id));
+    key.append(reinterpret_cast<const char*>(digest.data()), digest.size());
+    return key;
+}
+
+static EVP_PKEY* parse_pem(std::string_view pem, bool is_public) {
+    BIO* bio = BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size()));
+    if (!bio) {
+        return nullptr;
+    }
+
+    EVP_PKEY* pkey = nullptr;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    OSSL_LIB_CTX* libctx = current_libctx();
+    if (is_public) {
+        pkey = PEM_read_bio_PUBKEY_ex(bio, nullptr, nullptr, nullptr, libctx, nullptr);
+    } else {
+        pkey = PEM_read_bio_PrivateKey_ex(bio, nullptr, nullptr, nullptr, libctx, nullptr);
+    }
+#else
+    if (is_public) {
+        pkey = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
+    } else {
+        pkey = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
+    }
+#endif
+    BIO_free(bio);
+    return pkey;
+}
+
+static EVP_PKEY* parse_der(std::string_view der, bool is_public) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(der.data());
+    const long len = static_cast<long>(der.size());
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    OSSL_LIB_CTX* libctx = current_libctx();
+    if (is_public) {
+        return d2i_PUBKEY_ex(nullptr, &p, len, libctx, nullptr);
+    }
+    return d2i_AutoPrivateKey_ex(nullptr, &p, len, libctx, nullptr);
+#else
+    if (is_public) {
+        return d2i_PUBKEY(nullptr, &p, len);
+    }
+    return d2i_AutoPrivateKey(nullptr, &p, len);
+#endif
+}
+
+static EVP_PKEY* parse_raw_ed25519(std::string_view raw, bool is_public) {
+    if (raw.size() != 32) {
+        return nullptr;
+    }
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(raw.data());
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    OSSL_LIB_CTX* libctx = current_libctx();
+    if (is_public) {
+        return EVP_PKEY_new_raw_public_key_ex(libctx, "ED25519", nullptr, p, raw.size());
+    }
+    return EVP_PKEY_new_raw_private_key_ex(libctx, "ED25519", nullptr, p, raw.size());
+#else
+    if (is_public) {
+        return EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, nullptr, p, raw.size());
+    }
+    return EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, nullptr, p, raw.size());
+#endif
+}
+
+KeyHandle KeyCache::parse(std::string_view encoded, KeyKind kind, KeyFormat format) {
+    const bool is_public = kind == KeyKind::Public;
+    EVP_PKEY* pkey = nullptr;
+    switch (format) {
+        case KeyFormat::PEM:
+            pkey = parse_pem(encoded, is_public);
+            break;
+        case KeyFormat::DER:
+            pkey = parse_der(encoded, is_public);
+            break;
+        case KeyFormat::RawEd25519:
+            pkey = parse_raw_ed25519(encoded, is_public);
+            break;
+    }
+
+    if (!pkey) {
+        return KeyHandle();
+    }
+    return KeyHandle(pkey);
+}
+
+KeyHandle KeyCache::lookup_or_parse(std::string_view encoded, KeyKind kind, KeyFormat format) {
+    if (encoded.empty()) {
+        return KeyHandle();
+    }
+
+    const std::string cache_key = make_cache_key(encoded, kind, format);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(cache_key);
+        if (it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            hits_++;
+            return it->second->handle;
+        }
+        misses_++;
+    }
+
+    // Parse outside the lock; decoding is the expensive part
+    KeyHandle handle = parse(encoded, kind, format);
+    if (!handle) {
+        // Parse failures are not cached
+        return handle;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ == 0) {
+        return handle;
+    }
+
+    auto it = index_.find(cache_key);
+    if (it != index_.end()) {
+        // Another thread parsed the same key concurrently, keep the first one
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->handle;
+    }
+
+    lru_.push_front(Entry{cache_key, handle});
+    index_[cache_key] = lru_.begin();
+    trim_locked();
+    return handle;
+}
+
+bool KeyCache::evict(const std::string& pem) {
+    bool removed = false;
+    for (KeyKind kind : {KeyKind::Public, KeyKind::Private}) {
+        const std::string cache_key = make_cache_key(pem, kind, KeyFormat::PEM);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(cache_key);
+        if (it != index_.end()) {
+            lru_.erase(it->second);
+            index_.erase(it);
+            evictions_++;
+            removed = true;
+        }
+    }
+    return removed;
+}
+
+size_t KeyCache::erase_context(uint64_t context_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t removed = 0;
+    for (auto it = lru_.begin(); it != lru_.end();) {
+        // Context id follows the kind and format bytes, see make_cache_key
+        uint64_t id = 0;
+        std::memcpy(&id, it->cache_key.data() + 2, sizeof(id));
+        if (id == context_id) {
+            index_.erase(it->cache_key);
+            it = lru_.erase(it);
+            removed++;
+        } else {
+            ++it;
+        }
+    }
+    evictions_ += removed;
+    return removed;
+}
+
+void KeyCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    evictions_ += lru_.size();
+    lru_.clear();
+    index_.clear();
+}
+
+void KeyCache::set_capacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    trim_locked();
+}
+
+KeyCache::Stats KeyCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s;
+    s.hits = hits_;
+    s.misses = misses_;
+    s.evictions = evictions_;
+    s.size = lru_.size();
+    s.capacity = capacity_;
+    return s;
+}
+
+void KeyCache::trim_locked() {
+    while (lru_.size() > capacity_) {
+        index_.erase(lru_.back().cache_key);
+        lru_.pop_back();
+        evictions_++;
+    }
+}
+
+} // namespace decentrilicense
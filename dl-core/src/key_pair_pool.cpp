@@ -0,0 +1,173 @@
+#include "decentrilicense/key_pair_pool.hpp"
+#include <algorithm>
+
+namespace decentrilicense {
+
+KeyPairPool::KeyPairPool(const Config& config)
+    : rsa_key_size_(config.rsa_key_size) {
+    slots_[index_of(SigningAlgorithm::Ed25519)].target = std::min(config.ed25519, kMaxPooled);
+    slots_[index_of(SigningAlgorithm::RSA)].target = std::min(config.rsa, kMaxPooled);
+    slots_[index_of(SigningAlgorithm::SM2)].target = std::min(config.sm2, kMaxPooled);
+
+    refill_requested_ = true;
+    refill_thread_ = std::thread([this]() { refill_loop(); });
+}
+
+KeyPairPool::~KeyPairPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (refill_thread_.joinable()) {
+        refill_thread_.join();
+    }
+}
+
+KeyPairPool& KeyPairPool::shared() {
+    static KeyPairPool pool;
+    return pool;
+}
+
+size_t KeyPairPool::index_of(SigningAlgorithm algorithm) {
+    switch (algorithm) {
+        case SigningAlgorithm::RSA: return 0;
+        case SigningAlgorithm::Ed25519: return 1;
+        case SigningAlgorithm::SM2: return 2;
+    }
+    return 1;
+}
+
+CryptoUtils::KeyPair KeyPairPool::generate(SigningAlgorithm algorithm) const {
+    switch (algorithm) {
+        case SigningAlgorithm::RSA:
+            return CryptoUtils::generate_rsa_keypair(rsa_key_size_.load());
+        case SigningAlgorithm::SM2:
+            return CryptoUtils::generate_sm2_keypair();
+        case SigningAlgorithm::Ed25519:
+        default:
+            return CryptoUtils::generate_ed25519_keypair();
+    }
+}
+
+CryptoUtils::KeyPair KeyPairPool::acquire(SigningAlgorithm algorithm) {
+    Slot& slot = slots_[index_of(algorithm)];
+    CryptoUtils::KeyPair pair;
+    const bool hit = slot.queue.try_pop(pair);
+    if (slot.target.load(std::memory_order_relaxed) > 0) {
+        request_refill();
+    }
+    if (hit) {
+        hits_++;
+        return pair;
+    }
+
+    misses_++;
+    return generate(algorithm);
+}
+
+void KeyPairPool::set_target(SigningAlgorithm algorithm, size_t count) {
+    Slot& slot = slots_[index_of(algorithm)];
+    slot.target = std::min(count, kMaxPooled);
+
+    // Shrink right away, growing is left to the refill thread
+    CryptoUtils::KeyPair discarded;
+    while (slot.queue.size() > slot.target && slot.queue.try_pop(discarded)) {
+    }
+    request_refill();
+}
+
+void KeyPairPool::set_rsa_key_size(int key_size) {
+    if (rsa_key_size_.exchange(key_size) == key_size) {
+        return;
+    }
+
+    Slot& slot = slots_[index_of(SigningAlgorithm::RSA)];
+    CryptoUtils::KeyPair discarded;
+    while (slot.queue.try_pop(discarded)) {
+    }
+    request_refill();
+}
+
+size_t KeyPairPool::available(SigningAlgorithm algorithm) const {
+    return slots_[index_of(algorithm)].queue.size();
+}
+
+KeyPairPool::Stats KeyPairPool::stats() const {
+    Stats s;
+    s.hits = hits_.load();
+    s.misses = misses_.load();
+    s.generated = generated_.load();
+    return s;
+}
+
+bool KeyPairPool::needs_refill() const {
+    for (const Slot& slot : slots_) {
+        if (slot.queue.size() < slot.target.load(std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void KeyPairPool::request_refill() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refill_requested_ = true;
+    }
+    cv_.notify_one();
+}
+
+void KeyPairPool::refill_loop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || refill_requested_; });
+            if (stopping_) {
+                return;
+            }
+            refill_requested_ = false;
+        }
+
+        // One pair per algorithm per round so a slow RSA refill does not
+        // starve the others; stop checks happen between generations
+        while (needs_refill()) {
+            for (size_t i = 0; i < kAlgorithmCount; ++i) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (stopping_) {
+                        return;
+                    }
+                }
+
+                Slot& slot = slots_[i];
+                if (slot.queue.size() >= slot.target.load(std::memory_order_relaxed)) {
+                    continue;
+                }
+
+                const SigningAlgorithm algorithm = i == 0 ? SigningAlgorithm::RSA
+                                                 : i == 1 ? SigningAlgorithm::Ed25519
+                                                          : SigningAlgorithm::SM2;
+                const int key_size = rsa_key_size_.load();
+                CryptoUtils::KeyPair pair;
+                try {
+                    pair = generate(algorithm);
+                } catch (...) {
+                    // Leave the slot short; acquire() falls back to inline generation
+                    slot.target = 0;
+                    continue;
+                }
+
+                // Drop RSA pairs generated with a key size that was changed meanwhile
+                if (algorithm == SigningAlgorithm::RSA && key_size != rsa_key_size_.load()) {
+                    continue;
+                }
+                if (slot.queue.try_push(std::move(pair))) {
+                    generated_++;
+                }
+            }
+        }
+    }
+}
+
+} // namespace decentrilicense
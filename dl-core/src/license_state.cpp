@@ -0,0 +1,42 @@
+#include "decentrilicense/license_state.hpp"
+#include <algorithm>
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace decentrilicense {
+
+void LicenseState::publish(bool active, uint64_t expire_time) noexcept {
+    const uint64_t fields = (active ? kActiveBit : 0) | std::min(expire_time, kExpireMask);
+    uint64_t word = word_.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        const uint64_t generation = ((word >> kGenerationShift) + 1) & kGenerationMask;
+        next = fields | generation << kGenerationShift;
+    } while (!word_.compare_exchange_weak(word, next, std::memory_order_release,
+                                          std::memory_order_relaxed));
+}
+
+uint64_t LicenseState::coarse_unix_seconds() noexcept {
+#if defined(CLOCK_REALTIME_COARSE)
+    // Linux: served from the vDSO at jiffy resolution
+    timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    return static_cast<uint64_t>(now.tv_sec);
+#elif defined(_WIN32)
+    // Read from the shared user data page
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    const uint64_t ticks = (static_cast<uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+    return (ticks - 116444736000000000ULL) / 10000000ULL;
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+#endif
+}
+
+} // namespace decentrilicense
@@ -0,0 +1,471 @@
+#include "decentrilicense/sha256_multi.hpp"
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define DL_SHA256_X86 1
+#include <immintrin.h>
+#endif
+
+namespace decentrilicense {
+
+namespace {
+
+constexpr size_t kBlockSize = 64;
+
+alignas(64) constexpr uint32_t kRound[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr uint32_t kInitialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+size_t block_count(size_t size) {
+    // Message, 0x80, zero fill, 64-bit length
+    return (size + 8) / kBlockSize + 1;
+}
+
+// Write block `index` of the padded message into out
+void fill_block(std::string_view msg, size_t index, size_t total, uint8_t* out) {
+    const size_t offset = index * kBlockSize;
+    if (offset + kBlockSize <= msg.size()) {
+        std::memcpy(out, msg.data() + offset, kBlockSize);
+        return;
+    }
+
+    const size_t remaining = msg.size() > offset ? msg.size() - offset : 0;
+    if (remaining) {
+        std::memcpy(out, msg.data() + offset, remaining);
+    }
+    std::memset(out + remaining, 0, kBlockSize - remaining);
+    if (msg.size() >= offset && msg.size() - offset < kBlockSize) {
+        out[msg.size() - offset] = 0x80;
+    }
+    if (index + 1 == total) {
+        const uint64_t bits = static_cast<uint64_t>(msg.size()) * 8;
+        for (int i = 0; i < 8; ++i) {
+            out[56 + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+        }
+    }
+}
+
+void store_digest(const uint32_t state[8], Sha256Multi::Digest* out) {
+    for (int i = 0; i < 8; ++i) {
+        (*out)[4 * i] = static_cast<uint8_t>(state[i] >> 24);
+        (*out)[4 * i + 1] = static_cast<uint8_t>(state[i] >> 16);
+        (*out)[4 * i + 2] = static_cast<uint8_t>(state[i] >> 8);
+        (*out)[4 * i + 3] = static_cast<uint8_t>(state[i]);
+    }
+}
+
+// Single-buffer kernels: compress `blocks` consecutive blocks into state
+using SingleKernel = void (*)(uint32_t state[8], const uint8_t* data, size_t blocks);
+
+inline uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+void compress_scalar(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    for (; blocks > 0; --blocks, data += kBlockSize) {
+        uint32_t w[64];
+        for (int t = 0; t < 16; ++t) {
+            w[t] = (static_cast<uint32_t>(data[4 * t]) << 24) |
+                   (static_cast<uint32_t>(data[4 * t + 1]) << 16) |
+                   (static_cast<uint32_t>(data[4 * t + 2]) << 8) |
+                   static_cast<uint32_t>(data[4 * t + 3]);
+        }
+        for (int t = 16; t < 64; ++t) {
+            const uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            const uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; ++t) {
+            const uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) +
+                                ((e & f) ^ (~e & g)) + kRound[t] + w[t];
+            const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) +
+                                ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+// Multi-buffer kernels: one block per lane, state in lane-major order
+// (state[word * lanes + lane]), blocks laid out back to back
+using MultiKernel = void (*)(uint32_t* state, const uint8_t* blocks);
+
+#ifdef DL_SHA256_X86
+
+__attribute__((target("sha,sse4.1")))
+void compress_shani(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // Rearrange into the ABEF/CDGH layout used by sha256rnds2
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; blocks > 0; --blocks, data += kBlockSize) {
+        const __m128i abef = state0;
+        const __m128i cdgh = state1;
+        __m128i w[4];
+
+        for (int i = 0; i < 16; ++i) {
+            if (i < 4) {
+                w[i] = _mm_shuffle_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), byte_swap);
+            } else {
+                // W[t] = s1(W[t-2]) + W[t-7] + s0(W[t-15]) + W[t-16], four at a time
+                __m128i x = _mm_sha256msg1_epu32(w[i & 3], w[(i + 1) & 3]);
+                x = _mm_add_epi32(x, _mm_alignr_epi8(w[(i + 3) & 3], w[(i + 2) & 3], 4));
+                w[i & 3] = _mm_sha256msg2_epu32(x, w[(i + 3) & 3]);
+            }
+            __m128i msg = _mm_add_epi32(
+                w[i & 3], _mm_load_si128(reinterpret_cast<const __m128i*>(kRound + 4 * i)));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        }
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+}
+
+__attribute__((target("avx2")))
+inline __m256i rotr256(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+__attribute__((target("avx2")))
+void compress_avx2(uint32_t* state, const uint8_t* blocks) {
+    constexpr int kLanes = 8;
+    const __m256i byte_swap = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i lane_offsets = _mm256_setr_epi32(0, 64, 128, 192, 256, 320, 384, 448);
+
+    __m256i v[8];
+    for (int i = 0; i < 8; ++i) {
+        v[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(state + i * kLanes));
+    }
+    __m256i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+    // Word t of every lane's block, gathered across the lanes
+    __m256i w[16];
+    for (int t = 0; t < 16; ++t) {
+        w[t] = _mm256_shuffle_epi8(
+            _mm256_i32gather_epi32(reinterpret_cast<const int*>(blocks + 4 * t), lane_offsets, 1),
+            byte_swap);
+    }
+
+    for (int t = 0; t < 64; ++t) {
+        if (t >= 16) {
+            const __m256i w15 = w[(t - 15) & 15];
+            const __m256i w2 = w[(t - 2) & 15];
+            const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr256(w15, 7), rotr256(w15, 18)),
+                                                _mm256_srli_epi32(w15, 3));
+            const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr256(w2, 17), rotr256(w2, 19)),
+                                                _mm256_srli_epi32(w2, 10));
+            w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0),
+                                         _mm256_add_epi32(w[(t - 7) & 15], s1));
+        }
+
+        const __m256i big_s1 = _mm256_xor_si256(_mm256_xor_si256(rotr256(e, 6), rotr256(e, 11)), rotr256(e, 25));
+        const __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        const __m256i t1 = _mm256_add_epi32(
+            _mm256_add_epi32(_mm256_add_epi32(h, big_s1), _mm256_add_epi32(ch, w[t & 15])),
+            _mm256_set1_epi32(static_cast<int>(kRound[t])));
+        const __m256i big_s0 = _mm256_xor_si256(_mm256_xor_si256(rotr256(a, 2), rotr256(a, 13)), rotr256(a, 22));
+        const __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        const __m256i t2 = _mm256_add_epi32(big_s0, maj);
+
+        h = g; g = f; f = e; e = _mm256_add_epi32(d, t1);
+        d = c; c = b; b = a; a = _mm256_add_epi32(t1, t2);
+    }
+
+    const __m256i out[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; ++i) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(state + i * kLanes), _mm256_add_epi32(v[i], out[i]));
+    }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void compress_avx512(uint32_t* state, const uint8_t* blocks) {
+    constexpr int kLanes = 16;
+    const __m512i byte_swap = _mm512_broadcast_i32x4(
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    const __m512i lane_offsets = _mm512_setr_epi32(
+        0, 64, 128, 192, 256, 320, 384, 448, 512, 576, 640, 704, 768, 832, 896, 960);
+
+    __m512i v[8];
+    for (int i = 0; i < 8; ++i) {
+        v[i] = _mm512_load_si512(state + i * kLanes);
+    }
+    __m512i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+    __m512i w[16];
+    for (int t = 0; t < 16; ++t) {
+        w[t] = _mm512_shuffle_epi8(_mm512_i32gather_epi32(lane_offsets, blocks + 4 * t, 1), byte_swap);
+    }
+
+    for (int t = 0; t < 64; ++t) {
+        if (t >= 16) {
+            const __m512i w15 = w[(t - 15) & 15];
+            const __m512i w2 = w[(t - 2) & 15];
+            // 0x96 = a ^ b ^ c
+            const __m512i s0 = _mm512_ternarylogic_epi32(
+                _mm512_ror_epi32(w15, 7), _mm512_ror_epi32(w15, 18), _mm512_srli_epi32(w15, 3), 0x96);
+            const __m512i s1 = _mm512_ternarylogic_epi32(
+                _mm512_ror_epi32(w2, 17), _mm512_ror_epi32(w2, 19), _mm512_srli_epi32(w2, 10), 0x96);
+            w[t & 15] = _mm512_add_epi32(_mm512_add_epi32(w[t & 15], s0),
+                                         _mm512_add_epi32(w[(t - 7) & 15], s1));
+        }
+
+        const __m512i big_s1 = _mm512_ternarylogic_epi32(
+            _mm512_ror_epi32(e, 6), _mm512_ror_epi32(e, 11), _mm512_ror_epi32(e, 25), 0x96);
+        // 0xCA = e ? f : g
+        const __m512i ch = _mm512_ternarylogic_epi32(e, f, g, 0xCA);
+        const __m512i t1 = _mm512_add_epi32(
+            _mm512_add_epi32(_mm512_add_epi32(h, big_s1), _mm512_add_epi32(ch, w[t & 15])),
+            _mm512_set1_epi32(static_cast<int>(kRound[t])));
+        const __m512i big_s0 = _mm512_ternarylogic_epi32(
+            _mm512_ror_epi32(a, 2), _mm512_ror_epi32(a, 13), _mm512_ror_epi32(a, 22), 0x96);
+        // 0xE8 = majority(a, b, c)
+        const __m512i maj = _mm512_ternarylogic_epi32(a, b, c, 0xE8);
+        const __m512i t2 = _mm512_add_epi32(big_s0, maj);
+
+        h = g; g = f; f = e; e = _mm512_add_epi32(d, t1);
+        d = c; c = b; b = a; a = _mm512_add_epi32(t1, t2);
+    }
+
+    const __m512i out[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; ++i) {
+        _mm512_store_si512(state + i * kLanes, _mm512_add_epi32(v[i], out[i]));
+    }
+}
+
+#endif // DL_SHA256_X86
+
+void hash_single(std::string_view msg, Sha256Multi::Digest* out, SingleKernel compress) {
+    uint32_t state[8];
+    std::memcpy(state, kInitialState, sizeof(state));
+
+    const size_t total = block_count(msg.size());
+    const size_t full = msg.size() / kBlockSize;
+    compress(state, reinterpret_cast<const uint8_t*>(msg.data()), full);
+
+    uint8_t block[kBlockSize];
+    for (size_t i = full; i < total; ++i) {
+        fill_block(msg, i, total, block);
+        compress(state, block, 1);
+    }
+    store_digest(state, out);
+}
+
+template <size_t Lanes>
+void hash_lanes(const std::string_view* messages, size_t count, Sha256Multi::Digest* out,
+                MultiKernel compress, SingleKernel finish) {
+    struct Lane {
+        size_t message;
+        size_t block;
+        size_t total;
+        bool active;
+    };
+
+    alignas(64) uint32_t state[8 * Lanes];
+    alignas(64) uint8_t blocks[Lanes * kBlockSize];
+    Lane lanes[Lanes];
+    size_t next = 0;
+    size_t active = 0;
+
+    auto assign = [&](size_t lane) {
+        if (next < count) {
+            lanes[lane] = Lane{next, 0, block_count(messages[next].size()), true};
+            for (int i = 0; i < 8; ++i) {
+                state[i * Lanes + lane] = kInitialState[i];
+            }
+            ++next;
+            ++active;
+        } else {
+            lanes[lane].active = false;
+        }
+    };
+
+    for (size_t lane = 0; lane < Lanes; ++lane) {
+        assign(lane);
+    }
+    std::memset(blocks, 0, sizeof(blocks));
+
+    // Keep the vector kernel busy while at least a quarter of the lanes have
+    // work; below that the single-buffer kernel is faster
+    while (active > 0 && (next < count || active * 4 > Lanes)) {
+        for (size_t lane = 0; lane < Lanes; ++lane) {
+            if (lanes[lane].active) {
+                const Lane& l = lanes[lane];
+                fill_block(messages[l.message], l.block, l.total, blocks + lane * kBlockSize);
+            }
+        }
+
+        compress(state, blocks);
+
+        for (size_t lane = 0; lane < Lanes; ++lane) {
+            Lane& l = lanes[lane];
+            if (l.active && ++l.block == l.total) {
+                uint32_t lane_state[8];
+                for (int i = 0; i < 8; ++i) {
+                    lane_state[i] = state[i * Lanes + lane];
+                }
+                store_digest(lane_state, &out[l.message]);
+                --active;
+                assign(lane);
+            }
+        }
+    }
+
+    // Finish the stragglers one at a time
+    uint8_t block[kBlockSize];
+    for (size_t lane = 0; lane < Lanes; ++lane) {
+        Lane& l = lanes[lane];
+        if (!l.active) {
+            continue;
+        }
+        uint32_t lane_state[8];
+        for (int i = 0; i < 8; ++i) {
+            lane_state[i] = state[i * Lanes + lane];
+        }
+        for (; l.block < l.total; ++l.block) {
+            fill_block(messages[l.message], l.block, l.total, block);
+            finish(lane_state, block, 1);
+        }
+        store_digest(lane_state, &out[l.message]);
+    }
+}
+
+struct Kernels {
+    Sha256Multi::Kernel batch;      // Kernel used for Auto
+    SingleKernel single;            // Stragglers of the multi-buffer kernels
+    const char* name;
+};
+
+bool cpu_supports(Sha256Multi::Kernel kernel) {
+    switch (kernel) {
+        case Sha256Multi::Kernel::Auto:
+        case Sha256Multi::Kernel::Scalar:
+            return true;
+#ifdef DL_SHA256_X86
+        case Sha256Multi::Kernel::ShaNi:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+        case Sha256Multi::Kernel::Avx2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+        case Sha256Multi::Kernel::Avx512:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#else
+        default:
+            return false;
+#endif
+    }
+    return false;
+}
+
+Kernels select_kernels() {
+    Kernels k{Sha256Multi::Kernel::Scalar, compress_scalar, "scalar"};
+#ifdef DL_SHA256_X86
+    const bool sha = cpu_supports(Sha256Multi::Kernel::ShaNi);
+    if (sha) {
+        k.batch = Sha256Multi::Kernel::ShaNi;
+        k.single = compress_shani;
+        k.name = "sha-ni";
+    }
+    // 16 lanes clearly beat SHA-NI; 8 lanes only beat the scalar code
+    if (cpu_supports(Sha256Multi::Kernel::Avx512)) {
+        k.batch = Sha256Multi::Kernel::Avx512;
+        k.name = sha ? "avx512+sha-ni" : "avx512";
+    } else if (!sha && cpu_supports(Sha256Multi::Kernel::Avx2)) {
+        k.batch = Sha256Multi::Kernel::Avx2;
+        k.name = "avx2";
+    }
+#endif
+    return k;
+}
+
+const Kernels& kernels() {
+    static const Kernels selected = select_kernels();
+    return selected;
+}
+
+} // namespace
+
+void Sha256Multi::digest(const std::string_view* messages, size_t count, Digest* out,
+                         Kernel kernel) {
+    if (!messages || !out || count == 0) {
+        return;
+    }
+
+    const Kernels& selected = kernels();
+    if (kernel == Kernel::Auto || !cpu_supports(kernel)) {
+        kernel = selected.batch;
+    }
+
+    switch (kernel) {
+#ifdef DL_SHA256_X86
+        case Kernel::Avx512:
+            hash_lanes<16>(messages, count, out, compress_avx512, selected.single);
+            return;
+        case Kernel::Avx2:
+            hash_lanes<8>(messages, count, out, compress_avx2, selected.single);
+            return;
+        case Kernel::ShaNi:
+            for (size_t i = 0; i < count; ++i) {
+                hash_single(messages[i], &out[i], compress_shani);
+            }
+            return;
+#endif
+        default:
+            for (size_t i = 0; i < count; ++i) {
+                hash_single(messages[i], &out[i], compress_scalar);
+            }
+            return;
+    }
+}
+
+std::vector<Sha256Multi::Digest> Sha256Multi::digest(const std::vector<std::string>& messages) {
+    std::vector<std::string_view> views(messages.begin(), messages.end());
+    std::vector<Digest> digests(messages.size());
+    digest(views.data(), views.size(), digests.data());
+    return digests;
+}
+
+bool Sha256Multi::supported(Kernel kernel) {
+    return cpu_supports(kernel);
+}
+
+const char* Sha256Multi::implementation() {
+    return kernels().name;
+}
+
+} // namespace decentrilicense
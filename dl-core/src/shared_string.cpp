@@ -0,0 +1,91 @@
+#include "decentrilicense/shared_string.hpp"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace decentrilicense {
+
+namespace {
+
+constexpr size_t kShardCount = 16;
+
+struct InternEntry {
+    std::weak_ptr<const std::string> value;
+    const std::string* buffer;              // Identifies the owner of the key
+};
+
+// Keys point into the interned buffers themselves; an entry is erased
+// before its buffer is freed
+struct InternShard {
+    std::mutex mutex;
+    std::unordered_map<std::string_view, InternEntry> entries;
+};
+
+std::atomic<size_t> g_interned_count{0};
+
+InternShard& shard_for(size_t hash) {
+    // Never destroyed: buffers released during static destruction still
+    // unregister themselves
+    static InternShard* shards = new InternShard[kShardCount];
+    return shards[hash % kShardCount];
+}
+
+struct ReleaseBuffer {
+    InternShard* shard;
+
+    void operator()(const std::string* buffer) const {
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            auto it = shard->entries.find(*buffer);
+            // Once expired, the entry may already have been replaced by a
+            // new buffer with the same content
+            if (it != shard->entries.end() && it->second.buffer == buffer) {
+                shard->entries.erase(it);
+            }
+        }
+        g_interned_count.fetch_sub(1, std::memory_order_relaxed);
+        delete buffer;
+    }
+};
+
+std::shared_ptr<const std::string> intern(std::string_view value, std::string* owned) {
+    InternShard& shard = shard_for(std::hash<std::string_view>{}(value));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.entries.find(value);
+    if (it != shard.entries.end()) {
+        if (std::shared_ptr<const std::string> existing = it->second.value.lock()) {
+            return existing;
+        }
+        // Last reference is being released right now; its deleter will
+        // find the replacement below and leave it alone
+        shard.entries.erase(it);
+    }
+
+    const std::string* buffer = owned ? new std::string(std::move(*owned)) : new std::string(value);
+    std::shared_ptr<const std::string> interned(buffer, ReleaseBuffer{&shard});
+    shard.entries.emplace(std::string_view(*buffer), InternEntry{interned, buffer});
+    g_interned_count.fetch_add(1, std::memory_order_relaxed);
+    return interned;
+}
+
+} // namespace
+
+SharedString::SharedString(std::string_view value) {
+    if (!value.empty()) {
+        value_ = intern(value, nullptr);
+    }
+}
+
+SharedString::SharedString(std::string&& value) {
+    if (!value.empty()) {
+        value_ = intern(value, &value);
+    }
+}
+
+size_t SharedString::interned_count() {
+    return g_interned_count.load(std::memory_order_relaxed);
+}
+
+} // namespace decentrilicense
@@ -0,0 +1,141 @@
+#include "decentrilicense/signer.hpp"
+#include "crypto_context.hpp"
+#include <stdexcept>
+
+namespace decentrilicense {
+
+namespace {
+
+// Library-context aware init, see new_keygen_ctx in crypto_utils.cpp
+int digest_sign_init(EVP_MD_CTX* ctx, const EVP_MD* md, EVP_PKEY* pkey) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    if (OSSL_LIB_CTX* libctx = current_libctx()) {
+        return EVP_DigestSignInit_ex(ctx, nullptr, md ? EVP_MD_get0_name(md) : nullptr,
+                                     libctx, nullptr, pkey, nullptr);
+    }
+#endif
+    return EVP_DigestSignInit(ctx, nullptr, md, nullptr, pkey);
+}
+
+int digest_verify_init(EVP_MD_CTX* ctx, const EVP_MD* md, EVP_PKEY* pkey) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    if (OSSL_LIB_CTX* libctx = current_libctx()) {
+        return EVP_DigestVerifyInit_ex(ctx, nullptr, md ? EVP_MD_get0_name(md) : nullptr,
+                                       libctx, nullptr, pkey, nullptr);
+    }
+#endif
+    return EVP_DigestVerifyInit(ctx, nullptr, md, nullptr, pkey);
+}
+
+// Ed25519 signs the message itself and is one-shot only
+template <SigningAlgorithm Algorithm>
+constexpr bool kOneShot = Algorithm == SigningAlgorithm::Ed25519;
+
+template <SigningAlgorithm Algorithm>
+const EVP_MD* digest_for() {
+    if constexpr (Algorithm == SigningAlgorithm::RSA) {
+        return current_algorithms().sha256();
+    } else if constexpr (Algorithm == SigningAlgorithm::SM2) {
+        // The SM2 distinguishing ID is left at the provider default
+        return current_algorithms().sm3();
+    } else {
+        return nullptr;
+    }
+}
+
+} // namespace
+
+template <SigningAlgorithm Algorithm>
+RawSignature Signer<Algorithm>::sign(const KeyHandle& private_key, const uint8_t* data, size_t size) {
+    if (!private_key) {
+        throw std::runtime_error("Failed to read private key");
+    }
+    if constexpr (Algorithm == SigningAlgorithm::Ed25519) {
+        if (private_key.type() != EVP_PKEY_ED25519) {
+            throw std::runtime_error("Not an Ed25519 key");
+        }
+    }
+
+    MdCtxPool::Lease ctx = MdCtxPool::acquire();
+    if (!ctx) {
+        throw std::runtime_error("Failed to create EVP_MD_CTX");
+    }
+    if (digest_sign_init(ctx.get(), digest_for<Algorithm>(), private_key.get()) != 1) {
+        throw std::runtime_error("Failed to initialize signing");
+    }
+
+    RawSignature signature;
+    size_t sig_len = RawSignature::kMaxSize;
+    if constexpr (kOneShot<Algorithm>) {
+        if (EVP_DigestSign(ctx.get(), signature.data(), &sig_len, data, size) <= 0) {
+            throw std::runtime_error("Failed to generate Ed25519 signature");
+        }
+    } else {
+        // Make sure the final signature fits before writing it
+        size_t max_len = 0;
+        if (EVP_DigestSignUpdate(ctx.get(), data, size) != 1 ||
+            EVP_DigestSignFinal(ctx.get(), nullptr, &max_len) != 1) {
+            throw std::runtime_error("Failed to update signature");
+        }
+        if (max_len > RawSignature::kMaxSize) {
+            throw std::runtime_error("Signature too large");
+        }
+        if (EVP_DigestSignFinal(ctx.get(), signature.data(), &sig_len) != 1) {
+            throw std::runtime_error("Failed to generate signature");
+        }
+    }
+    signature.resize(sig_len);
+    return signature;
+}
+
+template <SigningAlgorithm Algorithm>
+bool Verifier<Algorithm>::init(EVP_MD_CTX* ctx, EVP_PKEY* public_key) {
+    if constexpr (Algorithm == SigningAlgorithm::Ed25519) {
+        if (EVP_PKEY_base_id(public_key) != EVP_PKEY_ED25519) {
+            return false;
+        }
+    }
+    return digest_verify_init(ctx, digest_for<Algorithm>(), public_key) == 1;
+}
+
+template <SigningAlgorithm Algorithm>
+bool Verifier<Algorithm>::finish(EVP_MD_CTX* ctx, const uint8_t* data, size_t size,
+                                 const uint8_t* signature, size_t signature_size) {
+    if constexpr (kOneShot<Algorithm>) {
+        return EVP_DigestVerify(ctx, signature, signature_size, data, size) == 1;
+    } else {
+        if (EVP_DigestVerifyUpdate(ctx, data, size) != 1) {
+            return false;
+        }
+        return EVP_DigestVerifyFinal(ctx, signature, signature_size) == 1;
+    }
+}
+
+template <SigningAlgorithm Algorithm>
+bool Verifier<Algorithm>::verify(const KeyHandle& public_key, const uint8_t* data, size_t size,
+                                 const uint8_t* signature, size_t signature_size) {
+    if (!public_key || !signature || signature_size == 0) {
+        return false;
+    }
+
+    MdCtxPool::Lease ctx = MdCtxPool::acquire();
+    if (!ctx) {
+        return false;
+    }
+    return init(ctx.get(), public_key.get()) &&
+           finish(ctx.get(), data, size, signature, signature_size);
+}
+
+// Only enabled algorithms are instantiated
+template class Signer<SigningAlgorithm::Ed25519>;
+template class Verifier<SigningAlgorithm::Ed25519>;
+#if DECENTRILICENSE_WITH_RSA
+template class Signer<SigningAlgorithm::RSA>;
+template class Verifier<SigningAlgorithm::RSA>;
+#endif
+#if DECENTRILICENSE_WITH_SM2
+template class Signer<SigningAlgorithm::SM2>;
+template class Verifier<SigningAlgorithm::SM2>;
+#endif
+
+} // namespace decentrilicense
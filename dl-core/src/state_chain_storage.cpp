@@ -1,5 +1,12 @@
 #include "state_chain_storage.h"
+#include "chain_log_format.hpp"
+#include "durable_file.hpp"
 #include "decentrilicense/crypto_utils.hpp"
+#include "decentrilicense/hasher.hpp"
+#include "decentrilicense/sha256_multi.hpp"
+#include "decentrilicense/timer_scheduler.hpp"
+#include <algorithm>
+#include <condition_variable>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -11,12 +18,129 @@ namespace fs = std::filesystem;
 
 namespace decentrilicense {
 
+namespace {
+
+// 检查点间隔：追加次数，以及第一次未保存的追加之后最多等待的时间
+constexpr uint64_t kCheckpointAppends = 100;
+constexpr std::chrono::seconds kCheckpointDelay{1};
+
+// ChainDurability::None下进程内缓存的记录达到该大小时写出
+constexpr size_t kLogBufferSize = 64 * 1024;
+
+uint64_t unix_now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// 封存段的文件名：chain_log.<8位段号>.bin / .idx
+constexpr char kSegmentPrefix[] = "chain_log.";
+
+std::string segment_file_name(uint64_t segment, const char* extension) {
+    std::ostringstream oss;
+    oss << kSegmentPrefix << std::setw(8) << std::setfill('0') << segment << extension;
+    return oss.str();
+}
+
+std::optional<uint64_t> parse_segment_file_name(const std::string& name) {
+    const size_t prefix = sizeof(kSegmentPrefix) - 1;
+    const size_t suffix = 4;    // ".bin"
+    if (name.size() <= prefix + suffix || name.size() > prefix + 20 + suffix ||
+        name.compare(0, prefix, kSegmentPrefix) != 0 || name.compare(name.size() - suffix, suffix, ".bin") != 0) {
+        return std::nullopt;
+    }
+    const std::string digits = name.substr(prefix, name.size() - prefix - suffix);
+    if (!std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return std::nullopt;
+    }
+    return std::stoull(digits);
+}
+
+// 目录中封存段的段号，升序
+std::vector<uint64_t> list_segment_files(const std::string& dir) {
+    std::vector<uint64_t> segments;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::optional<uint64_t> segment = parse_segment_file_name(it->path().filename().string());
+        if (segment) {
+            segments.push_back(*segment);
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+bool sha256_file(const std::string& path, uint8_t* digest) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    Hasher hasher;
+    std::vector<char> buffer(64 * 1024);
+    while (file) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        hasher.update(buffer.data(), static_cast<size_t>(file.gcount()));
+    }
+    if (file.bad()) {
+        return false;
+    }
+    const Hasher::Digest result = hasher.finalize();
+    std::memcpy(digest, result.data(), result.size());
+    return true;
+}
+
+} // namespace
+
+struct StateChainStorage::OpenChain {
+    DurableFile log;                                // 以追加模式打开的chain_log.bin
+    std::vector<uint8_t> log_buffer;                // 尚未写入日志的记录（仅ChainDurability::None）
+    uint64_t log_size = 0;                          // 下一条记录的偏移，含缓存的记录
+    std::optional<ChainMetadata> metadata;          // 元数据文件存在时才维护
+    std::vector<uint8_t> current_state;             // 最近追加的状态（序列化）
+    std::vector<ChainIndexEntry> pending_index;     // 尚未写入chain_log.idx的索引项
+    uint64_t segment = 0;                           // 活动段的段号
+    uint64_t unsaved_appends = 0;                   // 上次检查点以来的追加次数
+    TimerScheduler::TimerId checkpoint_timer = 0;
+
+    // 逐条同步和组提交：记录按追加顺序编号，同步一次覆盖此前写入的全部记录
+    uint64_t written_records = 0;                   // 已写入操作系统的记录数
+    uint64_t synced_records = 0;                    // 已同步到磁盘的记录数
+    std::chrono::steady_clock::time_point first_unsynced;  // 最早一条未同步记录的写入时间
+    bool syncing = false;                           // 有线程正在同步（不持锁）
+    bool closed = false;                            // 已从open_chains_移除，等待者不再可能同步
+    std::condition_variable sync_done;              // 与chains_mutex_配合
+};
+
 StateChainStorage::StateChainStorage(const std::string& storage_root) 
     : storage_root_(storage_root) {
     // 确保存储根目录存在
     createDirectory(storage_root_);
 }
 
+StateChainStorage::~StateChainStorage() {
+    // 先停掉检查点定时器，包括已随链关闭但可能正在运行的；
+    // 回调要获取chains_mutex_，不能持锁等待
+    std::vector<TimerScheduler::TimerId> timers;
+    {
+        std::lock_guard<std::mutex> lock(chains_mutex_);
+        timers.swap(detached_timers_);
+        for (auto& [license_id, chain] : open_chains_) {
+            if (chain->checkpoint_timer != 0) {
+                timers.push_back(chain->checkpoint_timer);
+                chain->checkpoint_timer = 0;
+            }
+        }
+    }
+    for (TimerScheduler::TimerId timer : timers) {
+        TimerScheduler::instance().cancel_and_wait(timer);
+    }
+
+    std::lock_guard<std::mutex> lock(chains_mutex_);
+    for (auto& [license_id, chain] : open_chains_) {
+        (void)writeCheckpoint(license_id, *chain);
+    }
+    open_chains_.clear();
+}
+
 std::string StateChainStorage::getChainDir(const std::string& license_id) const {
     return storage_root_ + "/" + license_id;
 }
@@ -29,6 +153,18 @@ std::string StateChainStorage::getChainLogPath(const std::string& license_id) co
     return getChainDir(license_id) + "/chain_log.bin";
 }
 
+std::string StateChainStorage::getChainIndexPath(const std::string& license_id) const {
+    return getChainDir(license_id) + "/chain_log.idx";
+}
+
+std::string StateChainStorage::getSegmentPath(const std::string& license_id, uint64_t segment) const {
+    return getChainDir(license_id) + "/" + segment_file_name(segment, ".bin");
+}
+
+std::string StateChainStorage::getSegmentIndexPath(const std::string& license_id, uint64_t segment) const {
+    return getChainDir(license_id) + "/" + segment_file_name(segment, ".idx");
+}
+
 std::string StateChainStorage::getCurrentStatePath(const std::string& license_id) const {
     return getChainDir(license_id) + "/current_state.json";
 }
@@ -47,46 +183,49 @@ bool StateChainStorage::createDirectory(const std::string& dirpath) const {
 }
 
 std::vector<uint8_t> StateChainStorage::serializeToken(const Token& token) const {
+    // 二进制v2编码，比JSON小得多
+    return token.to_binary();
+}
+
+std::vector<uint8_t> StateChainStorage::serializeTokenJson(const Token& token) const {
     std::string json_str = token.to_json();
     return std::vector<uint8_t>(json_str.begin(), json_str.end());
 }
 
 Token StateChainStorage::deserializeToken(const std::vector<uint8_t>& data) const {
-    std::string json_str(data.begin(), data.end());
-    // 解析JSON字符串为Token对象
-    Token token = Token::from_json(json_str);
-    return token;
-}
-
-uint32_t StateChainStorage::calculateChecksum(const std::vector<uint8_t>& data) const {
-    uint32_t checksum = 0;
-    for (const auto& byte : data) {
-        checksum += byte;
+    // 同时接受二进制v2和旧版JSON记录
+    Token token{};
+    if (!Token::decode(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()), &token)) {
+        return Token{};
     }
-    return checksum;
+    return token;
 }
 
 bool StateChainStorage::atomicWriteFile(const std::string& filepath, const std::vector<uint8_t>& data) const {
     // 创建临时文件
     std::string temp_path = filepath + ".tmp";
     
-    std::ofstream file(temp_path, std::ios::binary);
-    if (!file.is_open()) {
+    DurableFile file;
+    if (!file.open(temp_path, DurableFile::Mode::Truncate)) {
         return false;
     }
     
-    file.write(reinterpret_cast<const char*>(data.data()), data.size());
-    file.close();
-    
-    if (file.fail()) {
+    // 要求落盘时先同步内容再重命名，否则断电后可能得到空文件
+    const bool sync = sync_files_.load(std::memory_order_relaxed);
+    if (!file.write(data.data(), data.size()) || (sync && !file.sync())) {
+        file.close();
         std::remove(temp_path.c_str());
         return false;
     }
+    file.close();
     
-    // 原子重命名
+    // 原子重命名，之后同步目录使重命名本身落盘
     std::error_code ec;
     fs::rename(temp_path, filepath, ec);
-    return !ec;
+    if (ec) {
+        return false;
+    }
+    return !sync || sync_directory(fs::path(filepath).parent_path().string());
 }
 
 std::vector<uint8_t> StateChainStorage::readFile(const std::string& filepath) const {
@@ -113,6 +252,7 @@ bool StateChainStorage::saveMetadata(const std::string& license_id, const ChainM
     oss << "\"version\":" << metadata.version << ",";
     oss << "\"total_states\":" << metadata.total_states << ",";
     oss << "\"last_verification_time\":" << metadata.last_verification_time << ",";
+    oss << "\"log_size\":" << metadata.log_size << ",";
     oss << "\"license_id\":\"" << metadata.license_id << "\"";
     oss << "}";
     
@@ -155,16 +295,25 @@ std::optional<ChainMetadata> StateChainStorage::loadMetadata(const std::string&
         // 查找last_verification_time
         pos = json_str.find("\"last_verification_time\":");
         if (pos != std::string::npos) {
-            pos += 23; // 跳过 "\"last_verification_time\":"
+            pos += 25; // 跳过 "\"last_verification_time\":"
             size_t end = json_str.find_first_of(",}", pos);
             std::string value = json_str.substr(pos, end - pos);
             metadata.last_verification_time = static_cast<uint64_t>(std::stoull(value));
         }
+
+        // 查找log_size
+        pos = json_str.find("\"log_size\":");
+        if (pos != std::string::npos) {
+            pos += 11; // 跳过 "\"log_size\":"
+            size_t end = json_str.find_first_of(",}", pos);
+            std::string value = json_str.substr(pos, end - pos);
+            metadata.log_size = static_cast<uint64_t>(std::stoull(value));
+        }
         
         // 查找license_id
         pos = json_str.find("\"license_id\":\"");
         if (pos != std::string::npos) {
-            pos += 13; // 跳过 "\"license_id\":\""
+            pos += 14; // 跳过 "\"license_id\":\""
             size_t end = json_str.find("\"", pos);
             metadata.license_id = json_str.substr(pos, end - pos);
         }
@@ -180,6 +329,16 @@ bool StateChainStorage::saveFullChain(const std::string& license_id,
     if (chain.empty()) {
         return false;
     }
+
+    // 整条链重写，丢弃追加中的缓存；封存的段随之作废（已归档的保留）
+    std::lock_guard<std::mutex> lock(chains_mutex_);
+    closeChain(license_id);
+    std::error_code ec;
+    for (uint64_t segment : listSegments(license_id)) {
+        fs::remove(getSegmentPath(license_id, segment), ec);
+        fs::remove(getSegmentIndexPath(license_id, segment), ec);
+    }
+    fs::remove(getChainLogPath(license_id) + ".tmp", ec);
     
     // 创建链目录
     if (!createDirectory(getChainDir(license_id))) {
@@ -187,40 +346,58 @@ bool StateChainStorage::saveFullChain(const std::string& license_id,
     }
     
     // 保存创世Token
-    std::string genesis_json = chain.front().to_json();
-    std::vector<uint8_t> genesis_data(genesis_json.begin(), genesis_json.end());
+    std::vector<uint8_t> genesis_data = serializeTokenJson(chain.front());
     if (!atomicWriteFile(getGenesisTokenPath(license_id), genesis_data)) {
         return false;
     }
     
     // 创建新的链日志文件
-    std::ofstream log_file(getChainLogPath(license_id), std::ios::binary);
-    if (!log_file.is_open()) {
+    DurableFile log_file;
+    if (!log_file.open(getChainLogPath(license_id), DurableFile::Mode::Truncate)) {
         return false;
     }
     
-    // 写入所有状态到链日志
+    // 写入所有状态到链日志，同时生成索引
+    const uint64_t now = unix_now();
+    std::vector<ChainIndexEntry> index;
+    index.reserve(chain.size());
+    std::vector<uint8_t> buffer;
+    uint64_t offset = 0;
     for (const auto& token : chain) {
         auto token_data = serializeToken(token);
-        uint32_t length = static_cast<uint32_t>(token_data.size());
-        uint32_t checksum = calculateChecksum(token_data);
-        
-        // 写入记录长度
-        log_file.write(reinterpret_cast<const char*>(&length), sizeof(length));
-        // 写入Token数据
-        log_file.write(reinterpret_cast<const char*>(token_data.data()), token_data.size());
-        // 写入校验和
-        log_file.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+
+        // 带CRC-32C和提交标记的记录，攒成大块写入
+        const size_t start = buffer.size();
+        uint32_t checksum = encode_chain_record(token_data.data(), token_data.size(), &buffer);
+        const size_t record_size = buffer.size() - start;
+        if (buffer.size() >= kLogBufferSize) {
+            if (!log_file.write(buffer.data(), buffer.size())) {
+                return false;
+            }
+            buffer.clear();
+        }
+
+        index.push_back({token.state_index, offset, static_cast<uint32_t>(record_size), checksum, now});
+        offset += record_size;
     }
     
-    log_file.close();
-    if (log_file.fail()) {
+    if (!log_file.write(buffer.data(), buffer.size())) {
+        return false;
+    }
+    if (sync_files_.load(std::memory_order_relaxed) &&
+        (!log_file.sync() || !sync_directory(getChainDir(license_id)))) {
         return false;
     }
+    log_file.close();
+
+    // 索引写失败不影响链本身，读取时会从日志重建
+    if (!atomicWriteFile(getChainIndexPath(license_id), encode_chain_index(index.data(), index.size()))) {
+        std::error_code ec;
+        fs::remove(getChainIndexPath(license_id), ec);
+    }
     
     // 保存当前状态
-    std::string current_json = chain.back().to_json();
-    std::vector<uint8_t> current_data(current_json.begin(), current_json.end());
+    std::vector<uint8_t> current_data = serializeTokenJson(chain.back());
     if (!atomicWriteFile(getCurrentStatePath(license_id), current_data)) {
         return false;
     }
@@ -229,121 +406,593 @@ bool StateChainStorage::saveFullChain(const std::string& license_id,
     ChainMetadata metadata;
     metadata.total_states = chain.size();
     metadata.license_id = license_id;
-    metadata.last_verification_time = std::chrono::duration_cast<std::chrono::seconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    metadata.last_verification_time = now;
+    metadata.log_size = offset;
     
     return saveMetadata(license_id, metadata);
 }
 
 bool StateChainStorage::appendState(const std::string& license_id, 
                                    const Token& new_state) {
-    // 以追加模式打开链日志文件
-    std::ofstream log_file(getChainLogPath(license_id), std::ios::binary | std::ios::app);
-    if (!log_file.is_open()) {
+    std::unique_lock<std::mutex> lock(chains_mutex_);
+    std::shared_ptr<OpenChain> chain = openChain(license_id);
+    if (!chain) {
         return false;
     }
-    
-    // 序列化Token
+
+    // 活动段达到上限时先封存，新段以链头快照开头
+    if (max_segment_size_ > 0 && chain->log_size >= max_segment_size_ &&
+        !sealSegment(lock, license_id, *chain, max_segment_size_)) {
+        closeChain(license_id, chain.get());
+        return false;
+    }
+
+    // 序列化Token，整条记录一次写入；这是每次追加唯一的文件操作
+    // （None级别下先缓存在进程内）
     auto token_data = serializeToken(new_state);
-    uint32_t length = static_cast<uint32_t>(token_data.size());
-    uint32_t checksum = calculateChecksum(token_data);
-    
-    // 写入记录
-    log_file.write(reinterpret_cast<const char*>(&length), sizeof(length));
-    log_file.write(reinterpret_cast<const char*>(token_data.data()), token_data.size());
-    log_file.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
-    
-    log_file.close();
-    if (log_file.fail()) {
+    const size_t start = chain->log_buffer.size();
+    uint32_t checksum = encode_chain_record(token_data.data(), token_data.size(), &chain->log_buffer);
+    const size_t record_size = chain->log_buffer.size() - start;
+    const ChainDurability level = durability_.level;
+    if (level != ChainDurability::None || chain->log_buffer.size() >= kLogBufferSize) {
+        if (!flushLog(*chain)) {
+            // 可能留下残缺记录：关闭句柄，下次打开时截掉
+            closeChain(license_id, chain.get());
+            return false;
+        }
+    }
+
+    // 当前状态、元数据和索引项留在内存中，由检查点写回
+    const uint64_t now = unix_now();
+    chain->pending_index.push_back({new_state.state_index, chain->log_size,
+                                    static_cast<uint32_t>(record_size), checksum, now});
+    chain->log_size += record_size;
+    chain->current_state = std::move(token_data);
+    if (chain->metadata) {
+        chain->metadata->total_states++;
+        chain->metadata->last_verification_time = now;
+    }
+
+    // 逐条同步和组提交都在释放chains_mutex_后同步，不阻塞其他链
+    if (level == ChainDurability::SyncEachRecord || level == ChainDurability::GroupCommit) {
+        const uint64_t record = ++chain->written_records;
+        if (record == chain->synced_records + 1) {
+            chain->first_unsynced = std::chrono::steady_clock::now();
+        }
+        if (!waitForGroupCommit(lock, license_id, chain, record)) {
+            return false;
+        }
+        // 等待期间链可能已被关闭（如saveFullChain重写），不再写检查点
+        if (chain->closed) {
+            return true;
+        }
+    }
+
+    if (++chain->unsaved_appends >= kCheckpointAppends) {
+        return writeCheckpoint(license_id, *chain);
+    }
+    if (chain->checkpoint_timer == 0) {
+        // 定时器不会被取消而不等待，回调只认自己的id：链被关闭或重新打开后
+        // 它只把自己从detached_timers_中移除，析构函数总能等到它结束。
+        // id在持锁时写入，回调先获取chains_mutex_再读取
+        auto timer = std::make_shared<TimerScheduler::TimerId>(0);
+        *timer = TimerScheduler::instance().schedule_after(kCheckpointDelay, [this, license_id, timer]() {
+            std::lock_guard<std::mutex> timer_lock(chains_mutex_);
+            auto it = open_chains_.find(license_id);
+            if (it != open_chains_.end() && it->second->checkpoint_timer == *timer) {
+                it->second->checkpoint_timer = 0;
+                (void)writeCheckpoint(license_id, *it->second);
+                return;
+            }
+            detached_timers_.erase(std::remove(detached_timers_.begin(), detached_timers_.end(), *timer),
+                                   detached_timers_.end());
+        });
+        chain->checkpoint_timer = *timer;
+    }
+    return true;
+}
+
+bool StateChainStorage::checkpoint(const std::string& license_id) {
+    std::lock_guard<std::mutex> lock(chains_mutex_);
+    auto it = open_chains_.find(license_id);
+    if (it == open_chains_.end()) {
+        return true;
+    }
+    return writeCheckpoint(license_id, *it->second);
+}
+
+bool StateChainStorage::waitForGroupCommit(std::unique_lock<std::mutex>& lock, const std::string& license_id,
+                                           const std::shared_ptr<OpenChain>& chain, uint64_t record) {
+    while (chain->synced_records < record) {
+        if (chain->closed) {
+            return false;
+        }
+        if (chain->syncing) {
+            // 正在进行的同步可能不包含本记录，结束后重新判断
+            chain->sync_done.wait(lock);
+            continue;
+        }
+
+        // 组提交攒够记录数或最早的记录等够时间时同步；其他级别（逐条同步，
+        // 或级别已改变）立即同步
+        if (durability_.level == ChainDurability::GroupCommit) {
+            const uint64_t unsynced = chain->written_records - chain->synced_records;
+            const auto deadline = chain->first_unsynced + durability_.group_commit_delay;
+            if (unsynced < durability_.group_commit_records && std::chrono::steady_clock::now() < deadline) {
+                chain->sync_done.wait_until(lock, deadline);
+                continue;
+            }
+        }
+
+        // 由本线程一次同步此前写入的全部记录，同步期间释放锁让其他追加继续写入
+        const uint64_t target = chain->written_records;
+        const auto started = std::chrono::steady_clock::now();
+        chain->syncing = true;
+        lock.unlock();
+        const bool synced = chain->log.sync();
+        lock.lock();
+        chain->syncing = false;
+        if (synced) {
+            chain->synced_records = target;
+            chain->first_unsynced = started;
+        } else {
+            // 同步失败后页缓存状态不可信，关闭日志，下次追加重新打开
+            closeChain(license_id, chain.get());
+            chain->closed = true;
+        }
+        chain->sync_done.notify_all();
+    }
+    return true;
+}
+
+void StateChainStorage::setDurability(const DurabilityOptions& options) {
+    std::lock_guard<std::mutex> lock(chains_mutex_);
+    durability_ = options;
+    durability_.group_commit_records = std::max<size_t>(options.group_commit_records, 1);
+    sync_files_.store(options.level == ChainDurability::SyncEachRecord ||
+                      options.level == ChainDurability::GroupCommit, std::memory_order_relaxed);
+    for (auto& [license_id, chain] : open_chains_) {
+        // 离开None级别时写出缓存的记录；唤醒组提交的等待者按新级别重新判断
+        if (options.level != ChainDurability::None) {
+            (void)flushLog(*chain);
+        }
+        chain->sync_done.notify_all();
+    }
+}
+
+DurabilityOptions StateChainStorage::durability() const {
+    std::lock_guard<std::mutex> lock(chains_mutex_);
+    return durability_;
+}
+
+void StateChainStorage::setMaxSegmentSize(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(chains_mutex_);
+    max_segment_size_ = bytes;
+}
+
+bool StateChainStorage::snapshotChain(const std::string& license_id) {
+    std::unique_lock<std::mutex> lock(chains_mutex_);
+    std::shared_ptr<OpenChain> chain = openChain(license_id);
+    if (!chain) {
         return false;
     }
-    
-    // 更新当前状态
-    std::string current_json = new_state.to_json();
-    std::vector<uint8_t> current_data(current_json.begin(), current_json.end());
-    if (!atomicWriteFile(getCurrentStatePath(license_id), current_data)) {
+    if (!sealSegment(lock, license_id, *chain, 0)) {
+        closeChain(license_id, chain.get());
         return false;
     }
-    
-    // 更新元数据
-    auto metadata_opt = loadMetadata(license_id);
-    if (metadata_opt.has_value()) {
-        ChainMetadata metadata = metadata_opt.value();
-        metadata.total_states++;
-        metadata.last_verification_time = std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
-        return saveMetadata(license_id, metadata);
+    return true;
+}
+
+bool StateChainStorage::sealSegment(std::unique_lock<std::mutex>& lock, const std::string& license_id,
+                                    OpenChain& chain, uint64_t min_size) {
+    // 同步线程不持锁使用日志句柄，等它结束再关闭；等待期间可能已被别的追加封存
+    while (chain.syncing) {
+        chain.sync_done.wait(lock);
     }
-    
+    if (chain.closed) {
+        return false;
+    }
+    if (chain.log_size < min_size) {
+        return true;
+    }
+
+    const bool sync = sync_files_.load(std::memory_order_relaxed);
+    if (!flushLog(chain) || (sync && !chain.log.sync())) {
+        return false;
+    }
+    if (sync) {
+        chain.synced_records = chain.written_records;
+        chain.sync_done.notify_all();
+    }
+    (void)flushIndex(license_id, chain);
+
+    // 链头状态取自日志最后一条；段中只有快照时无需封存
+    const std::string log_path = getChainLogPath(license_id);
+    std::unique_ptr<ChainLogReader> reader = openChainReaderLocked(license_id);
+    if (!reader || reader->size() == 0 || (reader->snapshot() && reader->size() < 2)) {
+        return reader != nullptr;
+    }
+    std::optional<ChainStateView> head = reader->at(reader->size() - 1);
+    if (!head) {
+        return false;
+    }
+    const std::vector<uint8_t> head_data(head->data.begin(), head->data.end());
+    const uint64_t head_index = head->state_index;
+    const uint64_t head_timestamp = head->timestamp;
+    reader.reset();
+
+    ChainSnapshot snapshot;
+    snapshot.segment = chain.segment + 1;
+    if (!sha256_file(log_path, snapshot.previous_sha256)) {
+        return false;
+    }
+
+    // 新段先写到临时文件，改名中断时由finishSegmentRotation收尾
+    std::vector<uint8_t> record;
+    const uint32_t checksum = encode_chain_snapshot(snapshot, head_data.data(), head_data.size(), &record);
+    const std::string next_path = log_path + ".tmp";
+    {
+        DurableFile next;
+        if (!next.open(next_path, DurableFile::Mode::Truncate) || !next.write(record.data(), record.size()) ||
+            (sync && !next.sync())) {
+            next.close();
+            std::remove(next_path.c_str());
+            return false;
+        }
+    }
+
+    // 先移走索引：中途中断时活动段没有索引，读取时从日志重建，不会用错
+    chain.log.close();
+    std::error_code ec;
+    fs::rename(getChainIndexPath(license_id), getSegmentIndexPath(license_id, chain.segment), ec);
+    if (ec) {
+        fs::remove(getChainIndexPath(license_id), ec);
+    }
+    fs::rename(log_path, getSegmentPath(license_id, chain.segment), ec);
+    if (ec) {
+        std::remove(next_path.c_str());
+        return false;
+    }
+    finishSegmentRotation(license_id);
+    if ((sync && !sync_directory(getChainDir(license_id))) ||
+        !chain.log.open(log_path, DurableFile::Mode::Append)) {
+        return false;
+    }
+
+    chain.segment = snapshot.segment;
+    chain.log_size = record.size();
+    chain.pending_index.push_back({head_index, 0, static_cast<uint32_t>(record.size()), checksum, head_timestamp});
+    (void)flushIndex(license_id, chain);
     return true;
 }
 
-std::vector<Token> StateChainStorage::loadChain(const std::string& license_id) {
-    std::vector<Token> chain;
-    
-    // 打开链日志文件
-    std::ifstream log_file(getChainLogPath(license_id), std::ios::binary);
-    if (!log_file.is_open()) {
-        return chain;
+void StateChainStorage::finishSegmentRotation(const std::string& license_id) {
+    // 新段已写好：活动段已封存则补上改名，否则封存未开始，丢弃新段
+    const std::string log_path = getChainLogPath(license_id);
+    const std::string next_path = log_path + ".tmp";
+    std::error_code ec;
+    if (!fs::exists(next_path, ec)) {
+        return;
     }
-    
-    // 逐个读取记录
-    while (log_file.peek() != EOF) {
-        // 读取记录长度
-        uint32_t length;
-        log_file.read(reinterpret_cast<char*>(&length), sizeof(length));
-        if (log_file.eof() || log_file.fail()) {
-            break;
+    if (fs::exists(log_path, ec)) {
+        fs::remove(next_path, ec);
+    } else {
+        fs::rename(next_path, log_path, ec);
+    }
+}
+
+std::vector<uint64_t> StateChainStorage::listSegments(const std::string& license_id) {
+    return list_segment_files(getChainDir(license_id));
+}
+
+size_t StateChainStorage::archiveSegments(const std::string& license_id) {
+    std::lock_guard<std::mutex> lock(chains_mutex_);
+    const std::string backup_dir = getBackupPath(license_id);
+    const std::vector<uint64_t> segments = listSegments(license_id);
+    if (segments.empty() || !createDirectory(backup_dir)) {
+        return 0;
+    }
+
+    size_t archived = 0;
+    for (uint64_t segment : segments) {
+        // 不覆盖已归档的同名段，留在链目录中
+        const std::string archived_path = backup_dir + "/" + segment_file_name(segment, ".bin");
+        std::error_code ec;
+        if (fs::exists(archived_path, ec) || ec) {
+            continue;
         }
-        
-        // 读取Token数据
-        std::vector<uint8_t> token_data(length);
-        log_file.read(reinterpret_cast<char*>(token_data.data()), length);
-        if (log_file.fail()) {
-            break;
+        fs::rename(getSegmentPath(license_id, segment), archived_path, ec);
+        if (ec) {
+            continue;
         }
-        
-        // 读取校验和
-        uint32_t stored_checksum;
-        log_file.read(reinterpret_cast<char*>(&stored_checksum), sizeof(stored_checksum));
-        if (log_file.fail()) {
-            break;
+        // 索引可由日志重建，无法移动（或备份目录中已有同名索引）时直接删除
+        const std::string archived_index_path = backup_dir + "/" + segment_file_name(segment, ".idx");
+        if (fs::exists(archived_index_path, ec) || ec) {
+            fs::remove(getSegmentIndexPath(license_id, segment), ec);
+        } else {
+            fs::rename(getSegmentIndexPath(license_id, segment), archived_index_path, ec);
+            if (ec) {
+                fs::remove(getSegmentIndexPath(license_id, segment), ec);
+            }
         }
-        
-        // 验证校验和
-        uint32_t calculated_checksum = calculateChecksum(token_data);
-        if (calculated_checksum != stored_checksum) {
-            // 校验和不匹配，数据可能已损坏
-            break;
+        archived++;
+    }
+    if (archived > 0 && sync_files_.load(std::memory_order_relaxed)) {
+        (void)sync_directory(backup_dir);
+        (void)sync_directory(getChainDir(license_id));
+    }
+    return archived;
+}
+
+size_t StateChainStorage::compactChain(const std::string& license_id) {
+    std::lock_guard<std::mutex> lock(chains_mutex_);
+    // 活动段必须以有效快照开头，否则删掉封存段会丢失链的开头
+    std::unique_ptr<ChainLogReader> reader = openChainReaderLocked(license_id);
+    if (!reader || !reader->snapshot() || !reader->at(0)) {
+        return 0;
+    }
+    reader.reset();
+
+    size_t removed = 0;
+    for (uint64_t segment : listSegments(license_id)) {
+        std::error_code ec;
+        if (fs::remove(getSegmentPath(license_id, segment), ec)) {
+            removed++;
         }
-        
-        // 反序列化Token
-        try {
-            Token token = deserializeToken(token_data);
-            chain.push_back(token);
-        } catch (...) {
-            // 如果反序列化失败，跳过这个记录
-            continue;
+        fs::remove(getSegmentIndexPath(license_id, segment), ec);
+    }
+    if (removed > 0 && sync_files_.load(std::memory_order_relaxed)) {
+        (void)sync_directory(getChainDir(license_id));
+    }
+    return removed;
+}
+
+std::shared_ptr<StateChainStorage::OpenChain> StateChainStorage::openChain(const std::string& license_id) {
+    auto it = open_chains_.find(license_id);
+    if (it != open_chains_.end()) {
+        return it->second;
+    }
+
+    auto chain = std::make_shared<OpenChain>();
+    const std::string log_path = getChainLogPath(license_id);
+    uint64_t states = 0;
+    bool numbered = false;
+    finishSegmentRotation(license_id);
+    if (fs::exists(log_path)) {
+        // 打开时截掉上次中断的追加留下的残缺尾部，否则新记录读不到
+        std::unique_ptr<ChainLogReader> reader = openChainReaderLocked(license_id);
+        if (!reader) {
+            return nullptr;
+        }
+        // 状态数含最新快照之前的状态
+        states = reader->size();
+        if (std::optional<ChainSnapshot> snapshot = reader->snapshot()) {
+            chain->segment = snapshot->segment;
+            numbered = true;
+            if (std::optional<ChainStateView> head = reader->at(0)) {
+                states += head->state_index;
+            }
+        }
+        reader.reset();
+        std::error_code ec;
+        const uintmax_t log_size = fs::file_size(log_path, ec);
+        if (ec) {
+            return nullptr;
         }
+        chain->log_size = static_cast<uint64_t>(log_size);
+    }
+    if (!numbered) {
+        // 没有快照的日志（新建或被saveFullChain重写）接着链目录和备份目录中
+        // 最大的段号编号，封存和归档时不会与旧段同名
+        for (const std::string& dir : {getChainDir(license_id), getBackupPath(license_id)}) {
+            const std::vector<uint64_t> segments = list_segment_files(dir);
+            if (!segments.empty()) {
+                chain->segment = std::max(chain->segment, segments.back() + 1);
+            }
+        }
+    }
+
+    // 新建的日志要同步目录，否则断电后整个文件可能丢失
+    bool created = false;
+    if (!chain->log.open(log_path, DurableFile::Mode::Append, &created)) {
+        return nullptr;
+    }
+    if (created && sync_files_.load(std::memory_order_relaxed) && !sync_directory(getChainDir(license_id))) {
+        return nullptr;
+    }
+
+    // 状态数以日志为准
+    chain->metadata = loadMetadata(license_id);
+    if (chain->metadata) {
+        chain->metadata->total_states = states;
+    }
+
+    open_chains_[license_id] = chain;
+    return chain;
+}
+
+bool StateChainStorage::writeCheckpoint(const std::string& license_id, OpenChain& chain) {
+    // 定时器保持不变：到期时若已无新追加则直接返回
+
+    // 日志先于current_state.json写出；索引写失败不影响链本身，读取时会从日志重建
+    if (!flushLog(chain)) {
+        return false;
+    }
+    (void)flushIndex(license_id, chain);
+    if (chain.unsaved_appends == 0) {
+        return true;
+    }
+
+    // 先写当前状态再写元数据：元数据中的log_size说明current_state.json覆盖到哪里
+    // 内存中缓存的是日志记录的二进制编码，写文件时转回JSON
+    Token current{};
+    if (!Token::decode(std::string_view(reinterpret_cast<const char*>(chain.current_state.data()),
+                                        chain.current_state.size()), &current) ||
+        !atomicWriteFile(getCurrentStatePath(license_id), serializeTokenJson(current))) {
+        return false;
+    }
+    if (chain.metadata) {
+        chain.metadata->log_size = chain.log_size;
+        if (!saveMetadata(license_id, *chain.metadata)) {
+            return false;
+        }
+    }
+    chain.unsaved_appends = 0;
+    return true;
+}
+
+bool StateChainStorage::flushLog(OpenChain& chain) {
+    if (chain.log_buffer.empty()) {
+        return true;
+    }
+    const bool written = chain.log.write(chain.log_buffer.data(), chain.log_buffer.size());
+    chain.log_buffer.clear();
+    return written;
+}
+
+bool StateChainStorage::flushIndex(const std::string& license_id, OpenChain& chain) {
+    if (chain.pending_index.empty()) {
+        return true;
+    }
+    // 索引过期时会被删除，由读取方重建
+    const bool appended = append_chain_index(getChainIndexPath(license_id),
+                                             chain.pending_index.data(), chain.pending_index.size());
+    chain.pending_index.clear();
+    return appended;
+}
+
+void StateChainStorage::closeChain(const std::string& license_id, const OpenChain* expected) {
+    auto it = open_chains_.find(license_id);
+    if (it == open_chains_.end() || (expected && it->second.get() != expected)) {
+        return;
+    }
+    if (it->second->checkpoint_timer != 0) {
+        detached_timers_.push_back(it->second->checkpoint_timer);
+    }
+    // 组提交的等待者持有引用，在同步失败或链被重写时不再等待
+    it->second->closed = true;
+    it->second->sync_done.notify_all();
+    open_chains_.erase(it);
+}
+
+std::vector<Token> StateChainStorage::loadChain(const std::string& license_id) {
+    std::vector<Token> chain;
+    
+    // 内存映射读取链日志，遇到损坏记录即停止
+    std::unique_ptr<ChainLogReader> reader = openChainReader(license_id);
+    if (!reader) {
+        return chain;
+    }
+
+    chain.reserve(reader->size());
+    for (const ChainStateView& state : *reader) {
+        Token token{};
+        if (!state.decode(&token)) {
+            token = Token{};
+        }
+        chain.push_back(std::move(token));
     }
     
     return chain;
 }
 
+std::unique_ptr<ChainLogReader> StateChainStorage::openChainReader(const std::string& license_id) {
+    std::lock_guard<std::mutex> lock(chains_mutex_);
+    // 先写出缓存的记录和索引项，免得读取方读不到或扫描日志补全索引
+    auto it = open_chains_.find(license_id);
+    if (it != open_chains_.end()) {
+        if (!flushLog(*it->second)) {
+            closeChain(license_id);
+        } else {
+            (void)flushIndex(license_id, *it->second);
+        }
+    }
+    return openChainReaderLocked(license_id);
+}
+
+std::unique_ptr<ChainLogReader> StateChainStorage::openChainReaderLocked(const std::string& license_id) {
+    finishSegmentRotation(license_id);
+    const std::string log_path = getChainLogPath(license_id);
+    const std::string index_path = getChainIndexPath(license_id);
+    std::unique_ptr<ChainLogReader> reader = ChainLogReader::open(log_path, index_path);
+    if (!reader || !reader->has_torn_tail()) {
+        return reader;
+    }
+
+    // 上次追加被中断：截掉残缺的尾部记录后重新打开
+    const uint64_t intact_size = reader->intact_size();
+    reader.reset();
+    std::error_code ec;
+    fs::resize_file(log_path, intact_size, ec);
+    return ChainLogReader::open(log_path, index_path);
+}
+
+std::optional<Token> StateChainStorage::loadState(const std::string& license_id, uint64_t state_index) {
+    std::unique_ptr<ChainLogReader> reader = openChainReader(license_id);
+    std::optional<ChainStateView> state;
+    if (reader) {
+        state = reader->state(state_index);
+    }
+
+    // 最新快照之前的状态在封存的段中，从新到旧查找
+    if (!state) {
+        const std::vector<uint64_t> segments = listSegments(license_id);
+        for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
+            reader = ChainLogReader::open(getSegmentPath(license_id, *it), getSegmentIndexPath(license_id, *it));
+            if (!reader) {
+                continue;
+            }
+            state = reader->state(state_index);
+            std::optional<ChainStateView> first = reader->at(0);
+            if (state || (first && first->state_index <= state_index)) {
+                break;
+            }
+        }
+    }
+    Token token{};
+    if (!state || !state->decode(&token)) {
+        return std::nullopt;
+    }
+    return token;
+}
+
 std::optional<Token> StateChainStorage::getCurrentState(const std::string& license_id) {
-    auto data = readFile(getCurrentStatePath(license_id));
+    std::vector<uint8_t> data;
+    {
+        std::lock_guard<std::mutex> lock(chains_mutex_);
+        auto it = open_chains_.find(license_id);
+        if (it != open_chains_.end()) {
+            data = it->second->current_state;
+        }
+    }
+
+    if (data.empty()) {
+        // 检查点之后日志又有追加时current_state.json已过期，改读日志最后一条
+        auto metadata = loadMetadata(license_id);
+        std::error_code ec;
+        const uintmax_t log_size = fs::file_size(getChainLogPath(license_id), ec);
+        if (!ec && (!metadata.has_value() || metadata->log_size != log_size)) {
+            std::unique_ptr<ChainLogReader> reader = openChainReader(license_id);
+            Token token{};
+            if (reader && reader->size() > 0) {
+                std::optional<ChainStateView> last = reader->at(reader->size() - 1);
+                if (last && last->decode(&token)) {
+                    return token;
+                }
+            }
+        }
+        data = readFile(getCurrentStatePath(license_id));
+    }
     if (data.empty()) {
         return std::nullopt;
     }
     
-    try {
-        std::string json_str(data.begin(), data.end());
-        // 解析JSON字符串为Token对象
-        Token token = Token::from_json(json_str);
-        return token;
-    } catch (...) {
+    // 二进制v2或旧版JSON
+    Token token{};
+    if (!Token::decode(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()), &token)) {
         return std::nullopt;
     }
+    return token;
 }
 
 bool StateChainStorage::verifyStoredChain(const std::string& license_id) {
@@ -351,62 +1000,133 @@ bool StateChainStorage::verifyStoredChain(const std::string& license_id) {
     if (chain.empty()) {
         return false;
     }
+
+    // 从最新快照开始时，第一个状态是快照中的链头
+    uint64_t first_index = 0;
+    {
+        std::unique_ptr<ChainLogReader> reader = openChainReader(license_id);
+        if (reader && reader->snapshot()) {
+            first_index = chain.front().state_index;
+        }
+    }
     
     // 实现完整的链验证逻辑
     // 检查每个状态的签名和哈希链接
     for (size_t i = 0; i < chain.size(); ++i) {
         const Token& token = chain[i];
-        
+
         // 验证基本字段
         if (!token.is_valid()) {
             return false;
         }
-        
-        // 对于非创世状态，验证prev_state_hash
-        if (i > 0) {
-            const Token& prev_token = chain[i-1];
-            std::string prev_json = prev_token.to_json();
-            std::string expected_prev_hash = CryptoUtils::sha256(prev_json);
 
-            if (token.prev_state_hash != expected_prev_hash) {
+        // 验证state_index连续性
+        if (token.state_index != first_index + i) {
+            return false;
+        }
+    }
+
+    // 对于非创世状态，验证prev_state_hash
+    // 所有链接哈希互相独立，一次性交给多缓冲SHA-256并行计算
+    if (chain.size() > 1) {
+        // 先计算各JSON长度，全部写入同一块缓冲区，只分配一次
+        const size_t links = chain.size() - 1;
+        std::vector<size_t> sizes(links);
+        size_t total = 0;
+        for (size_t i = 0; i < links; ++i) {
+            sizes[i] = chain[i].json_size();
+            total += sizes[i];
+        }
+        std::vector<char> buffer(total);
+        std::vector<std::string_view> prev_json(links);
+        char* out = buffer.data();
+        for (size_t i = 0; i < links; ++i) {
+            prev_json[i] = std::string_view(out, chain[i].write_json(out));
+            out += sizes[i];
+        }
+        std::vector<Sha256Multi::Digest> digests(links);
+        Sha256Multi::digest(prev_json.data(), links, digests.data());
+
+        char expected_prev_hash[2 * Hasher::kDigestSize];
+        for (size_t i = 1; i < chain.size(); ++i) {
+            const Sha256Multi::Digest& digest = digests[i - 1];
+            Hasher::to_hex(digest.data(), digest.size(), expected_prev_hash);
+            if (chain[i].prev_state_hash !=
+                std::string_view(expected_prev_hash, sizeof(expected_prev_hash))) {
                 return false;
             }
         }
-        
-        // 验证state_index连续性
-        if (token.state_index != i) {
+    }
+
+    // 批量验证所有状态签名
+    std::vector<std::string> state_sig_data;
+    state_sig_data.reserve(chain.size());
+    for (const auto& token : chain) {
+        state_sig_data.push_back(TokenManager::create_state_signature_data(token));
+    }
+
+    std::vector<SignatureCheck> checks;
+    checks.reserve(chain.size());
+    for (size_t i = 0; i < chain.size(); ++i) {
+        if (!chain[i].alg) {
             return false;
         }
+        checks.push_back(SignatureCheck{state_sig_data[i], chain[i].state_signature,
+                                        chain[i].license_public_key, *chain[i].alg});
+    }
 
-        // 验证状态签名
-        TokenManager token_manager;
-        std::vector<Token> single_token_chain = {token};
-        if (!token_manager.verify_token_state_chain(token, single_token_chain)) {
+    VerificationBitmap results = CryptoUtils::verify_batch(checks);
+    for (bool valid : results) {
+        if (!valid) {
             return false;
         }
     }
-    
+
+    // 仍在链目录中的封存段：文件的SHA-256须与后一段快照中记录的一致
+    // 后一段已归档或删除时无法核对，跳过
+    const std::vector<uint64_t> segments = listSegments(license_id);
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const bool last = i + 1 == segments.size();
+        if (!last && segments[i + 1] != segments[i] + 1) {
+            continue;
+        }
+        std::unique_ptr<ChainLogReader> next = last ? openChainReader(license_id)
+            : ChainLogReader::open(getSegmentPath(license_id, segments[i + 1]),
+                                   getSegmentIndexPath(license_id, segments[i + 1]));
+        std::optional<ChainSnapshot> snapshot = next ? next->snapshot() : std::nullopt;
+        if (!snapshot) {
+            return false;
+        }
+        if (snapshot->segment != segments[i] + 1) {
+            continue;
+        }
+        uint8_t digest[sizeof(snapshot->previous_sha256)];
+        if (!sha256_file(getSegmentPath(license_id, segments[i]), digest) ||
+            std::memcmp(digest, snapshot->previous_sha256, sizeof(digest)) != 0) {
+            return false;
+        }
+    }
+
     return true;
 }
 
 bool StateChainStorage::recoverChain(const std::string& license_id) {
-    // 尝试从当前状态文件恢复
-    auto current_state = getCurrentState(license_id);
-    if (current_state.has_value()) {
-        // 如果当前状态文件存在且有效，我们可以从中恢复
-        std::vector<Token> chain = {current_state.value()};
-        return saveFullChain(license_id, chain);
-    }
-
-    // 如果当前状态文件不存在或无效，尝试从链日志恢复
+    // 优先从链日志恢复：从最新快照开始读取，保留封存的段
     auto chain = loadChain(license_id);
     if (!chain.empty()) {
         // 链日志中有数据，保存当前状态
-        std::string current_json = chain.back().to_json();
-        std::vector<uint8_t> current_data(current_json.begin(), current_json.end());
+        std::vector<uint8_t> current_data = serializeTokenJson(chain.back());
         return atomicWriteFile(getCurrentStatePath(license_id), current_data);
     }
 
+    // 链日志不可用时尝试从当前状态文件恢复
+    auto current_state = getCurrentState(license_id);
+    if (current_state.has_value()) {
+        // 如果当前状态文件存在且有效，我们可以从中恢复
+        std::vector<Token> recovered = {current_state.value()};
+        return saveFullChain(license_id, recovered);
+    }
+
     return false;
 }
 
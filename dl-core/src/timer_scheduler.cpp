@@ -0,0 +1,165 @@
+#include "decentrilicense/timer_scheduler.hpp"
+#include <algorithm>
+
+namespace decentrilicense {
+
+namespace {
+
+// Rebuild the heap once cancelled and rescheduled leftovers outnumber the
+// live entries by this factor
+constexpr size_t kStaleFactor = 2;
+constexpr size_t kMinCompactSize = 64;
+
+} // namespace
+
+TimerScheduler::~TimerScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+TimerScheduler& TimerScheduler::instance() {
+    static TimerScheduler* scheduler = new TimerScheduler();
+    return *scheduler;
+}
+
+TimerScheduler::TimerId TimerScheduler::schedule_at(Clock::time_point due, std::function<void()> callback,
+                                                    Clock::duration period) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const TimerId id = next_id_++;
+    Timer& timer = timers_[id];
+    timer.callback = std::move(callback);
+    timer.period = period;
+    timer.version = 0;
+    arm(id, timer, due);
+    if (!worker_.joinable()) {
+        worker_ = std::thread([this]() { run(); });
+    }
+    return id;
+}
+
+TimerScheduler::TimerId TimerScheduler::schedule_after(Clock::duration delay, std::function<void()> callback,
+                                                       Clock::duration period) {
+    return schedule_at(Clock::now() + delay, std::move(callback), period);
+}
+
+bool TimerScheduler::reschedule(TimerId id, Clock::time_point due) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = timers_.find(id);
+    if (it == timers_.end()) {
+        return false;
+    }
+    arm(id, it->second, due);
+    return true;
+}
+
+bool TimerScheduler::cancel(TimerId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timers_.erase(id) > 0;
+}
+
+void TimerScheduler::cancel_and_wait(TimerId id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    timers_.erase(id);
+    if (std::this_thread::get_id() == worker_.get_id()) {
+        return;
+    }
+    idle_.wait(lock, [&]() { return running_ != id; });
+}
+
+size_t TimerScheduler::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<size_t>(std::count_if(timers_.begin(), timers_.end(),
+                                             [](const auto& entry) { return entry.second.armed; }));
+}
+
+// Called with mutex_ held
+void TimerScheduler::arm(TimerId id, Timer& timer, Clock::time_point due) {
+    timer.due = due;
+    timer.version++;
+    timer.armed = true;
+
+    if (heap_.size() >= kMinCompactSize && heap_.size() > kStaleFactor * timers_.size()) {
+        heap_.clear();
+        for (const auto& [live_id, live] : timers_) {
+            if (live.armed && live_id != id) {
+                heap_.push_back({live.due, live_id, live.version});
+            }
+        }
+        std::make_heap(heap_.begin(), heap_.end(), std::greater<HeapEntry>());
+    }
+
+    heap_.push_back({due, id, timer.version});
+    std::push_heap(heap_.begin(), heap_.end(), std::greater<HeapEntry>());
+    if (heap_.front().id == id && heap_.front().version == timer.version) {
+        wake_.notify_one();
+    }
+}
+
+void TimerScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (heap_.empty()) {
+            wake_.wait(lock);
+            continue;
+        }
+
+        const HeapEntry top = heap_.front();
+        auto it = timers_.find(top.id);
+        if (it == timers_.end() || !it->second.armed || it->second.version != top.version) {
+            // Cancelled or rescheduled since it was pushed
+            std::pop_heap(heap_.begin(), heap_.end(), std::greater<HeapEntry>());
+            heap_.pop_back();
+            continue;
+        }
+        if (Clock::now() < top.due) {
+            wake_.wait_until(lock, top.due);
+            continue;
+        }
+
+        std::pop_heap(heap_.begin(), heap_.end(), std::greater<HeapEntry>());
+        heap_.pop_back();
+
+        // The entry may be cancelled while the callback runs, so run a
+        // moved-out copy and hand it back afterwards
+        it->second.armed = false;
+        std::function<void()> callback = std::move(it->second.callback);
+        running_ = top.id;
+        lock.unlock();
+        try {
+            callback();
+        } catch (...) {
+            // A failing callback must not take the scheduler down
+        }
+        lock.lock();
+        running_ = 0;
+        idle_.notify_all();
+
+        it = timers_.find(top.id);
+        if (it == timers_.end()) {
+            continue;
+        }
+        Timer& timer = it->second;
+        timer.callback = std::move(callback);
+        if (timer.armed) {
+            continue;   // Rescheduled by the callback
+        }
+        if (timer.period <= Clock::duration::zero()) {
+            timers_.erase(it);
+            continue;
+        }
+        Clock::time_point next = top.due + timer.period;
+        const Clock::time_point now = Clock::now();
+        if (next <= now) {
+            next += ((now - next) / timer.period + 1) * timer.period;
+        }
+        arm(top.id, timer, next);
+    }
+}
+
+} // namespace decentrilicense
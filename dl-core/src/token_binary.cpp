@@ -0,0 +1,651 @@
+#include "decentrilicense/token_manager.hpp"
+#include "decentrilicense/base64.hpp"
+#include <cstring>
+
+// Binary token encoding, version 2 (JSON being version 1)
+//
+//   header  = D1 'L' 'T' 02
+//   field   = tag:u8 length:varint value[length]
+//   tag     = id << 3 | form
+//
+// Integers (issue_time, expire_time, state_index, seq) are 8-byte big-endian.
+// alg is one byte: 1 RSA, 2 Ed25519, 3 SM2. device_info and each usage_chain
+// record are nested field lists. String fields pick the first form, in the
+// order below, that turns back into exactly the original text:
+//
+//   PemEd25519    PUBLIC KEY PEM block ending in "\n", Ed25519 key: the 32 raw key bytes
+//   Pem           PUBLIC KEY PEM block ending in "\n": the DER body
+//   PemNoNewline  Same without the final "\n"
+//   Hex           Lowercase hex, even length: the bytes
+//   Base64        Padded standard base64: the bytes
+//   Text          Anything else: the UTF-8 bytes
+//
+// The encoding is canonical: fields appear in ascending id order, at most
+// once (usage records excepted, which repeat in chain order), empty strings,
+// zero integers and an all-empty device_info are omitted, lengths are
+// minimal varints, and every string uses the form chosen above. from_binary
+// rejects anything to_binary would not produce, so equal tokens always have
+// equal encodings and the bytes can be hashed or signed directly.
+
+namespace decentrilicense {
+
+namespace {
+
+constexpr uint8_t kMagic[4] = {0xD1, 'L', 'T', 0x02};
+
+enum class Form : uint8_t {
+    Text = 0,
+    Base64 = 1,
+    Hex = 2,
+    Pem = 3,
+    PemNoNewline = 4,
+    PemEd25519 = 5
+};
+
+constexpr uint8_t kMaxForm = 5;
+
+// Top-level field ids
+enum : uint8_t {
+    kTokenId = 1,
+    kHolderDeviceId,
+    kLicenseCode,
+    kIssueTime,
+    kExpireTime,
+    kSignature,
+    kAlg,
+    kAppId,
+    kEnvironmentHash,
+    kLicensePublicKey,
+    kRootSignature,
+    kEncryptedLicensePrivateKey,
+    kStateIndex,
+    kPrevStateHash,
+    kStatePayload,
+    kStateSignature,
+    kDeviceInfo,
+    kUsageRecord,
+    kCurrentSignature
+};
+
+// device_info field ids
+enum : uint8_t {
+    kDeviceFingerprint = 1,
+    kDevicePublicKey,
+    kDeviceSignature
+};
+
+// usage record field ids
+enum : uint8_t {
+    kUsageSeq = 1,
+    kUsageTime,
+    kUsageAction,
+    kUsageParams,
+    kUsageHashPrev,
+    kUsageSignature
+};
+
+constexpr std::string_view kPemBegin = "-----BEGIN PUBLIC KEY-----\n";
+constexpr std::string_view kPemEnd = "-----END PUBLIC KEY-----";
+constexpr size_t kPemLineLength = 64;
+
+// SubjectPublicKeyInfo prefix of every Ed25519 public key
+constexpr uint8_t kEd25519SpkiPrefix[12] = {
+    0x30, 0x2a, 0x30, 0x05, 0x06, 0x03, 0x2b, 0x65, 0x70, 0x03, 0x21, 0x00
+};
+constexpr size_t kEd25519KeySize = 32;
+
+uint8_t alg_code(SigningAlgorithm algorithm) {
+    switch (algorithm) {
+        case SigningAlgorithm::RSA: return 1;
+        case SigningAlgorithm::Ed25519: return 2;
+        case SigningAlgorithm::SM2: return 3;
+    }
+    return 0;
+}
+
+std::optional<SigningAlgorithm> alg_from_code(uint8_t code) {
+    switch (code) {
+        case 1: return SigningAlgorithm::RSA;
+        case 2: return SigningAlgorithm::Ed25519;
+        case 3: return SigningAlgorithm::SM2;
+        default: return std::nullopt;
+    }
+}
+
+int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+bool decode_hex(std::string_view text, std::vector<uint8_t>& out) {
+    if (text.size() % 2 != 0) {
+        return false;
+    }
+    out.resize(text.size() / 2);
+    for (size_t i = 0; i < out.size(); i++) {
+        int hi = hex_digit(text[2 * i]);
+        int lo = hex_digit(text[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        out[i] = static_cast<uint8_t>(hi << 4 | lo);
+    }
+    return true;
+}
+
+bool is_base64_char(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+           c == '+' || c == '/';
+}
+
+int base64_value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    return c == '+' ? 62 : 63;
+}
+
+// Padded standard base64 that re-encodes to the same text: no whitespace
+// and zero padding bits
+bool is_canonical_base64(std::string_view text) {
+    if (text.empty() || text.size() % 4 != 0) {
+        return false;
+    }
+    size_t padding = 0;
+    if (text.back() == '=') {
+        padding = text[text.size() - 2] == '=' ? 2 : 1;
+    }
+    const size_t data_size = text.size() - padding;
+    for (size_t i = 0; i < data_size; i++) {
+        if (!is_base64_char(text[i])) {
+            return false;
+        }
+    }
+    if (padding == 0) {
+        return true;
+    }
+    // Unused low bits of the last character must be zero
+    const int last = base64_value(text[data_size - 1]);
+    return padding == 1 ? (last & 0x03) == 0 : (last & 0x0f) == 0;
+}
+
+bool decode_base64(std::string_view text, std::vector<uint8_t>& out) {
+    if (!is_canonical_base64(text)) {
+        return false;
+    }
+    out.resize(Base64::decoded_max_length(text.size()));
+    size_t size = 0;
+    if (!Base64::decode(text, out.data(), &size)) {
+        return false;
+    }
+    out.resize(size);
+    return true;
+}
+
+bool is_lower_hex(std::string_view text) {
+    if (text.empty() || text.size() % 2 != 0) {
+        return false;
+    }
+    for (char c : text) {
+        if (hex_digit(c) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void append_pem(std::string& text, const uint8_t* der, size_t size, bool newline) {
+    const std::string body = Base64::encode(der, size);
+    text.reserve(kPemBegin.size() + body.size() + body.size() / kPemLineLength + kPemEnd.size() + 2);
+    text.append(kPemBegin);
+    for (size_t pos = 0; pos < body.size(); pos += kPemLineLength) {
+        text.append(body, pos, kPemLineLength);
+        text.push_back('\n');
+    }
+    text.append(kPemEnd);
+    if (newline) {
+        text.push_back('\n');
+    }
+}
+
+// PUBLIC KEY PEM laid out exactly as append_pem writes it
+bool decode_pem(std::string_view text, std::vector<uint8_t>& out, bool* newline) {
+    if (text.substr(0, kPemBegin.size()) != kPemBegin) {
+        return false;
+    }
+    std::string_view rest = text.substr(kPemBegin.size());
+    *newline = !rest.empty() && rest.back() == '\n';
+    if (*newline) {
+        rest.remove_suffix(1);
+    }
+    if (rest.size() < kPemEnd.size() || rest.substr(rest.size() - kPemEnd.size()) != kPemEnd) {
+        return false;
+    }
+    rest.remove_suffix(kPemEnd.size());
+
+    std::string body;
+    body.reserve(rest.size());
+    while (!rest.empty()) {
+        size_t eol = rest.find('\n');
+        if (eol == std::string_view::npos || eol == 0 || eol > kPemLineLength) {
+            return false;
+        }
+        // Only the last line may be short
+        if (eol < kPemLineLength && eol + 1 != rest.size()) {
+            return false;
+        }
+        body.append(rest.substr(0, eol));
+        rest.remove_prefix(eol + 1);
+    }
+    return !body.empty() && decode_base64(body, out);
+}
+
+bool is_ed25519_spki(const std::vector<uint8_t>& der) {
+    return der.size() == sizeof(kEd25519SpkiPrefix) + kEd25519KeySize &&
+           std::memcmp(der.data(), kEd25519SpkiPrefix, sizeof(kEd25519SpkiPrefix)) == 0;
+}
+
+/**
+ * Pick the canonical form of a non-empty string
+ * @param text String value
+ * @param bytes Receives the encoded value (unused for Text)
+ */
+Form choose_form(std::string_view text, std::vector<uint8_t>& bytes) {
+    bool newline = false;
+    if (decode_pem(text, bytes, &newline)) {
+        if (newline && is_ed25519_spki(bytes)) {
+            bytes.erase(bytes.begin(), bytes.begin() + sizeof(kEd25519SpkiPrefix));
+            return Form::PemEd25519;
+        }
+        return newline ? Form::Pem : Form::PemNoNewline;
+    }
+    if (is_lower_hex(text) && decode_hex(text, bytes)) {
+        return Form::Hex;
+    }
+    if (decode_base64(text, bytes)) {
+        return Form::Base64;
+    }
+    return Form::Text;
+}
+
+bool expand_form(Form form, const uint8_t* value, size_t size, std::string& text) {
+    text.clear();
+    switch (form) {
+        case Form::Text:
+            text.assign(reinterpret_cast<const char*>(value), size);
+            return true;
+        case Form::Base64:
+            text.resize(Base64::encoded_length(size));
+            Base64::encode(value, size, &text[0]);
+            return true;
+        case Form::Hex: {
+            static const char kDigits[] = "0123456789abcdef";
+            text.resize(2 * size);
+            for (size_t i = 0; i < size; i++) {
+                text[2 * i] = kDigits[value[i] >> 4];
+                text[2 * i + 1] = kDigits[value[i] & 0x0f];
+            }
+            return true;
+        }
+        case Form::Pem:
+        case Form::PemNoNewline:
+            append_pem(text, value, size, form == Form::Pem);
+            return true;
+        case Form::PemEd25519: {
+            if (size != kEd25519KeySize) {
+                return false;
+            }
+            uint8_t der[sizeof(kEd25519SpkiPrefix) + kEd25519KeySize];
+            std::memcpy(der, kEd25519SpkiPrefix, sizeof(kEd25519SpkiPrefix));
+            std::memcpy(der + sizeof(kEd25519SpkiPrefix), value, size);
+            append_pem(text, der, sizeof(der), true);
+            return true;
+        }
+    }
+    return false;
+}
+
+class BinaryWriter {
+public:
+    explicit BinaryWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    void header() { out_.insert(out_.end(), kMagic, kMagic + sizeof(kMagic)); }
+
+    void field(uint8_t id, Form form, const uint8_t* value, size_t size) {
+        out_.push_back(static_cast<uint8_t>(id << 3 | static_cast<uint8_t>(form)));
+        varint(size);
+        out_.insert(out_.end(), value, value + size);
+    }
+
+    void string(uint8_t id, const std::string& text) {
+        if (text.empty()) {
+            return;
+        }
+        Form form = choose_form(text, scratch_);
+        if (form == Form::Text) {
+            field(id, form, reinterpret_cast<const uint8_t*>(text.data()), text.size());
+        } else {
+            field(id, form, scratch_.data(), scratch_.size());
+        }
+    }
+
+    void u64(uint8_t id, uint64_t value) {
+        if (value == 0) {
+            return;
+        }
+        uint8_t bytes[8];
+        for (int i = 7; i >= 0; i--) {
+            bytes[i] = static_cast<uint8_t>(value);
+            value >>= 8;
+        }
+        field(id, Form::Text, bytes, sizeof(bytes));
+    }
+
+    // Nested field list; fill() writes the nested fields
+    template <typename Fill>
+    void nested(uint8_t id, Fill&& fill) {
+        out_.push_back(static_cast<uint8_t>(id << 3));
+        const size_t start = out_.size();
+        fill();
+        // Insert the now known length in front of the body
+        uint8_t length[10];
+        size_t n = 0;
+        for (size_t value = out_.size() - start; ; value >>= 7) {
+            length[n++] = static_cast<uint8_t>(value >= 0x80 ? (value | 0x80) : value);
+            if (value < 0x80) {
+                break;
+            }
+        }
+        out_.insert(out_.begin() + start, length, length + n);
+    }
+
+private:
+    void varint(size_t value) {
+        while (value >= 0x80) {
+            out_.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out_.push_back(static_cast<uint8_t>(value));
+    }
+
+    std::vector<uint8_t>& out_;
+    std::vector<uint8_t> scratch_;
+};
+
+// Reads one field list and checks canonical order
+class BinaryReader {
+public:
+    BinaryReader(const uint8_t* data, size_t size) : p_(data), end_(data + size) {}
+
+    bool done() const { return p_ == end_; }
+
+    /**
+     * Read the next field
+     * @param repeatable Id that may repeat (0 if none)
+     */
+    bool next(uint8_t* id, Form* form, const uint8_t** value, size_t* size, uint8_t repeatable = 0) {
+        if (p_ == end_) {
+            return false;
+        }
+        const uint8_t tag = *p_++;
+        *id = tag >> 3;
+        const uint8_t f = tag & 0x07;
+        if (*id == 0 || f > kMaxForm) {
+            return false;
+        }
+        if (*id < last_id_ || (*id == last_id_ && *id != repeatable)) {
+            return false;
+        }
+        last_id_ = *id;
+        *form = static_cast<Form>(f);
+        if (!varint(size) || *size > static_cast<size_t>(end_ - p_)) {
+            return false;
+        }
+        *value = p_;
+        p_ += *size;
+        return true;
+    }
+
+private:
+    bool varint(size_t* value) {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 35 && p_ != end_; shift += 7) {
+            const uint8_t b = *p_++;
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                // Minimal: no trailing zero groups
+                if (b == 0 && shift > 0) {
+                    return false;
+                }
+                *value = static_cast<size_t>(v);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const uint8_t* p_;
+    const uint8_t* end_;
+    uint8_t last_id_ = 0;
+};
+
+bool read_string(Form form, const uint8_t* value, size_t size, std::string& text) {
+    if (size == 0 || !expand_form(form, value, size, text)) {
+        return false;
+    }
+    // Canonical: the writer would have chosen this form for this text
+    switch (form) {
+        case Form::Text: {
+            if (text.compare(0, kPemBegin.size(), kPemBegin) == 0) {
+                std::vector<uint8_t> der;
+                bool newline;
+                if (decode_pem(text, der, &newline)) {
+                    return false;
+                }
+            }
+            return !is_lower_hex(text) && !is_canonical_base64(text);
+        }
+        case Form::Base64:
+            return !is_lower_hex(text);
+        case Form::Pem:
+            return !(size == sizeof(kEd25519SpkiPrefix) + kEd25519KeySize &&
+                     std::memcmp(value, kEd25519SpkiPrefix, sizeof(kEd25519SpkiPrefix)) == 0);
+        case Form::Hex:
+        case Form::PemNoNewline:
+        case Form::PemEd25519:
+            return true;
+    }
+    return false;
+}
+
+bool read_string(Form form, const uint8_t* value, size_t size, SharedString& text) {
+    std::string expanded;
+    if (!read_string(form, value, size, expanded)) {
+        return false;
+    }
+    text = std::move(expanded);
+    return true;
+}
+
+bool read_u64(Form form, const uint8_t* value, size_t size, uint64_t& out) {
+    if (form != Form::Text || size != 8) {
+        return false;
+    }
+    uint64_t v = 0;
+    for (size_t i = 0; i < 8; i++) {
+        v = v << 8 | value[i];
+    }
+    out = v;
+    return v != 0;
+}
+
+bool read_device_info(const uint8_t* data, size_t size, Token::DeviceInfo& info) {
+    BinaryReader reader(data, size);
+    uint8_t id;
+    Form form;
+    const uint8_t* value;
+    size_t length;
+    while (!reader.done()) {
+        if (!reader.next(&id, &form, &value, &length)) {
+            return false;
+        }
+        bool ok = false;
+        switch (id) {
+            case kDeviceFingerprint: ok = read_string(form, value, length, info.fingerprint); break;
+            case kDevicePublicKey: ok = read_string(form, value, length, info.public_key); break;
+            case kDeviceSignature: ok = read_string(form, value, length, info.signature); break;
+            default: break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    // An all-empty device_info is written as no device_info at all
+    return size > 0;
+}
+
+bool read_usage_record(const uint8_t* data, size_t size, Token::UsageRecord& record) {
+    BinaryReader reader(data, size);
+    uint8_t id;
+    Form form;
+    const uint8_t* value;
+    size_t length;
+    while (!reader.done()) {
+        if (!reader.next(&id, &form, &value, &length)) {
+            return false;
+        }
+        bool ok = false;
+        switch (id) {
+            case kUsageSeq: ok = read_u64(form, value, length, record.seq); break;
+            case kUsageTime: ok = read_string(form, value, length, record.time); break;
+            case kUsageAction: ok = read_string(form, value, length, record.action); break;
+            case kUsageParams: ok = read_string(form, value, length, record.params); break;
+            case kUsageHashPrev: ok = read_string(form, value, length, record.hash_prev); break;
+            case kUsageSignature: ok = read_string(form, value, length, record.signature); break;
+            default: break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+std::vector<uint8_t> Token::to_binary() const {
+    std::vector<uint8_t> out;
+    out.reserve(json_size() / 2);
+    BinaryWriter writer(out);
+    writer.header();
+    writer.string(kTokenId, token_id);
+    writer.string(kHolderDeviceId, holder_device_id);
+    writer.string(kLicenseCode, license_code);
+    writer.u64(kIssueTime, issue_time);
+    writer.u64(kExpireTime, expire_time);
+    writer.string(kSignature, signature);
+    if (alg) {
+        const uint8_t code = alg_code(*alg);
+        writer.field(kAlg, Form::Text, &code, 1);
+    }
+    writer.string(kAppId, app_id);
+    writer.string(kEnvironmentHash, environment_hash);
+    writer.string(kLicensePublicKey, license_public_key);
+    writer.string(kRootSignature, root_signature);
+    writer.string(kEncryptedLicensePrivateKey, encrypted_license_private_key);
+    writer.u64(kStateIndex, state_index);
+    writer.string(kPrevStateHash, prev_state_hash);
+    writer.string(kStatePayload, state_payload);
+    writer.string(kStateSignature, state_signature);
+    if (!device_info.fingerprint.empty() || !device_info.public_key.empty() ||
+        !device_info.signature.empty()) {
+        writer.nested(kDeviceInfo, [&] {
+            writer.string(kDeviceFingerprint, device_info.fingerprint);
+            writer.string(kDevicePublicKey, device_info.public_key);
+            writer.string(kDeviceSignature, device_info.signature);
+        });
+    }
+    for (const UsageRecord& record : usage_chain) {
+        writer.nested(kUsageRecord, [&] {
+            writer.u64(kUsageSeq, record.seq);
+            writer.string(kUsageTime, record.time);
+            writer.string(kUsageAction, record.action);
+            writer.string(kUsageParams, record.params);
+            writer.string(kUsageHashPrev, record.hash_prev);
+            writer.string(kUsageSignature, record.signature);
+        });
+    }
+    writer.string(kCurrentSignature, current_signature);
+    return out;
+}
+
+bool Token::is_binary(const uint8_t* data, size_t size) {
+    return size >= sizeof(kMagic) && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool Token::from_binary(const uint8_t* data, size_t size, Token* token) {
+    if (!is_binary(data, size)) {
+        return false;
+    }
+    Token parsed{};
+    BinaryReader reader(data + sizeof(kMagic), size - sizeof(kMagic));
+    uint8_t id;
+    Form form;
+    const uint8_t* value;
+    size_t length;
+    while (!reader.done()) {
+        if (!reader.next(&id, &form, &value, &length, kUsageRecord)) {
+            return false;
+        }
+        bool ok = false;
+        switch (id) {
+            case kTokenId: ok = read_string(form, value, length, parsed.token_id); break;
+            case kHolderDeviceId: ok = read_string(form, value, length, parsed.holder_device_id); break;
+            case kLicenseCode: ok = read_string(form, value, length, parsed.license_code); break;
+            case kIssueTime: ok = read_u64(form, value, length, parsed.issue_time); break;
+            case kExpireTime: ok = read_u64(form, value, length, parsed.expire_time); break;
+            case kSignature: ok = read_string(form, value, length, parsed.signature); break;
+            case kAlg:
+                parsed.alg = length == 1 && form == Form::Text ? alg_from_code(value[0]) : std::nullopt;
+                ok = parsed.alg.has_value();
+                break;
+            case kAppId: ok = read_string(form, value, length, parsed.app_id); break;
+            case kEnvironmentHash: ok = read_string(form, value, length, parsed.environment_hash); break;
+            case kLicensePublicKey: ok = read_string(form, value, length, parsed.license_public_key); break;
+            case kRootSignature: ok = read_string(form, value, length, parsed.root_signature); break;
+            case kEncryptedLicensePrivateKey:
+                ok = read_string(form, value, length, parsed.encrypted_license_private_key);
+                break;
+            case kStateIndex: ok = read_u64(form, value, length, parsed.state_index); break;
+            case kPrevStateHash: ok = read_string(form, value, length, parsed.prev_state_hash); break;
+            case kStatePayload: ok = read_string(form, value, length, parsed.state_payload); break;
+            case kStateSignature: ok = read_string(form, value, length, parsed.state_signature); break;
+            case kDeviceInfo:
+                ok = form == Form::Text && read_device_info(value, length, parsed.device_info);
+                break;
+            case kUsageRecord:
+                parsed.usage_chain.emplace_back();
+                ok = form == Form::Text &&
+                     read_usage_record(value, length, parsed.usage_chain.back());
+                break;
+            case kCurrentSignature: ok = read_string(form, value, length, parsed.current_signature); break;
+            default: break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    *token = std::move(parsed);
+    return true;
+}
+
+bool Token::decode(std::string_view data, Token* token) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data());
+    if (is_binary(bytes, data.size())) {
+        return from_binary(bytes, data.size(), token);
+    }
+    return from_json(data, token);
+}
+
+} // namespace decentrilicense
@@ -0,0 +1,154 @@
+#include "decentrilicense/token_cipher.hpp"
+#include "decentrilicense/base64.hpp"
+#include "decentrilicense/hasher.hpp"
+#include "decentrilicense/root_key.hpp"
+#include "crypto_context.hpp"
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace decentrilicense {
+
+namespace {
+
+void free_contexts(EVP_CIPHER_CTX* a, EVP_CIPHER_CTX* b) {
+    EVP_CIPHER_CTX_free(a);
+    EVP_CIPHER_CTX_free(b);
+}
+
+} // namespace
+
+TokenCipher::TokenCipher(const Key& key)
+    : encrypt_ctx_(EVP_CIPHER_CTX_new()),
+      decrypt_ctx_(EVP_CIPHER_CTX_new()) {
+    if (!encrypt_ctx_ || !decrypt_ctx_) {
+        free_contexts(encrypt_ctx_, decrypt_ctx_);
+        throw std::runtime_error("failed to create cipher context");
+    }
+
+    // Set the cipher and key once; each message only supplies its nonce.
+    // Sessions are long-lived and typically thread-local, so they use the
+    // default library context like Hasher does.
+    const EVP_CIPHER* cipher = AlgorithmSet::global().aes_256_gcm();
+    if (EVP_EncryptInit_ex(encrypt_ctx_, cipher, nullptr, key.data(), nullptr) != 1 ||
+        EVP_DecryptInit_ex(decrypt_ctx_, cipher, nullptr, key.data(), nullptr) != 1) {
+        free_contexts(encrypt_ctx_, decrypt_ctx_);
+        throw std::runtime_error("failed to init aes-256-gcm");
+    }
+}
+
+TokenCipher::~TokenCipher() {
+    free_contexts(encrypt_ctx_, decrypt_ctx_);
+}
+
+const TokenCipher::Key& TokenCipher::token_key() {
+    // dl-issuer derives the token key from the root public key PEM
+    static const Key key = Hasher::digest(Hasher::Algorithm::SHA256, ROOT_PUBLIC_KEY);
+    return key;
+}
+
+std::string TokenCipher::encrypt(std::string_view plaintext) {
+    uint8_t nonce[kNonceSize];
+    if (RAND_bytes(nonce, static_cast<int>(sizeof(nonce))) != 1) {
+        throw std::runtime_error("failed to generate nonce");
+    }
+    if (EVP_EncryptInit_ex(encrypt_ctx_, nullptr, nullptr, nullptr, nonce) != 1) {
+        throw std::runtime_error("failed to set key/nonce");
+    }
+
+    // ciphertext || tag, encoded in one go
+    std::vector<uint8_t> sealed(plaintext.size() + kTagSize);
+    int out_len = 0;
+    if (EVP_EncryptUpdate(encrypt_ctx_, sealed.data(), &out_len,
+                          reinterpret_cast<const uint8_t*>(plaintext.data()),
+                          static_cast<int>(plaintext.size())) != 1) {
+        throw std::runtime_error("failed to encrypt");
+    }
+    size_t total_len = static_cast<size_t>(out_len);
+    if (EVP_EncryptFinal_ex(encrypt_ctx_, sealed.data() + total_len, &out_len) != 1) {
+        throw std::runtime_error("failed to finalize encrypt");
+    }
+    total_len += static_cast<size_t>(out_len);
+    if (EVP_CIPHER_CTX_ctrl(encrypt_ctx_, EVP_CTRL_GCM_GET_TAG, static_cast<int>(kTagSize),
+                            sealed.data() + total_len) != 1) {
+        throw std::runtime_error("failed to get tag");
+    }
+    total_len += kTagSize;
+
+    const size_t sealed_chars = Base64::encoded_length(total_len, Base64::Alphabet::Url);
+    const size_t nonce_chars = Base64::encoded_length(kNonceSize, Base64::Alphabet::Url);
+    std::string result(sealed_chars + 1 + nonce_chars, '\0');
+    Base64::encode(sealed.data(), total_len, &result[0], Base64::Alphabet::Url);
+    result[sealed_chars] = '|';
+    Base64::encode(nonce, kNonceSize, &result[sealed_chars + 1], Base64::Alphabet::Url);
+    return result;
+}
+
+size_t TokenCipher::decrypt_buffer_size(std::string_view encrypted) {
+    const size_t sep = encrypted.find('|');
+    if (sep == std::string_view::npos) {
+        return 0;
+    }
+    return Base64::decoded_max_length(sep);
+}
+
+size_t TokenCipher::decrypt(std::string_view encrypted, uint8_t* out, size_t out_capacity) {
+    const size_t sep = encrypted.find('|');
+    if (sep == std::string_view::npos) {
+        throw std::runtime_error("invalid encrypted token format");
+    }
+    const std::string_view sealed_b64u = encrypted.substr(0, sep);
+    const std::string_view nonce_b64u = encrypted.substr(sep + 1);
+
+    uint8_t nonce[kNonceSize + 3];
+    size_t nonce_len = 0;
+    if (Base64::decoded_max_length(nonce_b64u.size()) > sizeof(nonce) ||
+        !Base64::decode(nonce_b64u, nonce, &nonce_len, Base64::Alphabet::Url) ||
+        nonce_len != kNonceSize) {
+        throw std::runtime_error("invalid nonce length");
+    }
+
+    if (!out || out_capacity < Base64::decoded_max_length(sealed_b64u.size())) {
+        throw std::runtime_error("output buffer too small");
+    }
+    size_t sealed_len = 0;
+    if (!Base64::decode(sealed_b64u, out, &sealed_len, Base64::Alphabet::Url) ||
+        sealed_len < kTagSize) {
+        throw std::runtime_error("invalid ciphertext length");
+    }
+
+    const size_t ct_len = sealed_len - kTagSize;
+    uint8_t tag[kTagSize];
+    std::memcpy(tag, out + ct_len, kTagSize);
+
+    // Decrypt in place; GCM allows the output to alias the input
+    int out_len = 0;
+    if (EVP_DecryptInit_ex(decrypt_ctx_, nullptr, nullptr, nullptr, nonce) != 1) {
+        throw std::runtime_error("failed to set key/nonce");
+    }
+    if (EVP_DecryptUpdate(decrypt_ctx_, out, &out_len, out, static_cast<int>(ct_len)) != 1) {
+        throw std::runtime_error("failed to decrypt");
+    }
+    size_t total_len = static_cast<size_t>(out_len);
+    if (EVP_CIPHER_CTX_ctrl(decrypt_ctx_, EVP_CTRL_GCM_SET_TAG, static_cast<int>(kTagSize), tag) != 1) {
+        throw std::runtime_error("failed to set tag");
+    }
+    if (EVP_DecryptFinal_ex(decrypt_ctx_, out + total_len, &out_len) != 1) {
+        // Do not leave unauthenticated plaintext in the caller's buffer
+        OPENSSL_cleanse(out, sealed_len);
+        throw std::runtime_error("gcm tag verification failed");
+    }
+    total_len += static_cast<size_t>(out_len);
+    return total_len;
+}
+
+std::string TokenCipher::decrypt(std::string_view encrypted) {
+    std::string plaintext(decrypt_buffer_size(encrypted), '\0');
+    const size_t size = decrypt(encrypted, reinterpret_cast<uint8_t*>(&plaintext[0]), plaintext.size());
+    plaintext.resize(size);
+    return plaintext;
+}
+
+} // namespace decentrilicense
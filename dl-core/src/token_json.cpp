@@ -0,0 +1,593 @@
+#include "decentrilicense/token_json.hpp"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define DL_TOKEN_JSON_X86 1
+#include <immintrin.h>
+#endif
+
+namespace decentrilicense {
+
+namespace {
+
+// Nesting limit for skipped values, keeps hostile input off the stack
+constexpr int kMaxDepth = 64;
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Four hex digits at s[pos], as in \uXXXX
+bool read_hex4(std::string_view s, size_t pos, uint32_t* value) {
+    if (pos + 4 > s.size()) {
+        return false;
+    }
+    uint32_t v = 0;
+    for (size_t i = 0; i < 4; i++) {
+        int h = hex_value(s[pos + i]);
+        if (h < 0) {
+            return false;
+        }
+        v = (v << 4) | static_cast<uint32_t>(h);
+    }
+    *value = v;
+    return true;
+}
+
+void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+// Forward-only reader over a JSON document
+class JsonCursor {
+public:
+    explicit JsonCursor(std::string_view json) : json_(json) {}
+
+    // Next non-whitespace character, or '\0' at the end
+    char peek() {
+        while (pos_ < json_.size() && is_space(json_[pos_])) {
+            pos_++;
+        }
+        return pos_ < json_.size() ? json_[pos_] : '\0';
+    }
+
+    bool consume(char c) {
+        if (peek() != c) {
+            return false;
+        }
+        pos_++;
+        return true;
+    }
+
+    bool at_end() {
+        return peek() == '\0' && pos_ == json_.size();
+    }
+
+    bool read_string(JsonString& out) {
+        if (!consume('"')) {
+            return false;
+        }
+        size_t start = pos_;
+        bool escaped = false;
+        while (pos_ < json_.size()) {
+            char c = json_[pos_];
+            if (c == '"') {
+                out.raw = json_.substr(start, pos_ - start);
+                out.escaped = escaped;
+                pos_++;
+                return true;
+            }
+            if (c == '\\') {
+                escaped = true;
+                pos_ += 2;
+                continue;
+            }
+            pos_++;
+        }
+        return false;
+    }
+
+    /**
+     * Read a JSON number
+     * @param out Set to the value if it is a non-negative integer that fits
+     *            in 64 bits, otherwise to 0
+     * @return false if the input is not a number
+     */
+    bool read_u64(uint64_t& out) {
+        peek();
+        size_t start = pos_;
+        bool representable = true;
+        if (pos_ < json_.size() && json_[pos_] == '-') {
+            representable = false;
+            pos_++;
+        }
+        uint64_t value = 0;
+        size_t digits = pos_;
+        while (pos_ < json_.size() && is_digit(json_[pos_])) {
+            uint64_t d = static_cast<uint64_t>(json_[pos_] - '0');
+            if (value > (std::numeric_limits<uint64_t>::max() - d) / 10) {
+                representable = false;
+            }
+            value = value * 10 + d;
+            pos_++;
+        }
+        if (pos_ == digits) {
+            pos_ = start;
+            return false;
+        }
+        if (pos_ < json_.size() && json_[pos_] == '.') {
+            representable = false;
+            pos_++;
+            if (!skip_digits()) {
+                return false;
+            }
+        }
+        if (pos_ < json_.size() && (json_[pos_] == 'e' || json_[pos_] == 'E')) {
+            representable = false;
+            pos_++;
+            if (pos_ < json_.size() && (json_[pos_] == '+' || json_[pos_] == '-')) {
+                pos_++;
+            }
+            if (!skip_digits()) {
+                return false;
+            }
+        }
+        out = representable ? value : 0;
+        return true;
+    }
+
+    /**
+     * Read an object, calling member(key) after each "key": so that it
+     * reads the value
+     */
+    template <typename Member>
+    bool read_object(Member&& member) {
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            JsonString key;
+            if (!read_string(key) || !consume(':')) {
+                return false;
+            }
+            if (key.escaped) {
+                std::string name = key.str();
+                if (!member(std::string_view(name))) {
+                    return false;
+                }
+            } else if (!member(key.raw)) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}');
+    }
+
+    // Read an array, calling element() to read each element
+    template <typename Element>
+    bool read_array(Element&& element) {
+        if (!consume('[')) {
+            return false;
+        }
+        if (consume(']')) {
+            return true;
+        }
+        do {
+            if (!element()) {
+                return false;
+            }
+        } while (consume(','));
+        return consume(']');
+    }
+
+    bool skip_value(int depth = 0) {
+        if (depth > kMaxDepth) {
+            return false;
+        }
+        switch (peek()) {
+            case '"': {
+                JsonString ignored;
+                return read_string(ignored);
+            }
+            case '{':
+                return read_object([&](std::string_view) { return skip_value(depth + 1); });
+            case '[':
+                return read_array([&] { return skip_value(depth + 1); });
+            case 't':
+                return consume_literal("true");
+            case 'f':
+                return consume_literal("false");
+            case 'n':
+                return consume_literal("null");
+            default: {
+                uint64_t ignored;
+                return read_u64(ignored);
+            }
+        }
+    }
+
+    // Read a string member, or skip a value of another type
+    bool read_field(JsonString& out) {
+        return peek() == '"' ? read_string(out) : skip_value();
+    }
+
+    // Read a number member, or skip a value of another type
+    bool read_field(uint64_t& out) {
+        char c = peek();
+        return (c == '-' || is_digit(c)) ? read_u64(out) : skip_value();
+    }
+
+private:
+    bool skip_digits() {
+        size_t start = pos_;
+        while (pos_ < json_.size() && is_digit(json_[pos_])) {
+            pos_++;
+        }
+        return pos_ != start;
+    }
+
+    bool consume_literal(std::string_view literal) {
+        if (json_.substr(pos_, literal.size()) != literal) {
+            return false;
+        }
+        pos_ += literal.size();
+        return true;
+    }
+
+    std::string_view json_;
+    size_t pos_ = 0;
+};
+
+// Tracks which known members were seen, to reject duplicates
+class SeenSet {
+public:
+    bool first(unsigned bit) {
+        uint32_t mask = uint32_t(1) << bit;
+        if (seen_ & mask) {
+            return false;
+        }
+        seen_ |= mask;
+        return true;
+    }
+
+private:
+    uint32_t seen_ = 0;
+};
+
+struct StringMember {
+    std::string_view name;
+    JsonString TokenJsonView::* field;
+};
+
+struct NumberMember {
+    std::string_view name;
+    uint64_t TokenJsonView::* field;
+};
+
+constexpr StringMember kStringMembers[] = {
+    {"token_id", &TokenJsonView::token_id},
+    {"holder_device_id", &TokenJsonView::holder_device_id},
+    {"license_code", &TokenJsonView::license_code},
+    {"signature", &TokenJsonView::signature},
+    {"alg", &TokenJsonView::alg},
+    {"app_id", &TokenJsonView::app_id},
+    {"environment_hash", &TokenJsonView::environment_hash},
+    {"license_public_key", &TokenJsonView::license_public_key},
+    {"root_signature", &TokenJsonView::root_signature},
+    {"encrypted_license_private_key", &TokenJsonView::encrypted_license_private_key},
+    {"prev_state_hash", &TokenJsonView::prev_state_hash},
+    {"state_payload", &TokenJsonView::state_payload},
+    {"state_signature", &TokenJsonView::state_signature},
+    {"current_signature", &TokenJsonView::current_signature},
+};
+
+constexpr NumberMember kNumberMembers[] = {
+    {"issue_time", &TokenJsonView::issue_time},
+    {"expire_time", &TokenJsonView::expire_time},
+    {"state_index", &TokenJsonView::state_index},
+};
+
+constexpr unsigned kNumberBit = sizeof(kStringMembers) / sizeof(kStringMembers[0]);
+constexpr unsigned kDeviceInfoBit = kNumberBit + sizeof(kNumberMembers) / sizeof(kNumberMembers[0]);
+constexpr unsigned kUsageChainBit = kDeviceInfoBit + 1;
+static_assert(kUsageChainBit < 32, "SeenSet holds 32 members");
+
+bool read_device_info(JsonCursor& cursor, TokenJsonView::DeviceInfo& info) {
+    SeenSet seen;
+    return cursor.read_object([&](std::string_view key) {
+        if (key == "fingerprint") {
+            return seen.first(0) && cursor.read_field(info.fingerprint);
+        }
+        if (key == "public_key") {
+            return seen.first(1) && cursor.read_field(info.public_key);
+        }
+        if (key == "signature") {
+            return seen.first(2) && cursor.read_field(info.signature);
+        }
+        return cursor.skip_value(2);
+    });
+}
+
+bool read_usage_record(JsonCursor& cursor, TokenJsonView::UsageRecord& record) {
+    SeenSet seen;
+    return cursor.read_object([&](std::string_view key) {
+        if (key == "seq") {
+            return seen.first(0) && cursor.read_field(record.seq);
+        }
+        if (key == "time") {
+            return seen.first(1) && cursor.read_field(record.time);
+        }
+        if (key == "action") {
+            return seen.first(2) && cursor.read_field(record.action);
+        }
+        if (key == "params") {
+            return seen.first(3) && cursor.read_field(record.params);
+        }
+        if (key == "hash_prev") {
+            return seen.first(4) && cursor.read_field(record.hash_prev);
+        }
+        if (key == "signature") {
+            return seen.first(5) && cursor.read_field(record.signature);
+        }
+        return cursor.skip_value(3);
+    });
+}
+
+bool read_usage_chain(JsonCursor& cursor, std::vector<TokenJsonView::UsageRecord>& chain) {
+    return cursor.read_array([&] {
+        if (cursor.peek() != '{') {
+            return cursor.skip_value(2);
+        }
+        chain.emplace_back();
+        return read_usage_record(cursor, chain.back());
+    });
+}
+
+// Escaping: kernels return the offset of the first byte that needs a
+// backslash, or size if there is none
+using FindEscapeKernel = size_t (*)(const char* s, size_t size);
+
+constexpr std::array<char, 256> make_escape_table() {
+    std::array<char, 256> table{};
+    table[static_cast<unsigned char>('"')] = '"';
+    table[static_cast<unsigned char>('\\')] = '\\';
+    table[static_cast<unsigned char>('\n')] = 'n';
+    table[static_cast<unsigned char>('\r')] = 'r';
+    table[static_cast<unsigned char>('\t')] = 't';
+    return table;
+}
+
+// Character written after the backslash, or 0 if the byte is copied as is
+constexpr std::array<char, 256> kEscapeTable = make_escape_table();
+
+size_t find_escape_scalar(const char* s, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (kEscapeTable[static_cast<unsigned char>(s[i])]) {
+            return i;
+        }
+    }
+    return size;
+}
+
+#ifdef DL_TOKEN_JSON_X86
+
+__attribute__((target("sse2")))
+size_t find_escape_sse2(const char* s, size_t size) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        const __m128i hit = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, tab), _mm_cmpeq_epi8(v, newline)),
+                         _mm_cmpeq_epi8(v, cr)));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+        if (mask) {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    return i + find_escape_scalar(s + i, size - i);
+}
+
+__attribute__((target("avx2")))
+size_t find_escape_avx2(const char* s, size_t size) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        const __m256i hit = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, tab), _mm256_cmpeq_epi8(v, newline)),
+                            _mm256_cmpeq_epi8(v, cr)));
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+        if (mask) {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    return i + find_escape_scalar(s + i, size - i);
+}
+
+#endif // DL_TOKEN_JSON_X86
+
+struct EscapeKernels {
+    FindEscapeKernel find;
+    const char* name;
+};
+
+EscapeKernels select_escape_kernels() {
+#ifdef DL_TOKEN_JSON_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return EscapeKernels{find_escape_avx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return EscapeKernels{find_escape_sse2, "sse2"};
+    }
+#endif
+    return EscapeKernels{find_escape_scalar, "scalar"};
+}
+
+const EscapeKernels& escape_kernels() {
+    static const EscapeKernels selected = select_escape_kernels();
+    return selected;
+}
+
+} // namespace
+
+std::string JsonString::str() const {
+    if (!escaped) {
+        return std::string(raw);
+    }
+
+    std::string out;
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); i++) {
+        char c = raw[i];
+        if (c != '\\' || i + 1 >= raw.size()) {
+            out.push_back(c);
+            continue;
+        }
+        char n = raw[++i];
+        switch (n) {
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                uint32_t cp;
+                if (!read_hex4(raw, i + 1, &cp)) {
+                    out.push_back('u');
+                    break;
+                }
+                i += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    uint32_t low;
+                    if (i + 2 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u' &&
+                        read_hex4(raw, i + 3, &low) && low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    } else {
+                        cp = 0xFFFD;
+                    }
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    cp = 0xFFFD;
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default: out.push_back(n); break;
+        }
+    }
+    return out;
+}
+
+size_t json_escaped_size(std::string_view s) {
+    const FindEscapeKernel find = escape_kernels().find;
+    size_t size = s.size();
+    size_t pos = 0;
+    while (pos < s.size()) {
+        pos += find(s.data() + pos, s.size() - pos);
+        if (pos < s.size()) {
+            size++;
+            pos++;
+        }
+    }
+    return size;
+}
+
+char* json_escape_to(std::string_view s, char* out) {
+    const FindEscapeKernel find = escape_kernels().find;
+    size_t pos = 0;
+    while (pos < s.size()) {
+        const size_t run = find(s.data() + pos, s.size() - pos);
+        std::memcpy(out, s.data() + pos, run);
+        out += run;
+        pos += run;
+        if (pos < s.size()) {
+            *out++ = '\\';
+            *out++ = kEscapeTable[static_cast<unsigned char>(s[pos])];
+            pos++;
+        }
+    }
+    return out;
+}
+
+const char* json_escape_implementation() {
+    return escape_kernels().name;
+}
+
+bool parse_token_json(std::string_view json, TokenJsonView& view) {
+    view = TokenJsonView();
+    JsonCursor cursor(json);
+    SeenSet seen;
+
+    bool ok = cursor.read_object([&](std::string_view key) {
+        for (unsigned i = 0; i < kNumberBit; i++) {
+            if (key == kStringMembers[i].name) {
+                return seen.first(i) && cursor.read_field(view.*kStringMembers[i].field);
+            }
+        }
+        for (unsigned i = 0; i < kDeviceInfoBit - kNumberBit; i++) {
+            if (key == kNumberMembers[i].name) {
+                return seen.first(kNumberBit + i) && cursor.read_field(view.*kNumberMembers[i].field);
+            }
+        }
+        if (key == "device_info") {
+            if (!seen.first(kDeviceInfoBit)) {
+                return false;
+            }
+            return cursor.peek() == '{' ? read_device_info(cursor, view.device_info)
+                                        : cursor.skip_value(1);
+        }
+        if (key == "usage_chain") {
+            if (!seen.first(kUsageChainBit)) {
+                return false;
+            }
+            return cursor.peek() == '[' ? read_usage_chain(cursor, view.usage_chain)
+                                        : cursor.skip_value(1);
+        }
+        return cursor.skip_value(1);
+    });
+    return ok && cursor.at_end();
+}
+
+} // namespace decentrilicense
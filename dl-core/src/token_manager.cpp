@@ -1,4 +1,7 @@
 #include "decentrilicense/token_manager.hpp"
+#include "decentrilicense/trust_anchor_store.hpp"
+#include "decentrilicense/token_json.hpp"
+#include "json_writer.hpp"
 #include "decentrilicense/crypto_utils.hpp"
 #include "decentrilicense/root_key.hpp"
 #include <sstream>
@@ -23,6 +26,23 @@ static void debugHashAndData(const std::string& data, const std::string& label);
 
 namespace decentrilicense {
 
+// Sign/verify a token field: raw signatures internally, base64 only in the JSON
+static std::string sign_field(SigningAlgorithm algorithm, const std::string& data,
+                              const std::string& private_key_pem) {
+    KeyHandle key = KeyCache::instance().get_private_key(private_key_pem);
+    return CryptoUtils::sign(algorithm, key, data).to_base64();
+}
+
+static bool verify_field(SigningAlgorithm algorithm, const std::string& data,
+                         const std::string& signature, const std::string& public_key_pem) {
+    RawSignature raw;
+    if (!RawSignature::from_base64(signature, &raw)) {
+        return false;
+    }
+    KeyHandle key = KeyCache::instance().get_public_key(public_key_pem);
+    return CryptoUtils::verify(algorithm, key, data, raw);
+}
+
 static std::string trim_pem(const std::string& s) {
     size_t start = 0;
     while (start < s.size() && (s[start] == ' ' || s[start] == '\t' || s[start] == '\r' || s[start] == '\n')) start++;
@@ -31,121 +51,9 @@ static std::string trim_pem(const std::string& s) {
     return s.substr(start, end - start);
 }
 
-static std::string json_escape_tm(const std::string& s) {
-    std::string out;
-    out.reserve(s.size() + 16);
-    for (char c : s) {
-        switch (c) {
-            case '\\': out += "\\\\"; break;
-            case '"': out += "\\\""; break;
-            case '\n': out += "\\n"; break;
-            case '\r': out += "\\r"; break;
-            case '\t': out += "\\t"; break;
-            default: out.push_back(c); break;
-        }
-    }
-    return out;
-}
-
-static std::string json_unescape_tm(const std::string& s) {
-    std::string out;
-    out.reserve(s.size());
-    for (size_t i = 0; i < s.size(); i++) {
-        char c = s[i];
-        if (c == '\\' && i + 1 < s.size()) {
-            char n = s[i + 1];
-            if (n == 'n') {
-                out.push_back('\n');
-                i++;
-                continue;
-            }
-            if (n == 'r') {
-                out.push_back('\r');
-                i++;
-                continue;
-            }
-            if (n == 't') {
-                out.push_back('\t');
-                i++;
-                continue;
-            }
-            out.push_back(n);
-            i++;
-            continue;
-        }
-        out.push_back(c);
-    }
-    return out;
-}
-
-static std::string extract_json_string_tm(const std::string& json, const std::string& key) {
-    const std::string pat = "\"" + key + "\"";
-    size_t p = json.find(pat);
-    if (p == std::string::npos) {
-        return "";
-    }
-    p = json.find(':', p + pat.size());
-    if (p == std::string::npos) {
-        return "";
-    }
-    p++;
-    while (p < json.size() && (json[p] == ' ' || json[p] == '\t' || json[p] == '\n' || json[p] == '\r')) {
-        p++;
-    }
-    if (p >= json.size() || json[p] != '"') {
-        return "";
-    }
-    p++;
-    std::string out;
-    for (; p < json.size(); p++) {
-        char c = json[p];
-        if (c == '\\') {
-            if (p + 1 < json.size()) {
-                out.push_back('\\');
-                out.push_back(json[p + 1]);
-                p++;
-                continue;
-            }
-        }
-        if (c == '"') {
-            break;
-        }
-        out.push_back(c);
-    }
-    return json_unescape_tm(out);
-}
-
-static uint64_t extract_json_u64_tm(const std::string& json, const std::string& key) {
-    const std::string pat = "\"" + key + "\"";
-    size_t p = json.find(pat);
-    if (p == std::string::npos) {
-        return 0;
-    }
-    p = json.find(':', p + pat.size());
-    if (p == std::string::npos) {
-        return 0;
-    }
-    p++;
-    while (p < json.size() && (json[p] == ' ' || json[p] == '\t' || json[p] == '\n' || json[p] == '\r')) {
-        p++;
-    }
-    size_t e = p;
-    while (e < json.size() && (json[e] == '-' || (json[e] >= '0' && json[e] <= '9'))) {
-        e++;
-    }
-    if (e == p) {
-        return 0;
-    }
-    try {
-        return static_cast<uint64_t>(std::stoull(json.substr(p, e - p)));
-    } catch (...) {
-        return 0;
-    }
-}
-
 // Token implementation
 bool Token::is_valid() const {
-    return !token_id.empty() && !signature.empty() && !alg.empty();
+    return !token_id.empty() && !signature.empty() && alg.has_value();
 }
 
 bool Token::is_expired() const {
@@ -154,151 +62,164 @@ bool Token::is_expired() const {
     return now > expire_time;
 }
 
-std::string Token::to_json() const {
-    std::ostringstream oss;
-    oss << "{";
-    oss << "\"token_id\":\"" << json_escape_tm(token_id) << "\",";
-    oss << "\"holder_device_id\":\"" << json_escape_tm(holder_device_id) << "\",";
-    oss << "\"license_code\":\"" << json_escape_tm(license_code) << "\",";
-    oss << "\"issue_time\":" << issue_time << ",";
-    oss << "\"expire_time\":" << expire_time << ",";
-    oss << "\"signature\":\"" << json_escape_tm(signature) << "\",";
-    oss << "\"alg\":\"" << json_escape_tm(alg) << "\",";
-    oss << "\"app_id\":\"" << json_escape_tm(app_id) << "\",";
-    oss << "\"environment_hash\":\"" << json_escape_tm(environment_hash) << "\",";
-    oss << "\"license_public_key\":\"" << json_escape_tm(license_public_key) << "\",";
-    oss << "\"root_signature\":\"" << json_escape_tm(root_signature) << "\",";
-    oss << "\"encrypted_license_private_key\":\"" << json_escape_tm(encrypted_license_private_key) << "\",";
-    oss << "\"state_index\":" << state_index << ",";
-    oss << "\"prev_state_hash\":\"" << json_escape_tm(prev_state_hash) << "\",";
-    oss << "\"state_payload\":\"" << json_escape_tm(state_payload) << "\",";
-    oss << "\"state_signature\":\"" << json_escape_tm(state_signature) << "\"";
-    
+// Field order and escaping are fixed: chains hash this output
+template <typename Writer>
+static void write_token_json(const Token& token, Writer& out) {
+    out.literal("{\"token_id\":\"");
+    out.escaped(token.token_id);
+    out.literal("\",\"holder_device_id\":\"");
+    out.escaped(token.holder_device_id);
+    out.literal("\",\"license_code\":\"");
+    out.escaped(token.license_code);
+    out.literal("\",\"issue_time\":");
+    out.number(token.issue_time);
+    out.literal(",\"expire_time\":");
+    out.number(token.expire_time);
+    out.literal(",\"signature\":\"");
+    out.escaped(token.signature);
+    out.literal("\",\"alg\":\"");
+    out.literal(token.alg ? signing_algorithm_name(*token.alg) : "");
+    out.literal("\",\"app_id\":\"");
+    out.escaped(token.app_id);
+    out.literal("\",\"environment_hash\":\"");
+    out.escaped(token.environment_hash);
+    out.literal("\",\"license_public_key\":\"");
+    out.escaped(token.license_public_key);
+    out.literal("\",\"root_signature\":\"");
+    out.escaped(token.root_signature);
+    out.literal("\",\"encrypted_license_private_key\":\"");
+    out.escaped(token.encrypted_license_private_key);
+    out.literal("\",\"state_index\":");
+    out.number(token.state_index);
+    out.literal(",\"prev_state_hash\":\"");
+    out.escaped(token.prev_state_hash);
+    out.literal("\",\"state_payload\":\"");
+    out.escaped(token.state_payload);
+    out.literal("\",\"state_signature\":\"");
+    out.escaped(token.state_signature);
+    out.literal("\"");
+
     // Add device info if present
-    if (!device_info.fingerprint.empty() || !device_info.public_key.empty() || !device_info.signature.empty()) {
-        oss << ",\"device_info\":{";
-        oss << "\"fingerprint\":\"" << json_escape_tm(device_info.fingerprint) << "\",";
-        oss << "\"public_key\":\"" << json_escape_tm(device_info.public_key) << "\",";
-        oss << "\"signature\":\"" << json_escape_tm(device_info.signature) << "\"";
-        oss << "}";
+    const Token::DeviceInfo& device = token.device_info;
+    if (!device.fingerprint.empty() || !device.public_key.empty() || !device.signature.empty()) {
+        out.literal(",\"device_info\":{\"fingerprint\":\"");
+        out.escaped(device.fingerprint);
+        out.literal("\",\"public_key\":\"");
+        out.escaped(device.public_key);
+        out.literal("\",\"signature\":\"");
+        out.escaped(device.signature);
+        out.literal("\"}");
     }
-    
+
     // Add usage chain if present
-    if (!usage_chain.empty()) {
-        oss << ",\"usage_chain\":[";
-        for (size_t i = 0; i < usage_chain.size(); ++i) {
-            if (i > 0) oss << ",";
-            oss << "{";
-            oss << "\"seq\":" << usage_chain[i].seq << ",";
-            oss << "\"time\":\"" << json_escape_tm(usage_chain[i].time) << "\",";
-            oss << "\"action\":\"" << json_escape_tm(usage_chain[i].action) << "\",";
-            oss << "\"params\":\"" << json_escape_tm(usage_chain[i].params) << "\",";
-            oss << "\"hash_prev\":\"" << json_escape_tm(usage_chain[i].hash_prev) << "\",";
-            oss << "\"signature\":\"" << json_escape_tm(usage_chain[i].signature) << "\"";
-            oss << "}";
+    if (!token.usage_chain.empty()) {
+        out.literal(",\"usage_chain\":[");
+        for (size_t i = 0; i < token.usage_chain.size(); ++i) {
+            const Token::UsageRecord& record = token.usage_chain[i];
+            out.literal(i > 0 ? ",{\"seq\":" : "{\"seq\":");
+            out.number(record.seq);
+            out.literal(",\"time\":\"");
+            out.escaped(record.time);
+            out.literal("\",\"action\":\"");
+            out.escaped(record.action);
+            out.literal("\",\"params\":\"");
+            out.escaped(record.params);
+            out.literal("\",\"hash_prev\":\"");
+            out.escaped(record.hash_prev);
+            out.literal("\",\"signature\":\"");
+            out.escaped(record.signature);
+            out.literal("\"}");
         }
-        oss << "]";
+        out.literal("]");
     }
-    
+
     // Add current signature if present
-    if (!current_signature.empty()) {
-        oss << ",\"current_signature\":\"" << json_escape_tm(current_signature) << "\"";
+    if (!token.current_signature.empty()) {
+        out.literal(",\"current_signature\":\"");
+        out.escaped(token.current_signature);
+        out.literal("\"");
     }
-    
-    oss << "}";
-    return oss.str();
+
+    out.literal("}");
 }
 
-Token Token::from_json(const std::string& json) {
-    Token token;
-    token.token_id = extract_json_string_tm(json, "token_id");
-    token.holder_device_id = extract_json_string_tm(json, "holder_device_id");
-    token.license_code = extract_json_string_tm(json, "license_code");
-    token.issue_time = extract_json_u64_tm(json, "issue_time");
-    token.expire_time = extract_json_u64_tm(json, "expire_time");
-    token.signature = extract_json_string_tm(json, "signature");
-    token.alg = extract_json_string_tm(json, "alg");
-    token.app_id = extract_json_string_tm(json, "app_id");
-    token.environment_hash = extract_json_string_tm(json, "environment_hash");
-    token.license_public_key = extract_json_string_tm(json, "license_public_key");
-    token.root_signature = extract_json_string_tm(json, "root_signature");
-    token.encrypted_license_private_key = extract_json_string_tm(json, "encrypted_license_private_key");
-    token.state_index = extract_json_u64_tm(json, "state_index");
-    token.prev_state_hash = extract_json_string_tm(json, "prev_state_hash");
-    token.state_payload = extract_json_string_tm(json, "state_payload");
-    token.state_signature = extract_json_string_tm(json, "state_signature");
-
-    const std::string dev_pat = "\"device_info\"";
-    size_t dev_pos = json.find(dev_pat);
-    if (dev_pos != std::string::npos) {
-        size_t obj_start = json.find('{', dev_pos);
-        size_t obj_end = json.find('}', obj_start);
-        if (obj_start != std::string::npos && obj_end != std::string::npos && obj_end > obj_start) {
-            std::string dev_obj = json.substr(obj_start, obj_end - obj_start + 1);
-            token.device_info.fingerprint = extract_json_string_tm(dev_obj, "fingerprint");
-            token.device_info.public_key = extract_json_string_tm(dev_obj, "public_key");
-            token.device_info.signature = extract_json_string_tm(dev_obj, "signature");
-        }
-    }
-    return token;
+size_t Token::json_size() const {
+    JsonSizeCounter counter;
+    write_token_json(*this, counter);
+    return counter.size();
 }
 
-// Signature verifier implementations
-bool RsaVerifier::verify(const Token& token, const std::string& public_key) const {
-    if (token.signature.empty()) {
-        return false;
-    }
-    
-    // Create signature data
-    std::string sig_data = TokenManager().create_signature_data(token);
-    
-    // Verify signature using CryptoUtils
-    try {
-        return CryptoUtils::verify_signature(sig_data, token.signature, public_key);
-    } catch (const std::exception& e) {
-        return false;
-    }
+size_t Token::write_json(char* out) const {
+    JsonBufferWriter writer(out);
+    write_token_json(*this, writer);
+    return writer.size();
 }
 
-bool Ed25519Verifier::verify(const Token& token, const std::string& public_key) const {
-    if (token.signature.empty()) {
-        return false;
-    }
-    
-    // Create signature data
-    std::string sig_data = TokenManager().create_signature_data(token);
-    
-    // Verify signature using CryptoUtils
-    try {
-        return CryptoUtils::verify_ed25519_signature(sig_data, token.signature, public_key);
-    } catch (const std::exception& e) {
-        return false;
-    }
+void Token::write_json(Hasher& hasher) const {
+    JsonHashWriter writer(hasher);
+    write_token_json(*this, writer);
+    writer.flush();
 }
 
-bool Sm2Verifier::verify(const Token& token, const std::string& public_key) const {
-    if (token.signature.empty()) {
-        return false;
+std::string Token::to_json() const {
+    std::string json(json_size(), '\0');
+    write_json(&json[0]);
+    return json;
+}
+
+std::string Token::json_sha256() const {
+    Hasher hasher(Hasher::Algorithm::SHA256);
+    write_json(hasher);
+    return Hasher::to_hex(hasher.finalize());
+}
+
+Token Token::from_json(const std::string& json) {
+    Token token;
+    if (!from_json(json, &token)) {
+        return Token{};
     }
-    
-    // Create signature data
-    std::string sig_data = TokenManager().create_signature_data(token);
-    
-    // Verify signature using CryptoUtils
-    try {
-        return CryptoUtils::verify_sm2_signature(sig_data, token.signature, public_key);
-    } catch (const std::exception& e) {
+    return token;
+}
+
+bool Token::from_json(std::string_view json, Token* token) {
+    TokenJsonView view;
+    if (!parse_token_json(json, view)) {
         return false;
     }
-}
 
-// TokenManager implementation
-TokenManager::TokenManager() 
-    : rsa_verifier_(std::make_shared<RsaVerifier>()),
-      ed25519_verifier_(std::make_shared<Ed25519Verifier>()),
-      sm2_verifier_(std::make_shared<Sm2Verifier>()) {
+    token->token_id = view.token_id.str();
+    token->holder_device_id = view.holder_device_id.str();
+    token->license_code = view.license_code.str();
+    token->issue_time = view.issue_time;
+    token->expire_time = view.expire_time;
+    token->signature = view.signature.str();
+    token->alg = parse_signing_algorithm(view.alg.str());
+    token->app_id = view.app_id.str();
+    token->environment_hash = view.environment_hash.str();
+    token->license_public_key = view.license_public_key.str();
+    token->root_signature = view.root_signature.str();
+    token->encrypted_license_private_key = view.encrypted_license_private_key.str();
+    token->state_index = view.state_index;
+    token->prev_state_hash = view.prev_state_hash.str();
+    token->state_payload = view.state_payload.str();
+    token->state_signature = view.state_signature.str();
+
+    token->device_info.fingerprint = view.device_info.fingerprint.str();
+    token->device_info.public_key = view.device_info.public_key.str();
+    token->device_info.signature = view.device_info.signature.str();
+
+    token->usage_chain.clear();
+    token->usage_chain.reserve(view.usage_chain.size());
+    for (const TokenJsonView::UsageRecord& record : view.usage_chain) {
+        token->usage_chain.push_back({record.seq, record.time.str(), record.action.str(),
+                                      record.params.str(), record.hash_prev.str(),
+                                      record.signature.str()});
+    }
+    token->current_signature = view.current_signature.str();
+    return true;
 }
 
+// TokenManager implementation
 Token TokenManager::generate_token(const std::string& holder_device_id,
                                    const std::string& license_code,
                                    int validity_hours,
@@ -316,34 +237,14 @@ Token TokenManager::generate_token(const std::string& holder_device_id,
         (now + std::chrono::hours(validity_hours)).time_since_epoch()).count();
     
     // Set algorithm
-    switch (algorithm) {
-        case SigningAlgorithm::RSA:
-            token.alg = "RSA";
-            break;
-        case SigningAlgorithm::Ed25519:
-            token.alg = "Ed25519";
-            break;
-        case SigningAlgorithm::SM2:
-            token.alg = "SM2";
-            break;
-    }
+    token.alg = algorithm;
     
     // Create signature data
     std::string sig_data = create_signature_data(token);
     
     // Sign the data using appropriate CryptoUtils function
     try {
-        switch (algorithm) {
-            case SigningAlgorithm::RSA:
-                token.signature = CryptoUtils::sign_data(sig_data, private_key);
-                break;
-            case SigningAlgorithm::Ed25519:
-                token.signature = CryptoUtils::sign_ed25519_data(sig_data, private_key);
-                break;
-            case SigningAlgorithm::SM2:
-                token.signature = CryptoUtils::sign_sm2_data(sig_data, private_key);
-                break;
-        }
+        token.signature = sign_field(algorithm, sig_data, private_key);
     } catch (const std::exception& e) {
         // Handle error appropriately
         token.signature = "";
@@ -352,12 +253,43 @@ Token TokenManager::generate_token(const std::string& holder_device_id,
     return token;
 }
 
+namespace {
+
+// Expiry timers re-check at least this often, so that changes of the wall
+// clock are picked up
+constexpr std::chrono::hours kMaxExpiryWait(24);
+
+// When is_expired() turns true for a token expiring at expire_time, capped
+// at kMaxExpiryWait. Computed in whole seconds: expire_time may lie far past
+// what a system_clock::time_point can hold (e.g. 9999-12-31 or UINT64_MAX).
+// The result is always at least a second ahead, so a timer never re-arms in
+// the past and spins.
+TimerScheduler::Clock::time_point expiry_due(uint64_t expire_time) {
+    const int64_t now_seconds = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    const uint64_t now = now_seconds > 0 ? static_cast<uint64_t>(now_seconds) : 0;
+    const uint64_t max_wait = std::chrono::seconds(kMaxExpiryWait).count();
+    uint64_t wait = 1;
+    if (expire_time >= now) {
+        wait = expire_time - now < max_wait ? expire_time - now + 1 : max_wait;
+    }
+    return TimerScheduler::Clock::now() + std::chrono::seconds(wait);
+}
+
+} // namespace
+
+TokenManager::~TokenManager() {
+    if (expiry_timer_ != 0) {
+        TimerScheduler::instance().cancel_and_wait(expiry_timer_);
+    }
+}
+
 bool TokenManager::set_token(const Token& token, const std::string& public_key) {
 #if DECENTRILICENSE_DEBUG
     std::cerr << "dl-core debug: set_token called, token.is_valid(): " << token.is_valid() << std::endl;
     std::cerr << "dl-core debug: token_id length: " << token.token_id.length() << std::endl;
     std::cerr << "dl-core debug: signature length: " << token.signature.length() << std::endl;
-    std::cerr << "dl-core debug: alg: '" << token.alg << "'" << std::endl;
+    std::cerr << "dl-core debug: alg: '" << (token.alg ? signing_algorithm_name(*token.alg) : "") << "'" << std::endl;
 #endif
     if (!token.is_valid()) {
 #if DECENTRILICENSE_DEBUG
@@ -372,12 +304,14 @@ bool TokenManager::set_token(const Token& token, const std::string& public_key)
     }
     
     std::lock_guard<std::mutex> lock(token_mutex_);
-    current_token_ = token;
+    current_token_.store(std::make_shared<const Token>(token));
+    license_state_.publish(true, token.expire_time);
     
     // Notify callback
     if (token.is_expired()) {
         notify_token_change(TokenStatus::EXPIRED);
     } else {
+        schedule_expiry_check(token.expire_time);
         notify_token_change(TokenStatus::ACTIVE);
     }
     
@@ -385,77 +319,104 @@ bool TokenManager::set_token(const Token& token, const std::string& public_key)
 }
 
 std::optional<Token> TokenManager::get_current_token() const {
-    std::lock_guard<std::mutex> lock(token_mutex_);
-    return current_token_;
+    return current_token_.read([](const std::shared_ptr<const Token>& token) -> std::optional<Token> {
+        if (!token) {
+            return std::nullopt;
+        }
+        return *token;
+    });
+}
+
+std::shared_ptr<const Token> TokenManager::get_current_token_snapshot() const {
+    return current_token_.load();
 }
 
 TokenStatus TokenManager::get_status() const {
-    std::lock_guard<std::mutex> lock(token_mutex_);
-    
-    if (!current_token_.has_value()) {
-        return TokenStatus::NONE;
-    }
-    
-    if (current_token_->is_expired()) {
-        return TokenStatus::EXPIRED;
-    }
-    
-    return TokenStatus::ACTIVE;
+    return current_token_.read([](const std::shared_ptr<const Token>& token) {
+        if (!token) {
+            return TokenStatus::NONE;
+        }
+        if (token->is_expired()) {
+            return TokenStatus::EXPIRED;
+        }
+        return TokenStatus::ACTIVE;
+    });
 }
 
 bool TokenManager::verify_token(const Token& token, const std::string& public_key) const {
-    // Check cache first
-    {
-        std::lock_guard<std::mutex> lock(cache_mutex_);
-        auto it = verification_cache_.find(token.token_id);
-        if (it != verification_cache_.end()) {
-            auto now = std::chrono::steady_clock::now();
-            if (it->second.second > now) {
-                // Cache hit and not expired
-                return it->second.first;
-            } else {
-                // Expired, remove from cache
-                verification_cache_.erase(it);
-            }
-        }
-    }
-    
-    // Get appropriate verifier
-    std::shared_ptr<SignatureVerifier> verifier;
-    if (token.alg == "RSA") {
-        verifier = rsa_verifier_;
-    } else if (token.alg == "Ed25519") {
-        verifier = ed25519_verifier_;
-    } else if (token.alg == "SM2") {
-        verifier = sm2_verifier_;
-    } else {
+    if (!token.alg || token.signature.empty()) {
         return false;
     }
+
+    // Check cache first
+    const std::string sig_data = create_signature_data(token);
+    const std::string cache_key = VerificationCache::make_key(
+        *token.alg, public_key, sig_data, token.signature);
+    if (auto cached = verification_cache_.lookup(cache_key)) {
+        return *cached;
+    }
     
     // Verify signature
-    bool result = verifier->verify(token, public_key);
+    bool result = false;
+    try {
+        result = verify_field(*token.alg, sig_data, token.signature, public_key);
+    } catch (const std::exception& e) {
+        result = false;
+    }
     
     // Cache result
-    {
-        std::lock_guard<std::mutex> lock(cache_mutex_);
-        auto ttl = calculate_cache_ttl(token.expire_time);
-        auto expiration = std::chrono::steady_clock::now() + std::chrono::seconds(ttl);
-        verification_cache_[token.token_id] = std::make_pair(result, expiration);
-    }
+    verification_cache_.store(cache_key, result,
+                              std::chrono::seconds(calculate_cache_ttl(token.expire_time)));
     
     return result;
 }
 
+VerificationCache::Stats TokenManager::verification_cache_stats() const {
+    return verification_cache_.stats();
+}
+
+VerificationBitmap TokenManager::verify_tokens(const std::vector<Token>& tokens, const std::string& public_key) const {
+    VerificationBitmap bitmap(tokens.size(), false);
+
+    // Signature data must outlive the checks that view it
+    std::vector<std::string> signature_data;
+    std::vector<size_t> positions;
+    signature_data.reserve(tokens.size());
+    positions.reserve(tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (tokens[i].signature.empty() || !tokens[i].alg) {
+            continue;
+        }
+        signature_data.push_back(create_signature_data(tokens[i]));
+        positions.push_back(i);
+    }
+
+    std::vector<SignatureCheck> checks;
+    checks.reserve(positions.size());
+    for (size_t j = 0; j < positions.size(); ++j) {
+        const Token& token = tokens[positions[j]];
+        checks.push_back(SignatureCheck{signature_data[j], token.signature, public_key,
+                                        *token.alg});
+    }
+
+    VerificationBitmap results = CryptoUtils::verify_batch(checks);
+    for (size_t j = 0; j < positions.size(); ++j) {
+        bitmap[positions[j]] = results[j];
+    }
+    return bitmap;
+}
+
 std::string TokenManager::request_transfer(const std::string& target_device_id) {
     std::lock_guard<std::mutex> lock(token_mutex_);
     
-    if (!current_token_.has_value()) {
+    if (!current_token_.load()) {
         return "";
     }
     
     // Mark token as transferred
     notify_token_change(TokenStatus::TRANSFERRED);
-    current_token_.reset();
+    current_token_.store(nullptr);
+    license_state_.publish(false, 0);
     
     // In a real implementation, this would create a transfer request
     // For now, we'll just return a placeholder
@@ -470,7 +431,8 @@ bool TokenManager::accept_transfer(const std::string& transfer_data, const std::
 
 void TokenManager::invalidate_token() {
     std::lock_guard<std::mutex> lock(token_mutex_);
-    current_token_.reset();
+    current_token_.store(nullptr);
+    license_state_.publish(false, 0);
     notify_token_change(TokenStatus::NONE);
 }
 
@@ -482,27 +444,39 @@ void TokenManager::set_token_callback(TokenChangeCallback callback) {
 void TokenManager::check_expiration() {
     std::lock_guard<std::mutex> lock(token_mutex_);
     
-    if (current_token_.has_value() && current_token_->is_expired()) {
+    if (get_status() == TokenStatus::EXPIRED) {
         notify_token_change(TokenStatus::EXPIRED);
     }
 }
 
-void TokenManager::set_public_key(SigningAlgorithm algorithm, const std::string& public_key) {
-    std::lock_guard<std::mutex> lock(keys_mutex_);
-    public_keys_[algorithm] = public_key;
+// One timer per manager, moved rather than replaced: a one-shot timer keeps
+// its id until its callback returns, so the destructor only ever has to
+// wait for expiry_timer_
+void TokenManager::schedule_expiry_check(uint64_t expire_time) {
+    TimerScheduler& scheduler = TimerScheduler::instance();
+    const TimerScheduler::Clock::time_point due = expiry_due(expire_time);
+    if (expiry_timer_ == 0 || !scheduler.reschedule(expiry_timer_, due)) {
+        expiry_timer_ = scheduler.schedule_at(due, [this]() { handle_expiry_timer(); });
+    }
 }
 
-std::shared_ptr<SignatureVerifier> TokenManager::get_verifier(SigningAlgorithm algorithm) const {
-    switch (algorithm) {
-        case SigningAlgorithm::RSA:
-            return rsa_verifier_;
-        case SigningAlgorithm::Ed25519:
-            return ed25519_verifier_;
-        case SigningAlgorithm::SM2:
-            return sm2_verifier_;
-        default:
-            return nullptr;
+void TokenManager::handle_expiry_timer() {
+    std::lock_guard<std::mutex> lock(token_mutex_);
+    std::shared_ptr<const Token> token = current_token_.load();
+    if (!token) {
+        return;     // Invalidated or transferred since the timer was armed
+    }
+    if (token->is_expired()) {
+        notify_token_change(TokenStatus::EXPIRED);
+        return;
     }
+    // Capped wait, or the wall clock was set back
+    TimerScheduler::instance().reschedule(expiry_timer_, expiry_due(token->expire_time));
+}
+
+void TokenManager::set_public_key(SigningAlgorithm algorithm, const std::string& public_key) {
+    std::lock_guard<std::mutex> lock(keys_mutex_);
+    public_keys_[algorithm] = public_key;
 }
 
 std::string TokenManager::generate_token_id() const {
@@ -546,7 +520,7 @@ std::string TokenManager::generate_token_id() const {
     return oss.str();
 }
 
-std::string TokenManager::create_signature_data(const Token& token) const {
+std::string TokenManager::create_signature_data(const Token& token) {
     std::ostringstream oss;
     // expire_time intentionally excluded from signature data to avoid expiry-related mismatches
     oss << token.token_id << "|"
@@ -557,7 +531,7 @@ std::string TokenManager::create_signature_data(const Token& token) const {
     return oss.str();
 }
 
-std::string TokenManager::create_state_signature_data(const Token& token) const {
+std::string TokenManager::create_state_signature_data(const Token& token) {
     std::ostringstream oss;
     oss << token.state_index << "|"
         << token.prev_state_hash << "|"
@@ -569,8 +543,7 @@ Token TokenManager::migrate_token_state(const Token& current_token, const std::s
     Token new_token = current_token;
     
     // Calculate current token hash as prev_state_hash
-    std::string current_token_json = current_token.to_json();
-    new_token.prev_state_hash = CryptoUtils::sha256(current_token_json);
+    new_token.prev_state_hash = current_token.json_sha256();
     
     // Increment state index
     new_token.state_index = current_token.state_index + 1;
@@ -583,12 +556,8 @@ Token TokenManager::migrate_token_state(const Token& current_token, const std::s
     
     // Sign the state signature data using the appropriate algorithm
     try {
-        if (new_token.alg == "RSA") {
-            new_token.state_signature = CryptoUtils::sign_data(state_sig_data, license_private_key);
-        } else if (new_token.alg == "Ed25519") {
-            new_token.state_signature = CryptoUtils::sign_ed25519_data(state_sig_data, license_private_key);
-        } else if (new_token.alg == "SM2") {
-            new_token.state_signature = CryptoUtils::sign_sm2_data(state_sig_data, license_private_key);
+        if (new_token.alg) {
+            new_token.state_signature = sign_field(*new_token.alg, state_sig_data, license_private_key);
         }
     } catch (const std::exception& e) {
         // Handle error appropriately
@@ -600,12 +569,8 @@ Token TokenManager::migrate_token_state(const Token& current_token, const std::s
     
     // Sign the data using appropriate CryptoUtils function
     try {
-        if (new_token.alg == "RSA") {
-            new_token.signature = CryptoUtils::sign_data(sig_data, license_private_key);
-        } else if (new_token.alg == "Ed25519") {
-            new_token.signature = CryptoUtils::sign_ed25519_data(sig_data, license_private_key);
-        } else if (new_token.alg == "SM2") {
-            new_token.signature = CryptoUtils::sign_sm2_data(sig_data, license_private_key);
+        if (new_token.alg) {
+            new_token.signature = sign_field(*new_token.alg, sig_data, license_private_key);
         }
     } catch (const std::exception& e) {
         // Handle error appropriately
@@ -622,12 +587,9 @@ bool TokenManager::verify_token_state_chain(const Token& current_token, const st
     // Verify state signature
     bool state_sig_valid = false;
     try {
-        if (current_token.alg == "RSA") {
-            state_sig_valid = CryptoUtils::verify_signature(state_sig_data, current_token.state_signature, current_token.license_public_key);
-        } else if (current_token.alg == "Ed25519") {
-            state_sig_valid = CryptoUtils::verify_ed25519_signature(state_sig_data, current_token.state_signature, current_token.license_public_key);
-        } else if (current_token.alg == "SM2") {
-            state_sig_valid = CryptoUtils::verify_sm2_signature(state_sig_data, current_token.state_signature, current_token.license_public_key);
+        if (current_token.alg) {
+            state_sig_valid = verify_field(*current_token.alg, state_sig_data, current_token.state_signature,
+                                           current_token.license_public_key);
         }
     } catch (const std::exception& e) {
         state_sig_valid = false;
@@ -648,10 +610,7 @@ bool TokenManager::verify_token_state_chain(const Token& current_token, const st
     }
     
     const Token& last_token = stored_chain.back();
-    std::string last_token_json = last_token.to_json();
-    std::string last_token_hash = CryptoUtils::sha256(last_token_json);
-    
-    if (current_token.prev_state_hash != last_token_hash) {
+    if (current_token.prev_state_hash != last_token.json_sha256()) {
         return false;
     }
     
@@ -689,81 +648,58 @@ int TokenManager::calculate_cache_ttl(uint64_t expire_time) const {
 void TokenManager::notify_token_change(TokenStatus status) {
     std::lock_guard<std::mutex> lock(callback_mutex_);
     if (token_callback_) {
-        token_callback_(status, current_token_);
+        std::shared_ptr<const Token> token = current_token_.load();
+        token_callback_(status, token ? std::optional<Token>(*token) : std::nullopt);
     }
 }
 
-bool TokenManager::verify_token_trust_chain(const Token& token) const {
+bool TokenManager::verify_token_trust_chain(const Token& token) {
 #if DECENTRILICENSE_DEBUG
     std::cerr << "TOKEN_MANAGER: verify_token_trust_chain called!" << std::endl;
 #endif
-    // Step 1: Verify the root signature of the license public key
-    try {
-        // Parse the hardcoded root public key
+    // Step 1: The root public key is parsed once per process by the trust
+    // anchor store; without a usable root anchor nothing can be trusted
+    const TrustAnchorStore::Snapshot& anchors = TrustAnchorStore::instance().snapshot();
+    if (!anchors.has(TrustAnchor::Kind::Root)) {
 #if DECENTRILICENSE_DEBUG
-        std::cerr << "dl-core debug: using hardcoded ROOT_PUBLIC_KEY, length: " << decentrilicense::ROOT_PUBLIC_KEY.length() << std::endl;
-        std::cerr << "dl-core debug: ROOT_PUBLIC_KEY starts with: " << decentrilicense::ROOT_PUBLIC_KEY.substr(0, 50) << "..." << std::endl;
+        std::cerr << "dl-core debug: no root trust anchor (failed to load ROOT_PUBLIC_KEY?)" << std::endl;
 #endif
+        return false;
+    }
 
-        BIO* bio = BIO_new_mem_buf(decentrilicense::ROOT_PUBLIC_KEY.c_str(), decentrilicense::ROOT_PUBLIC_KEY.length());
-        if (!bio) {
 #if DECENTRILICENSE_DEBUG
-            std::cerr << "dl-core debug: failed to create BIO" << std::endl;
-#endif
-            return false;
+    for (const TrustAnchor& anchor : anchors.anchors()) {
+        if (anchor.kind == TrustAnchor::Kind::Root) {
+            std::cerr << "dl-core debug: root key type: " << anchor.key.type()
+                      << " (expected: " << EVP_PKEY_RSA << ")" << std::endl;
         }
-        
-        EVP_PKEY* root_pkey = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
-        if (!root_pkey) {
-            unsigned long err = ERR_get_error();
-#if DECENTRILICENSE_DEBUG
-            std::cerr << "dl-core debug: failed to load root public key, OpenSSL error: " << ERR_reason_error_string(err) << std::endl;
-#endif
-            BIO_free(bio);
-            return false;
-        }
-
-        BIO_free(bio);
-#if DECENTRILICENSE_DEBUG
-        std::cerr << "dl-core debug: root public key loaded successfully" << std::endl;
+    }
+    std::vector<uint8_t> root_sig_bytes = CryptoUtils::base64_decode(token.root_signature);
+    std::cerr << "dl-core debug: root_signature length: " << token.root_signature.length() << std::endl;
+    std::cerr << "dl-core debug: decoded signature length: " << root_sig_bytes.size() << std::endl;
+    std::cerr << "dl-core debug: signature前16字节: ";
+    for(size_t i = 0; i < std::min<size_t>(16, root_sig_bytes.size()); i++) {
+        std::cerr << std::hex << std::setw(2) << std::setfill('0') << (int)root_sig_bytes[i] << " ";
+    }
+    std::cerr << std::dec << std::endl;
+#else
+    (void)token;
 #endif
 
-        // Check key type
-        int key_type = EVP_PKEY_get_id(root_pkey);
-#if DECENTRILICENSE_DEBUG
-        std::cerr << "dl-core debug: root key type: " << key_type << " (expected: " << EVP_PKEY_RSA << ")" << std::endl;
-#endif
-        
-        // Decode the root signature
-        std::vector<uint8_t> root_sig_bytes = CryptoUtils::base64_decode(token.root_signature);
-#if DECENTRILICENSE_DEBUG
-        std::cerr << "dl-core debug: root_signature length: " << token.root_signature.length() << std::endl;
-        std::cerr << "dl-core debug: decoded signature length: " << root_sig_bytes.size() << std::endl;
-        std::cerr << "dl-core debug: signature前16字节: ";
-        for(size_t i = 0; i < std::min<size_t>(16, root_sig_bytes.size()); i++) {
-            std::cerr << std::hex << std::setw(2) << std::setfill('0') << (int)root_sig_bytes[i] << " ";
-        }
-        std::cerr << std::dec << std::endl;
-#endif
-        
-        // ARCHITECTURE CHANGE: dl-core does NOT verify license_public_key directly.
-        // License public key verification is handled by SDK during activation.
-        // dl-core only verifies the product public key via shadow token mechanism in dl-issuer.
+    // ARCHITECTURE CHANGE: dl-core does NOT verify license_public_key directly.
+    // License public key verification is handled by SDK during activation.
+    // dl-core only verifies the product public key via shadow token mechanism in dl-issuer.
 #if DECENTRILICENSE_DEBUG
-        std::cerr << "dl-core debug: license_public_key verification delegated to SDK activation" << std::endl;
+    std::cerr << "dl-core debug: license_public_key verification delegated to SDK activation" << std::endl;
 #endif
 
-        // Skip the root signature verification in dl-core - this creates confusion
-        // The actual product key verification happens via shadow token in dl-issuer
+    // Skip the root signature verification in dl-core - this creates confusion
+    // The actual product key verification happens via shadow token in dl-issuer
 #if DECENTRILICENSE_DEBUG
-        std::cerr << "dl-core debug: root signature verification skipped - using shadow token approach only" << std::endl;
+    std::cerr << "dl-core debug: root signature verification skipped - using shadow token approach only" << std::endl;
 #endif
 
-        EVP_PKEY_free(root_pkey);
-        return true; // Success - no direct verification needed
-    } catch (const std::exception& e) {
-        return false;
-    }
+    return true; // Success - no direct verification needed
 }
 
 } // namespace decentrilicense
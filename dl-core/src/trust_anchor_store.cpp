@@ -0,0 +1,126 @@
+#include "decentrilicense/trust_anchor_store.hpp"
+#include "decentrilicense/root_key.hpp"
+#include "crypto_context.hpp"
+
+namespace decentrilicense {
+
+namespace {
+
+std::optional<SigningAlgorithm> algorithm_of(const KeyHandle& key) {
+    switch (key.type()) {
+        case EVP_PKEY_RSA:
+            return SigningAlgorithm::RSA;
+        case EVP_PKEY_ED25519:
+            return SigningAlgorithm::Ed25519;
+#ifdef EVP_PKEY_SM2
+        case EVP_PKEY_SM2:
+            return SigningAlgorithm::SM2;
+#endif
+        default:
+            return std::nullopt;
+    }
+}
+
+std::optional<TrustAnchor> parse_anchor(TrustAnchor::Kind kind, const std::string& public_key_pem) {
+    // Anchors outlive any client, so never parse them inside a client's
+    // private library context
+    ScopedCryptoContext default_context(nullptr);
+    KeyHandle key = KeyCache::instance().get_public_key(public_key_pem);
+    if (!key) {
+        return std::nullopt;
+    }
+    return TrustAnchor{kind, public_key_pem, key, algorithm_of(key)};
+}
+
+} // namespace
+
+bool TrustAnchorStore::Snapshot::has(TrustAnchor::Kind kind) const {
+    for (const TrustAnchor& anchor : anchors_) {
+        if (anchor.kind == kind) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const TrustAnchor* TrustAnchorStore::Snapshot::find(TrustAnchor::Kind kind,
+                                                    std::string_view public_key_pem) const {
+    for (const TrustAnchor& anchor : anchors_) {
+        if (anchor.kind == kind && anchor.public_key_pem == public_key_pem) {
+            return &anchor;
+        }
+    }
+    return nullptr;
+}
+
+bool TrustAnchorStore::Snapshot::verify(TrustAnchor::Kind kind, const uint8_t* data, size_t size,
+                                        const uint8_t* signature, size_t signature_size) const {
+    for (const TrustAnchor& anchor : anchors_) {
+        if (anchor.kind == kind && anchor.algorithm &&
+            CryptoUtils::verify(*anchor.algorithm, anchor.key, data, size, signature, signature_size)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TrustAnchorStore::TrustAnchorStore() : current_(nullptr) {
+    auto initial = std::make_unique<Snapshot>();
+    if (auto root = parse_anchor(TrustAnchor::Kind::Root, ROOT_PUBLIC_KEY)) {
+        initial->anchors_.push_back(std::move(*root));
+    }
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    publish_locked(std::move(initial));
+}
+
+TrustAnchorStore& TrustAnchorStore::instance() {
+    // Leaked on purpose: readers may hold snapshot references until exit
+    static TrustAnchorStore* store = new TrustAnchorStore();
+    return *store;
+}
+
+bool TrustAnchorStore::add(TrustAnchor::Kind kind, const std::string& public_key_pem) {
+    if (snapshot().find(kind, public_key_pem)) {
+        return true;
+    }
+
+    // Parse outside the lock
+    std::optional<TrustAnchor> anchor = parse_anchor(kind, public_key_pem);
+    if (!anchor) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const Snapshot& current = snapshot();
+    if (current.find(kind, public_key_pem)) {
+        return true;
+    }
+    auto next = std::make_unique<Snapshot>(current);
+    next->anchors_.push_back(std::move(*anchor));
+    publish_locked(std::move(next));
+    return true;
+}
+
+bool TrustAnchorStore::remove(TrustAnchor::Kind kind, const std::string& public_key_pem) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const Snapshot& current = snapshot();
+    if (!current.find(kind, public_key_pem)) {
+        return false;
+    }
+
+    auto next = std::make_unique<Snapshot>();
+    for (const TrustAnchor& anchor : current.anchors_) {
+        if (anchor.kind != kind || anchor.public_key_pem != public_key_pem) {
+            next->anchors_.push_back(anchor);
+        }
+    }
+    publish_locked(std::move(next));
+    return true;
+}
+
+void TrustAnchorStore::publish_locked(std::unique_ptr<Snapshot> next) {
+    current_.store(next.get(), std::memory_order_release);
+    published_.push_back(std::move(next));
+}
+
+} // namespace decentrilicense
@@ -0,0 +1,127 @@
+#include "decentrilicense/verification_cache.hpp"
+#include "decentrilicense/hasher.hpp"
+#include <cstring>
+
+namespace decentrilicense {
+
+namespace {
+
+constexpr size_t kDigestSize = Hasher::kDigestSize;
+
+void sha256_into(const std::string& data, char* out) {
+    const Hasher::Digest digest = Hasher::digest(Hasher::Algorithm::SHA256, data);
+    std::memcpy(out, digest.data(), digest.size());
+}
+
+} // namespace
+
+VerificationCache::VerificationCache(size_t capacity)
+    : capacity_(capacity),
+      shard_capacity_((capacity + kShardCount - 1) / kShardCount) {
+}
+
+std::string VerificationCache::make_key(SigningAlgorithm algorithm,
+                                        const std::string& public_key_pem,
+                                        const std::string& signed_data,
+                                        const std::string& signature) {
+    // [1-byte algorithm][32-byte SHA-256 of the key PEM][32-byte SHA-256 of the data][signature]
+    std::string key(1 + 2 * kDigestSize, '\0');
+    key[0] = static_cast<char>(algorithm);
+    sha256_into(public_key_pem, &key[1]);
+    sha256_into(signed_data, &key[1 + kDigestSize]);
+    key.append(signature);
+    return key;
+}
+
+VerificationCache::Shard& VerificationCache::shard_for(const std::string& key) {
+    // The data digest is uniformly distributed, use its first byte
+    const size_t pos = 1 + kDigestSize;
+    const unsigned char b = key.size() > pos ? static_cast<unsigned char>(key[pos]) : 0;
+    return shards_[b % kShardCount];
+}
+
+std::optional<bool> VerificationCache::lookup(const std::string& key) {
+    if (key.empty() || capacity_ == 0) {
+        return std::nullopt;
+    }
+
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        shard.misses++;
+        return std::nullopt;
+    }
+
+    if (it->second->expires <= std::chrono::steady_clock::now()) {
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+        shard.evictions++;
+        shard.misses++;
+        return std::nullopt;
+    }
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    shard.hits++;
+    return it->second->result;
+}
+
+void VerificationCache::store(const std::string& key, bool result, std::chrono::seconds ttl) {
+    if (key.empty() || capacity_ == 0) {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        it->second->result = result;
+        it->second->expires = now + ttl;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+
+    shard.lru.push_front(Entry{key, result, now + ttl});
+    shard.index[key] = shard.lru.begin();
+    trim_locked(shard, now);
+}
+
+void VerificationCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.evictions += shard.lru.size();
+        shard.lru.clear();
+        shard.index.clear();
+    }
+}
+
+VerificationCache::Stats VerificationCache::stats() const {
+    Stats s;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        s.hits += shard.hits;
+        s.misses += shard.misses;
+        s.evictions += shard.evictions;
+        s.size += shard.lru.size();
+    }
+    s.capacity = capacity_;
+    return s;
+}
+
+void VerificationCache::trim_locked(Shard& shard, std::chrono::steady_clock::time_point now) {
+    // Drop expired entries from the cold end first, then enforce the bound
+    while (!shard.lru.empty() && shard.lru.back().expires <= now) {
+        shard.index.erase(shard.lru.back().key);
+        shard.lru.pop_back();
+        shard.evictions++;
+    }
+    while (shard.lru.size() > shard_capacity_) {
+        shard.index.erase(shard.lru.back().key);
+        shard.lru.pop_back();
+        shard.evictions++;
+    }
+}
+
+} // namespace decentrilicense
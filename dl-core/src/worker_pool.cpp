@@ -0,0 +1,116 @@
+#include "decentrilicense/worker_pool.hpp"
+#include <algorithm>
+#include <atomic>
+
+namespace decentrilicense {
+
+WorkerPool::WorkerPool(size_t num_threads) {
+    if (num_threads == 0) {
+        unsigned int hw = std::thread::hardware_concurrency();
+        num_threads = hw > 1 ? hw - 1 : 0;
+    }
+
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers_.emplace_back([this]() { worker_loop(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+WorkerPool& WorkerPool::shared() {
+    static WorkerPool pool;
+    return pool;
+}
+
+void WorkerPool::worker_loop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (stopping_ && tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void WorkerPool::parallel_for(size_t count, size_t min_chunk,
+                              const std::function<void(size_t begin, size_t end)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    if (min_chunk == 0) {
+        min_chunk = 1;
+    }
+
+    // Aim for a few chunks per thread so uneven items still balance out
+    const size_t participants = workers_.size() + 1;
+    size_t chunk = std::max(min_chunk, (count + participants * 4 - 1) / (participants * 4));
+    const size_t num_chunks = (count + chunk - 1) / chunk;
+
+    if (num_chunks == 1 || workers_.empty()) {
+        fn(0, count);
+        return;
+    }
+
+    // Chunks are claimed through a shared counter; helpers that start after
+    // all chunks are taken simply return.
+    struct SharedState {
+        std::atomic<size_t> next_chunk{0};
+        std::atomic<size_t> done_chunks{0};
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+    };
+    auto state = std::make_shared<SharedState>();
+
+    auto run_chunks = [state, &fn, chunk, count, num_chunks]() {
+        size_t completed = 0;
+        while (true) {
+            size_t c = state->next_chunk.fetch_add(1);
+            if (c >= num_chunks) {
+                break;
+            }
+            size_t begin = c * chunk;
+            size_t end = std::min(count, begin + chunk);
+            fn(begin, end);
+            completed++;
+        }
+        if (completed > 0 &&
+            state->done_chunks.fetch_add(completed) + completed == num_chunks) {
+            std::lock_guard<std::mutex> lock(state->done_mutex);
+            state->done_cv.notify_all();
+        }
+    };
+
+    const size_t helpers = std::min(workers_.size(), num_chunks - 1);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < helpers; ++i) {
+            tasks_.emplace_back(run_chunks);
+        }
+    }
+    cv_.notify_all();
+
+    run_chunks();
+
+    std::unique_lock<std::mutex> lock(state->done_mutex);
+    state->done_cv.wait(lock, [&]() { return state->done_chunks.load() == num_chunks; });
+}
+
+} // namespace decentrilicense
@@ -37,6 +37,21 @@ typedef enum {
     DL_CONNECTION_MODE_OFFLINE = 2        // 离线模式
 } DL_ConnectionMode;
 
+// OpenSSL library context used by a client
+typedef enum {
+    DL_CRYPTO_CONTEXT_DEFAULT = 0,        // Process-wide default context
+    DL_CRYPTO_CONTEXT_SHARED = 1,         // One private context shared by all clients
+    DL_CRYPTO_CONTEXT_PER_CLIENT = 2      // A private context for each client
+} DL_CryptoContextMode;
+
+// How state chain records reach disk (see dl_client_set_durability)
+typedef enum {
+    DL_DURABILITY_NONE = 0,               // Buffered in the process; lost if it crashes
+    DL_DURABILITY_OS_BUFFERED = 1,        // Handed to the OS per record (default); lost on power failure
+    DL_DURABILITY_SYNC = 2,               // Flushed to disk per record
+    DL_DURABILITY_GROUP_COMMIT = 3        // Concurrent records share one flush to disk
+} DL_Durability;
+
 // Client configuration
 typedef struct {
     const char* license_code;             // License identifier for P2P conflict detection
@@ -94,6 +109,10 @@ DL_Client* dl_client_create(void);
 // Destroy a client
 void dl_client_destroy(DL_Client* client);
 
+// Select the OpenSSL library context; call before dl_client_initialize
+// (the default is DL_CRYPTO_CONTEXT_DEFAULT)
+DL_ErrorCode dl_client_set_crypto_context_mode(DL_Client* client, DL_CryptoContextMode mode);
+
 // Initialize the client
 DL_ErrorCode dl_client_initialize(DL_Client* client, const DL_ClientConfig* config);
 
@@ -101,8 +120,17 @@ DL_ErrorCode dl_client_set_product_public_key(DL_Client* client, const char* pro
 
 DL_ErrorCode dl_client_import_token(DL_Client* client, const char* token_input);
 
+// Import a token in the binary v2 encoding (see dl_client_get_current_token_binary)
+DL_ErrorCode dl_client_import_token_binary(DL_Client* client, const uint8_t* data, size_t size);
+
 DL_ErrorCode dl_client_get_current_token_json(DL_Client* client, char* out_json, size_t out_json_size);
 
+// Get the current token in the compact binary v2 encoding
+// *size holds the buffer size on input and the encoded size on output; if the
+// buffer is too small (or out is NULL) nothing is written and
+// DL_ERROR_INVALID_ARGUMENT is returned with the required size in *size
+DL_ErrorCode dl_client_get_current_token_binary(DL_Client* client, uint8_t* out, size_t* size);
+
 DL_ErrorCode dl_client_export_current_token_encrypted(DL_Client* client, char* out_encrypted, size_t out_encrypted_size);
 
 DL_ErrorCode dl_client_export_activated_token_encrypted(DL_Client* client, char* out_encrypted, size_t out_encrypted_size);
@@ -129,6 +157,21 @@ DL_ErrorCode dl_client_get_current_token(DL_Client* client, DL_Token* token);
 // Check if license is activated
 int dl_client_is_activated(DL_Client* client);
 
+// Hot-path license check: 1 if an activated token is held and not expired
+// Lock-free and allocation-free; safe to call per request from any thread.
+// Reflects activation in this process only: call dl_client_is_activated
+// once after startup to pick up an activation stored by an earlier run.
+int dl_client_is_licensed(DL_Client* client);
+
+// Set how state chain records reach disk; applies to later records
+// With DL_DURABILITY_GROUP_COMMIT a record is flushed once group_commit_records
+// records are waiting (0 = default 64) or the oldest has waited
+// group_commit_delay_ms; with a delay of 0 only records appended during a
+// flush are batched. DL_DURABILITY_SYNC and DL_DURABILITY_GROUP_COMMIT also
+// flush the chain's other files and directory entries.
+DL_ErrorCode dl_client_set_durability(DL_Client* client, DL_Durability durability,
+                                      uint32_t group_commit_records, uint32_t group_commit_delay_ms);
+
 // Get device ID
 DL_ErrorCode dl_client_get_device_id(DL_Client* client, char* device_id, size_t device_id_size);
 